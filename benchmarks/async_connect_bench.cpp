@@ -0,0 +1,459 @@
+#include <sys/socket.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <zlib.h>
+
+#include "async_operations.hpp"
+#include "benchmark.hpp"
+#include "epoll.hpp"
+#include "http_message.hpp"
+#include "rates_parser.hpp"
+#include "service_function.hpp"
+#include "tracing.hpp"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    std::string gzipText(const std::string &text)
+    {
+        z_stream stream{};
+        deflateInit2(&stream, Z_DEFAULT_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+        std::string output(deflateBound(&stream, text.size()), '\0');
+        stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+        stream.avail_in = static_cast<uInt>(text.size());
+        stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+        stream.avail_out = static_cast<uInt>(output.size());
+        deflate(&stream, Z_FINISH);
+        output.resize(stream.total_out);
+        deflateEnd(&stream);
+        return output;
+    }
+
+    std::pair<int, int> socketPair()
+    {
+        int descriptors[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, descriptors) != 0)
+        {
+            std::perror("socketpair");
+            std::exit(1);
+        }
+        return {descriptors[0], descriptors[1]};
+    }
+
+    // Posts from the thread that then drains the queue with run(). With SingleThreaded the posts take no lock and
+    // write no wakeup byte, and the work count is a plain integer.
+    template <typename ThreadingPolicy>
+    void postThroughput(JsonReport &report, const std::string &name)
+    {
+        constexpr std::size_t POSTS = 10'000;
+        BasicIOContext<ThreadingPolicy> context;
+        std::size_t executed = 0;
+
+        const auto round = runBenchmark(name, 20, [&](std::size_t)
+                                        {
+            for (std::size_t idx = 0; idx < POSTS; ++idx)
+                context.post([&executed]
+                             { ++executed; });
+            context.run(); }, std::cerr);
+
+        report.add(name, {{"posts", static_cast<double>(round.iterations * POSTS)},
+                          {"ns_per_post", round.nanosecondsPerOperation / POSTS},
+                          {"posts_per_second", round.operationsPerSecond * POSTS}});
+    }
+
+    // Posts from a foreign thread into a reactor that is already waiting, so every post pays for the wakeup.
+    void crossThreadPostThroughput(JsonReport &report)
+    {
+        constexpr std::size_t POSTS = 100'000;
+        IOContext context;
+        context.inc_work();
+        std::thread reactor([&]
+                            { context.run(); });
+
+        std::atomic<std::size_t> executed{0};
+        const auto start = clock_type::now();
+        for (std::size_t idx = 0; idx < POSTS; ++idx)
+            context.post([&executed]
+                         { executed.fetch_add(1, std::memory_order_relaxed); });
+        while (executed.load(std::memory_order_relaxed) < POSTS)
+            std::this_thread::yield();
+        const auto elapsed = std::chrono::duration<double, std::nano>(clock_type::now() - start).count();
+
+        context.dec_work();
+        reactor.join();
+
+        std::cerr << "io_context/post_cross_thread: " << elapsed / POSTS << " ns/post\n";
+        report.add("io_context/post_cross_thread", {{"posts", static_cast<double>(POSTS)},
+                                                    {"ns_per_post", elapsed / POSTS},
+                                                    {"posts_per_second", POSTS * 1e9 / elapsed}});
+    }
+
+    // One task in flight at a time: the time from post() to the first instruction of the task on the reactor.
+    void postLatency(JsonReport &report)
+    {
+        constexpr std::size_t SAMPLES = 20'000;
+        IOContext context;
+        context.inc_work();
+        std::thread reactor([&]
+                            { context.run(); });
+
+        std::vector<double> latencies;
+        latencies.reserve(SAMPLES);
+        std::atomic<bool> done{false};
+        for (std::size_t idx = 0; idx < SAMPLES; ++idx)
+        {
+            double latency = 0.0;
+            done.store(false, std::memory_order_relaxed);
+            const auto posted = clock_type::now();
+            context.post([&, posted]
+                         {
+                latency = std::chrono::duration<double, std::nano>(clock_type::now() - posted).count();
+                done.store(true, std::memory_order_release); });
+            while (!done.load(std::memory_order_acquire))
+                std::this_thread::yield();
+            latencies.push_back(latency);
+        }
+
+        context.dec_work();
+        reactor.join();
+
+        const auto p50 = percentile(latencies, 0.50);
+        const auto p99 = percentile(latencies, 0.99);
+        const auto p999 = percentile(latencies, 0.999);
+        std::cerr << "io_context/post_to_execute: p50 " << p50 << " ns, p99 " << p99 << " ns, p99.9 " << p999 << " ns\n";
+        report.add("io_context/post_to_execute_latency", {{"samples", static_cast<double>(SAMPLES)},
+                                                          {"p50_ns", p50},
+                                                          {"p99_ns", p99},
+                                                          {"p999_ns", p999}});
+    }
+
+    // register_operations, epoll_wait, handle_event and the read itself for a byte that is already waiting.
+    template <typename ThreadingPolicy>
+    void readRoundTrip(JsonReport &report, const std::string &name)
+    {
+        BasicIOContext<ThreadingPolicy> context;
+        const auto [local, remote] = socketPair();
+        BasicTCPAsyncSocket<ThreadingPolicy> socket(context, local);
+        std::vector<char> buffer(1);
+        std::size_t received = 0;
+
+        const auto result = runBenchmark(name, 20'000, [&](std::size_t)
+                                         {
+            const char byte = 'x';
+            if (write(remote, &byte, 1) != 1)
+                std::exit(1);
+            socket.async_read(buffer, [&received](const std::error_code &error, size_t bytes)
+                              {
+                if (!error)
+                    received += bytes; });
+            context.run(); }, std::cerr);
+
+        close(remote);
+        report.add(result);
+    }
+
+    // A 128 KiB message that is already waiting: async_read calls with a fixed 4 KiB buffer (one handler each) against
+    // one async_read_chain, which drains it into growing pooled blocks and calls the handler once.
+    void readChain(JsonReport &report)
+    {
+        constexpr std::size_t MESSAGE = 128 * 1024;
+        IOContext context;
+        const auto [local, remote] = socketPair();
+        TCPAsyncSocket socket(context, local);
+        const std::vector<char> message(MESSAGE, 'x');
+        std::vector<char> buffer(4 * 1024);
+        std::size_t messages = 0;
+        std::size_t handlers = 0;
+
+        const auto send = [remote = remote, &message, &messages]
+        {
+            ++messages;
+            if (write(remote, message.data(), message.size()) != static_cast<ssize_t>(message.size()))
+                std::exit(1);
+        };
+
+        const auto fixed = runBenchmark("io_context/read_fixed_buffer_128k", 2'000, [&](std::size_t)
+                                        {
+            send();
+            for (std::size_t total = 0; total < MESSAGE;)
+            {
+                socket.async_read(buffer, [&](const std::error_code &, size_t bytes)
+                                  {
+                    total += bytes;
+                    ++handlers; });
+                context.run();
+            } }, std::cerr);
+        const auto fixedHandlers = static_cast<double>(handlers) / messages;
+
+        messages = 0;
+        handlers = 0;
+        const auto chained = runBenchmark("io_context/read_chain_128k", 2'000, [&](std::size_t)
+                                          {
+            send();
+            for (std::size_t total = 0; total < MESSAGE;)
+            {
+                socket.async_read_chain([&](const std::error_code &, BufferChain chain)
+                                        {
+                    total += chain.size();
+                    ++handlers; });
+                context.run();
+            } }, std::cerr);
+        const auto chainHandlers = static_cast<double>(handlers) / messages;
+
+        close(remote);
+        report.add(fixed.name, {{"iterations", static_cast<double>(fixed.iterations)},
+                                {"ns_per_message", fixed.nanosecondsPerOperation},
+                                {"handlers_per_message", fixedHandlers}});
+        report.add(chained.name, {{"iterations", static_cast<double>(chained.iterations)},
+                                  {"ns_per_message", chained.nanosecondsPerOperation},
+                                  {"handlers_per_message", chainHandlers}});
+    }
+
+    // 64 responses of 512 B to a reader that is slower than the writer (4 KiB send buffer): async_write one at a time,
+    // each waiting for the previous one, against async_send, which queues them and flushes the queue with one
+    // gathering write per writability event.
+    void sendQueue(JsonReport &report)
+    {
+        constexpr std::size_t MESSAGES = 64;
+        constexpr std::size_t MESSAGE_SIZE = 512;
+        IOContext context;
+        const auto [local, remote] = socketPair();
+        const int sendBuffer = 4096;
+        setsockopt(local, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer));
+        TCPAsyncSocket sender(context, local);
+        TCPAsyncSocket receiver(context, remote);
+        const std::vector<char> message(MESSAGE_SIZE, 'x');
+
+        std::vector<char> readBuffer(64 * 1024);
+        std::size_t received = 0;
+        std::function<void()> read = [&]
+        {
+            receiver.async_read(readBuffer, [&](const std::error_code &error, size_t bytes)
+                                {
+                received += bytes;
+                if (!error && received < MESSAGES * MESSAGE_SIZE)
+                    read(); });
+        };
+
+        std::vector<char> writeBuffer;
+        std::size_t sent = 0;
+        std::function<void()> writeNext = [&]
+        {
+            if (writeBuffer.empty())
+            {
+                if (sent == MESSAGES)
+                    return;
+                writeBuffer = message;
+                ++sent;
+            }
+            sender.async_write(writeBuffer, [&](const std::error_code &error, size_t bytes)
+                               {
+                if (error)
+                    return;
+                writeBuffer.erase(writeBuffer.begin(), writeBuffer.begin() + bytes);
+                writeNext(); });
+        };
+
+        const auto serialized = runBenchmark("io_context/write_serialized_64x512", 2'000, [&](std::size_t)
+                                             {
+            received = 0;
+            sent = 0;
+            writeNext();
+            read();
+            context.run(); }, std::cerr);
+
+        const auto queued = runBenchmark("io_context/send_queue_64x512", 2'000, [&](std::size_t)
+                                         {
+            received = 0;
+            for (std::size_t idx = 0; idx < MESSAGES; ++idx)
+                sender.async_send(message);
+            read();
+            context.run(); }, std::cerr);
+
+        for (const auto &result : {serialized, queued})
+        {
+            report.add(result.name, {{"iterations", static_cast<double>(result.iterations)},
+                                     {"ns_per_batch", result.nanosecondsPerOperation},
+                                     {"ns_per_message", result.nanosecondsPerOperation / MESSAGES}});
+        }
+    }
+
+    // Level-triggered descriptors stay ready, so every wait returns the full batch.
+    void epollWaitBatch(JsonReport &report)
+    {
+        for (const int batch : {1, 16, 64, 256})
+        {
+            Epoll epoll(batch);
+            std::vector<std::pair<int, int>> pairs;
+            for (int idx = 0; idx < batch; ++idx)
+            {
+                pairs.push_back(socketPair());
+                const char byte = 'x';
+                if (write(pairs.back().second, &byte, 1) != 1 || epoll.add(pairs.back().first, EPOLLIN) != EpollStatus::ES_SUCCESS)
+                    std::exit(1);
+            }
+
+            std::vector<epoll_event> events(batch);
+            std::size_t delivered = 0;
+            const auto result = runBenchmark("epoll/wait_batch_" + std::to_string(batch), 50'000, [&](std::size_t)
+                                             {
+                int count = 0;
+                epoll.wait(0, events.data(), batch, count);
+                for (int idx = 0; idx < count; ++idx)
+                    delivered += events[idx].events & EPOLLIN;
+                doNotOptimize(delivered); }, std::cerr);
+
+            report.add(result.name, {{"iterations", static_cast<double>(result.iterations)},
+                                     {"events_per_wait", static_cast<double>(batch)},
+                                     {"ns_per_wait", result.nanosecondsPerOperation},
+                                     {"ns_per_event", result.nanosecondsPerOperation / batch}});
+
+            for (const auto &[local, remote] : pairs)
+            {
+                close(local);
+                close(remote);
+            }
+        }
+    }
+
+    void addThroughput(JsonReport &report, const BenchmarkResult &result, std::size_t bytes)
+    {
+        report.add(result.name, {{"iterations", static_cast<double>(result.iterations)},
+                                 {"ns_per_op", result.nanosecondsPerOperation},
+                                 {"bytes_per_op", static_cast<double>(bytes)},
+                                 {"megabytes_per_second", bytes * result.operationsPerSecond / 1e6}});
+    }
+
+    // HTTP framing, gzip inflate and the ValCurs parse on the daily document.
+    void parseThroughput(JsonReport &report)
+    {
+        const auto document = cbrDailyDocument();
+
+        const auto parse = runBenchmark("parse/daily_rates", 20'000, [&](std::size_t)
+                                        { doNotOptimize(parseDailyRates(document).size()); }, std::cerr);
+        addThroughput(report, parse, document.size());
+
+        const auto plain = "HTTP/1.1 200 OK\r\nContent-Type: application/xml; charset=windows-1251\r\nContent-Length: " +
+                           std::to_string(document.size()) + "\r\n\r\n" + document;
+        const auto compressed = gzipText(document);
+        char chunkSize[32];
+        std::snprintf(chunkSize, sizeof(chunkSize), "%zx", compressed.size());
+        const auto gzipped = std::string("HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n") + chunkSize +
+                             "\r\n" + compressed + "\r\n0\r\n\r\n";
+
+        for (const auto &[name, response] : {std::pair<std::string, const std::string *>("http/parse_content_length", &plain),
+                                             std::pair<std::string, const std::string *>("http/parse_chunked_gzip", &gzipped)})
+        {
+            std::string body;
+            body.reserve(document.size());
+            const auto result = runBenchmark(name, 20'000, [&](std::size_t)
+                                             {
+                body.clear();
+                HttpResponseParser parser;
+                parser.set_body_handler([&body](const char *data, std::size_t size)
+                                        { body.append(data, size); });
+                // Socket-sized pieces, as the client receives them.
+                for (std::size_t offset = 0; offset < response->size(); offset += 4096)
+                    parser.feed(response->data() + offset, std::min<std::size_t>(4096, response->size() - offset));
+                if (parser.status() != HttpParseStatus::HP_COMPLETE || body.size() != document.size())
+                    std::exit(1); }, std::cerr);
+            addThroughput(report, result, response->size());
+        }
+    }
+
+    // The windows-1251 to UTF-8 conversion AsyncConnect runs on every currency name of the daily table before printing
+    // it. One iteration converts the names of a daily document, real ones in their windows-1251 bytes.
+    void transcodeThroughput(JsonReport &report)
+    {
+        static const char *const NAMES[] = {"\xC4\xEE\xEB\xEB\xE0\xF0\x20\xD1\xD8\xC0",
+                                            "\xC5\xE2\xF0\xEE",
+                                            "\xD4\xF3\xED\xF2\x20\xF1\xF2\xE5\xF0\xEB\xE8\xED\xE3\xEE\xE2\x20\xD1\xEE\xE5\xE4\xE8\xED\xE5\xED\xED\xEE\xE3\xEE\x20\xEA\xEE\xF0\xEE\xEB\xE5\xE2\xF1\xF2\xE2\xE0",
+                                            "\xCA\xE8\xF2\xE0\xE9\xF1\xEA\xE8\xE9\x20\xFE\xE0\xED\xFC",
+                                            "\xDF\xEF\xEE\xED\xF1\xEA\xE8\xF5\x20\xE8\xE5\xED"};
+
+        const auto table = parseDailyRates(cbrDailyDocument());
+        std::vector<std::string> names;
+        std::size_t bytes = 0;
+        for (std::size_t idx = 0; idx < table.size(); ++idx)
+        {
+            names.emplace_back(NAMES[idx % std::size(NAMES)]);
+            bytes += names.back().size();
+        }
+
+        const auto result = runBenchmark("transcode/win1251_to_utf8_daily_names", 5'000, [&](std::size_t)
+                                         {
+            for (const auto &name : names)
+                doNotOptimize(win1251_to_utf8_impl(name).size()); }, std::cerr);
+        addThroughput(report, result, bytes);
+    }
+
+    // Cost of one span: into fresh buffer memory, into buffers reused after clear() (the steady state of a tracer that
+    // is written out and cleared periodically), and with the tracer disabled.
+    void traceSpan(JsonReport &report)
+    {
+        // Stays below the per-thread capacity, so no event is dropped.
+        constexpr std::size_t SPANS = 500'000;
+        const auto spans = [](Tracer &tracer, const std::string &name)
+        {
+            return runBenchmark(name, SPANS, [&](std::size_t idx)
+                                { const TraceSpan span(tracer, "bench", "span", idx); }, std::cerr);
+        };
+
+        Tracer tracer;
+        report.add(spans(tracer, "trace/span_first_touch"));
+        tracer.clear();
+        report.add(spans(tracer, "trace/span_enabled"));
+        if (tracer.dropped() != 0)
+            std::exit(1);
+
+        tracer.set_enabled(false);
+        report.add(spans(tracer, "trace/span_disabled"));
+    }
+}
+
+// Usage: AsyncConnectBench [output.json]
+// Human-readable lines go to stderr, the JSON report to the file (async_connect_bench.json by default).
+int main(int argc, char **argv)
+{
+    const std::string output = argc > 1 ? argv[1] : "async_connect_bench.json";
+
+#ifdef __OPTIMIZE__
+    const double optimized = 1.0;
+#else
+    const double optimized = 0.0;
+    std::cerr << "warning: built without optimization, configure with -DCMAKE_BUILD_TYPE=Release for comparable numbers\n";
+#endif
+
+    JsonReport report;
+    postThroughput<MultiThreaded>(report, "io_context/post_throughput");
+    postThroughput<SingleThreaded>(report, "io_context/post_throughput_single_threaded");
+    crossThreadPostThroughput(report);
+    postLatency(report);
+    readRoundTrip<MultiThreaded>(report, "io_context/register_handle_read");
+    readRoundTrip<SingleThreaded>(report, "io_context/register_handle_read_single_threaded");
+    readChain(report);
+    sendQueue(report);
+    epollWaitBatch(report);
+    parseThroughput(report);
+    transcodeThroughput(report);
+    traceSpan(report);
+
+    std::ofstream stream(output);
+    report.write(stream, {{"optimized", optimized}, {"hardware_threads", static_cast<double>(std::thread::hardware_concurrency())}});
+    if (!stream)
+    {
+        std::cerr << "cannot write " << output << "\n";
+        return 1;
+    }
+    std::cerr << "report written to " << output << "\n";
+    return 0;
+}
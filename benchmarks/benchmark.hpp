@@ -0,0 +1,121 @@
+#pragma once
+
+#include <chrono>
+#include <string>
+#include <iostream>
+#include <ostream>
+#include <vector>
+#include <utility>
+#include <algorithm>
+#include <cstddef>
+
+struct BenchmarkResult
+{
+    std::string name;
+    std::size_t iterations;
+    double nanosecondsPerOperation;
+    double operationsPerSecond;
+};
+
+template <typename ValueType>
+inline void doNotOptimize(const ValueType &value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+template <typename Function>
+BenchmarkResult runBenchmark(const std::string &name, std::size_t iterations, Function &&function, std::ostream &log = std::cout)
+{
+    for (std::size_t idx = 0; idx < iterations / 10 + 1; ++idx)
+    {
+        function(idx);
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    for (std::size_t idx = 0; idx < iterations; ++idx)
+    {
+        function(idx);
+    }
+    const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+
+    BenchmarkResult result{name, iterations, elapsed / iterations, iterations * 1e9 / elapsed};
+    log << result.name << ": " << result.nanosecondsPerOperation << " ns/op, "
+              << result.operationsPerSecond << " ops/s (" << result.iterations << " iterations)\n";
+    return result;
+}
+
+// Same shape as XML_daily.asp: the currencies cbr.ru publishes, windows-1251 prolog, comma decimals.
+inline std::string cbrDailyDocument()
+{
+    static const char *const CODES[] = {"AUD", "AZN", "GBP", "AMD", "BYN", "BGN", "BRL", "HUF", "VND", "HKD", "GEL",
+                                        "DKK", "AED", "USD", "EUR", "EGP", "INR", "IDR", "KZT", "CAD", "QAR", "KGS",
+                                        "CNY", "MDL", "NZD", "NOK", "PLN", "RON", "XDR", "SGD", "TJS", "THB", "TRY",
+                                        "TMT", "UZS", "UAH", "CZK", "SEK", "CHF", "RSD", "ZAR", "KRW", "JPY"};
+
+    std::string document = "<?xml version=\"1.0\" encoding=\"windows-1251\"?><ValCurs Date=\"06.11.2025\" name=\"Foreign Currency Market\">";
+    int index = 0;
+    for (const auto code : CODES)
+    {
+        const auto nominal = index % 4 == 0 ? 100 : 1;
+        document += "<Valute ID=\"R01" + std::to_string(100 + index) + "\"><NumCode>" + std::to_string(36 + index * 17) +
+                    "</NumCode><CharCode>" + code + "</CharCode><Nominal>" + std::to_string(nominal) + "</Nominal><Name>" +
+                    code + "</Name><Value>" + std::to_string(10 + index) + ",4567</Value><VunitRate>" +
+                    std::to_string(10 + index) + ",4567</VunitRate></Valute>";
+        ++index;
+    }
+    return document + "</ValCurs>";
+}
+
+// Sorts part of the samples; fraction is in [0, 1].
+inline double percentile(std::vector<double> &values, double fraction)
+{
+    if (values.empty())
+        return 0.0;
+    const auto position = static_cast<std::size_t>(fraction * (values.size() - 1));
+    std::nth_element(values.begin(), values.begin() + position, values.end());
+    return values[position];
+}
+
+// Machine-readable results: one object per benchmark with its name and numeric fields.
+class JsonReport
+{
+public:
+    using fields_type = std::vector<std::pair<std::string, double>>;
+
+    void add(const std::string &name, fields_type fields)
+    {
+        entries.emplace_back(name, std::move(fields));
+    }
+
+    void add(const BenchmarkResult &result)
+    {
+        add(result.name, {{"iterations", static_cast<double>(result.iterations)},
+                          {"ns_per_op", result.nanosecondsPerOperation},
+                          {"ops_per_second", result.operationsPerSecond}});
+    }
+
+    void write(std::ostream &stream, const fields_type &context = {}) const
+    {
+        stream << "{\n  \"context\": {";
+        writeFields(stream, context);
+        stream << "},\n  \"benchmarks\": [";
+        for (std::size_t idx = 0; idx < entries.size(); ++idx)
+        {
+            stream << (idx == 0 ? "\n" : ",\n") << "    {\"name\": \"" << entries[idx].first << "\", ";
+            writeFields(stream, entries[idx].second);
+            stream << "}";
+        }
+        stream << "\n  ]\n}\n";
+    }
+
+private:
+    std::vector<std::pair<std::string, fields_type>> entries;
+
+    static void writeFields(std::ostream &stream, const fields_type &fields)
+    {
+        for (std::size_t idx = 0; idx < fields.size(); ++idx)
+        {
+            stream << (idx == 0 ? "" : ", ") << "\"" << fields[idx].first << "\": " << fields[idx].second;
+        }
+    }
+};
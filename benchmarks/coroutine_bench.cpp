@@ -0,0 +1,211 @@
+#include <sys/socket.h>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#include "coroutine.hpp"
+
+// Every allocating form of the global operators is replaced, so all of them are counted and every pointer goes back
+// to the function that allocated it. The operators are kept out of line: inlined into a caller, GCC would see free()
+// on a pointer from operator new and warn about a mismatched pair.
+namespace
+{
+    std::atomic<std::size_t> heapAllocations{0};
+
+    void *countedAllocate(std::size_t size, std::size_t alignment)
+    {
+        heapAllocations.fetch_add(1, std::memory_order_relaxed);
+        size = size == 0 ? 1 : size;
+        void *pointer = alignment <= alignof(std::max_align_t) ? std::malloc(size) : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        if (pointer == nullptr)
+            throw std::bad_alloc();
+        return pointer;
+    }
+}
+
+[[gnu::noinline]] void *operator new(std::size_t size)
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+[[gnu::noinline]] void *operator new[](std::size_t size)
+{
+    return countedAllocate(size, alignof(std::max_align_t));
+}
+
+[[gnu::noinline]] void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+[[gnu::noinline]] void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    return countedAllocate(size, static_cast<std::size_t>(alignment));
+}
+
+[[gnu::noinline]] void operator delete(void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete[](void *pointer) noexcept
+{
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete[](void *pointer, std::size_t) noexcept
+{
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+[[gnu::noinline]] void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace
+{
+    constexpr std::size_t MESSAGE_SIZE = 64;
+
+    struct SocketPair
+    {
+        std::unique_ptr<TCPAsyncSocket> first;
+        std::unique_ptr<TCPAsyncSocket> second;
+    };
+
+    SocketPair makeSocketPair(IOContext &context)
+    {
+        int descriptors[2];
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, descriptors) != 0)
+            throw std::runtime_error("socketpair failed");
+        return SocketPair{std::make_unique<TCPAsyncSocket>(context, descriptors[0]), std::make_unique<TCPAsyncSocket>(context, descriptors[1])};
+    }
+
+    // Sends a message and waits for the echo, count times. Both directions carry whole messages on a socketpair.
+    struct CallbackPinger
+    {
+        TCPAsyncSocket &socket;
+        std::size_t remaining;
+        std::vector<char> buffer = std::vector<char>(MESSAGE_SIZE, 'x');
+
+        void ping()
+        {
+            if (remaining-- == 0)
+                return;
+            socket.async_write(buffer, [this](const std::error_code &error, size_t)
+                               {
+                if (error)
+                    return;
+                socket.async_read(buffer, [this](const std::error_code &error, size_t)
+                                  {
+                    if (!error)
+                        ping(); }); });
+        }
+    };
+
+    struct CallbackEchoer
+    {
+        TCPAsyncSocket &socket;
+        std::size_t remaining;
+        std::vector<char> buffer = std::vector<char>(MESSAGE_SIZE);
+
+        void echo()
+        {
+            if (remaining-- == 0)
+                return;
+            socket.async_read(buffer, [this](const std::error_code &error, size_t)
+                              {
+                if (error)
+                    return;
+                socket.async_write(buffer, [this](const std::error_code &error, size_t)
+                                   {
+                    if (!error)
+                        echo(); }); });
+        }
+    };
+
+    Task<void> coroutinePinger(TCPAsyncSocket &socket, std::size_t count)
+    {
+        std::vector<char> buffer(MESSAGE_SIZE, 'x');
+        for (std::size_t idx = 0; idx < count; ++idx)
+        {
+            if ((co_await async_write(socket, buffer)).error || (co_await async_read(socket, buffer)).error)
+                co_return;
+        }
+    }
+
+    Task<void> coroutineEchoer(TCPAsyncSocket &socket, std::size_t count)
+    {
+        std::vector<char> buffer(MESSAGE_SIZE);
+        for (std::size_t idx = 0; idx < count; ++idx)
+        {
+            if ((co_await async_read(socket, buffer)).error || (co_await async_write(socket, buffer)).error)
+                co_return;
+        }
+    }
+
+    template <typename Function>
+    void measure(const std::string &name, std::size_t roundTrips, Function &&function)
+    {
+        IOContext context;
+        auto sockets = makeSocketPair(context);
+
+        const auto allocationsBefore = heapAllocations.load();
+        const auto start = std::chrono::steady_clock::now();
+        function(context, *sockets.first, *sockets.second, roundTrips);
+        context.run();
+        const auto elapsed = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        const auto allocations = heapAllocations.load() - allocationsBefore;
+
+        std::cout << name << ": " << elapsed / roundTrips << " ns/round trip, " << roundTrips * 1e9 / elapsed << " round trips/s, "
+                  << static_cast<double>(allocations) / roundTrips << " allocations/round trip\n";
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t roundTrips = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 100'000;
+
+    measure("socketpair/callbacks", roundTrips, [](IOContext &, TCPAsyncSocket &first, TCPAsyncSocket &second, std::size_t count)
+            {
+        static std::unique_ptr<CallbackPinger> pinger;
+        static std::unique_ptr<CallbackEchoer> echoer;
+        pinger = std::make_unique<CallbackPinger>(CallbackPinger{first, count});
+        echoer = std::make_unique<CallbackEchoer>(CallbackEchoer{second, count});
+        echoer->echo();
+        pinger->ping(); });
+
+    measure("socketpair/coroutines", roundTrips, [](IOContext &context, TCPAsyncSocket &first, TCPAsyncSocket &second, std::size_t count)
+            {
+        co_spawn(context, coroutineEchoer(second, count));
+        co_spawn(context, coroutinePinger(first, count)); });
+
+    return 0;
+}
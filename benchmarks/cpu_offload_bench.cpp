@@ -0,0 +1,129 @@
+#include <sys/socket.h>
+#include <unistd.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "async_operations.hpp"
+#include "benchmark.hpp"
+#include "rates_parser.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    std::string generateDocument(std::size_t count)
+    {
+        std::string document = "<?xml version=\"1.0\" encoding=\"windows-1251\"?><ValCurs Date=\"06.11.2025\" name=\"Foreign Currency Market\">";
+        for (std::size_t idx = 0; idx < count; ++idx)
+        {
+            const auto code = "C" + std::to_string(idx);
+            document += "<Valute ID=\"R" + std::to_string(idx) + "\"><NumCode>" + std::to_string(idx) + "</NumCode><CharCode>" + code +
+                        "</CharCode><Nominal>1</Nominal><Name>" + code + "</Name><Value>81,1885</Value><VunitRate>81,1885</VunitRate></Valute>";
+        }
+        return document + "</ValCurs>";
+    }
+
+    // Echoes single bytes on the reactor; its round trip time is the reactor's responsiveness.
+    struct Echo
+    {
+        TCPAsyncSocket socket;
+        std::vector<char> buffer = std::vector<char>(1);
+
+        Echo(IOContext &context, int descriptor) : socket(context, descriptor)
+        {
+        }
+
+        void read()
+        {
+            socket.async_read(buffer, [this](const std::error_code &error, size_t bytes)
+                              {
+                if (error || bytes == 0)
+                    return;
+                socket.async_write(buffer, [this](const std::error_code &error, size_t)
+                                   {
+                    if (!error)
+                        read(); }); });
+        }
+    };
+
+    void measure(const std::string &name, bool offload, const std::string &document, double seconds)
+    {
+        WorkStealingPool pool(std::max(1u, std::thread::hardware_concurrency()));
+        IOContext context;
+        context.set_cpu_pool(pool);
+
+        int descriptors[2];
+        socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, descriptors);
+        Echo echo(context, descriptors[0]);
+        echo.read();
+
+        std::thread reactor([&]
+                            { context.run(); });
+
+        std::atomic<bool> running{true};
+        std::atomic<std::size_t> parsed{0};
+        std::thread loader([&]
+                           {
+            while (running.load())
+            {
+                auto parse = [&]
+                {
+                    const auto table = parseDailyRates(document);
+                    if (!table.empty())
+                        ++parsed;
+                };
+
+                if (offload)
+                    context.post([&context, parse]
+                                 { context.dispatch_cpu(parse, [] {}); });
+                else
+                    context.post(parse);
+                std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            } });
+
+        const int client = descriptors[1];
+        const int flags = fcntl(client, F_GETFL);
+        fcntl(client, F_SETFL, flags & ~O_NONBLOCK);
+
+        std::vector<double> latencies;
+        const auto deadline = clock_type::now() + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(seconds));
+        char byte = 'x';
+        while (clock_type::now() < deadline)
+        {
+            const auto sent = clock_type::now();
+            if (write(client, &byte, 1) != 1 || read(client, &byte, 1) != 1)
+                break;
+            latencies.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - sent).count());
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+
+        running = false;
+        loader.join();
+        close(client);
+        reactor.join();
+
+        std::cout << name << ": reactor round trip p50 " << percentile(latencies, 0.50) << " us, p99 " << percentile(latencies, 0.99)
+                  << " us, p99.9 " << percentile(latencies, 0.999) << " us (" << latencies.size() << " samples, "
+                  << parsed.load() << " documents parsed)\n";
+    }
+}
+
+// Usage: CpuOffloadBench [currencies per document] [seconds]
+int main(int argc, char **argv)
+{
+    const std::size_t currencies = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 2000;
+    const double seconds = argc > 2 ? std::strtod(argv[2], nullptr) : 2.0;
+    const auto document = generateDocument(currencies);
+
+    measure("parse_on_reactor", false, document, seconds);
+    measure("parse_on_cpu_pool", true, document, seconds);
+    return 0;
+}
@@ -0,0 +1,76 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "cross_rates.hpp"
+
+namespace
+{
+    rates_table_type generateTable(std::size_t count, std::mt19937 &generator)
+    {
+        std::uniform_real_distribution<float> values(0.5f, 150.0f);
+        rates_table_type table;
+
+        for (std::size_t idx = 0; idx < count; ++idx)
+        {
+            Valute valute;
+            valute.CharCode = "C" + std::to_string(idx);
+            valute.ID = "R" + std::to_string(idx);
+            valute.NumCode = static_cast<int>(idx);
+            valute.Nominal = (idx % 3 == 0) ? 100 : 1;
+            valute.Value = values(generator);
+            valute.VunitRate = valute.Value / valute.Nominal;
+            table.emplace(valute.CharCode, valute);
+        }
+        return table;
+    }
+}
+
+int main(int, char **)
+{
+    constexpr std::size_t CURRENCIES = 49;
+    std::mt19937 generator(42);
+    std::uniform_real_distribution<float> jitter(0.99f, 1.01f);
+
+    auto table = generateTable(CURRENCIES, generator);
+    CrossRateMatrix matrix(table);
+
+    runBenchmark("cross_rates/rebuild_50x50", 100'000, [&](std::size_t)
+                 {
+        matrix.rebuild(table);
+        doNotOptimize(matrix.rate(0, 1)); });
+
+    std::vector<rates_table_type> partialUpdates;
+    for (std::size_t step = 0; step < 16; ++step)
+    {
+        auto next = table;
+        for (std::size_t idx = 0; idx < 3; ++idx)
+        {
+            next["C" + std::to_string((step * 3 + idx) % CURRENCIES)].Value *= jitter(generator);
+        }
+        partialUpdates.push_back(std::move(next));
+    }
+
+    runBenchmark("cross_rates/update_3_of_50", 100'000, [&](std::size_t iteration)
+                 {
+        doNotOptimize(matrix.update(partialUpdates[iteration % partialUpdates.size()])); });
+
+    std::vector<std::size_t> indices(1024);
+    std::uniform_int_distribution<std::size_t> pick(0, matrix.size() - 1);
+    for (auto &index : indices)
+    {
+        index = pick(generator);
+    }
+
+    runBenchmark("cross_rates/lookup_by_index", 10'000'000, [&](std::size_t iteration)
+                 {
+        doNotOptimize(matrix.rate(indices[iteration & 1023], indices[(iteration + 1) & 1023])); });
+
+    const auto &codes = matrix.codes();
+    runBenchmark("cross_rates/lookup_by_code", 1'000'000, [&](std::size_t iteration)
+                 {
+        doNotOptimize(matrix.rate(codes[indices[iteration & 1023]], codes[indices[(iteration + 1) & 1023]])); });
+
+    return 0;
+}
@@ -0,0 +1,586 @@
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <deque>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#include "async_operations.hpp"
+#include "benchmark.hpp"
+#include "latency_histogram.hpp"
+#include "strand.hpp"
+
+namespace
+{
+    using clock_type = IOContext::clock_type;
+
+    struct Options
+    {
+        std::size_t connections = 1000;
+        double rate = 20'000.0;
+        double seconds = 5.0;
+        std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+        std::size_t serverThreads = 1;
+        long busyPoll = 0;
+        bool pin = false;
+        std::string host = "127.0.0.1";
+        int port = 0;
+        std::string target = "/scripts/XML_daily.asp?date_req=06.11.2025";
+        std::string dailyFile;
+        std::string dynamicFile;
+        std::string jsonFile;
+    };
+
+    void usage()
+    {
+        std::cerr << "Usage: LoadGenerator [--connections N] [--rate requests/s] [--seconds S] [--threads N]\n"
+                     "                     [--server-threads N] [--daily FILE] [--dynamic FILE] [--target PATH]\n"
+                     "                     [--host IP --port PORT] [--busy-poll USEC] [--pin] [--json FILE]\n"
+                     "Without --port a stub server in the same process replays the captured responses.\n";
+    }
+
+    Options parseOptions(int argc, char **argv)
+    {
+        Options options;
+        for (int idx = 1; idx < argc; ++idx)
+        {
+            const std::string name = argv[idx];
+            if (name == "--pin")
+            {
+                options.pin = true;
+                continue;
+            }
+            if (idx + 1 >= argc)
+            {
+                usage();
+                std::exit(2);
+            }
+            const std::string value = argv[++idx];
+
+            if (name == "--connections")
+                options.connections = std::max<std::size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+            else if (name == "--rate")
+                options.rate = std::strtod(value.c_str(), nullptr);
+            else if (name == "--seconds")
+                options.seconds = std::strtod(value.c_str(), nullptr);
+            else if (name == "--threads")
+                options.threads = std::max<std::size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+            else if (name == "--busy-poll")
+                options.busyPoll = std::max(0L, std::strtol(value.c_str(), nullptr, 10));
+            else if (name == "--server-threads")
+                options.serverThreads = std::max<std::size_t>(1, std::strtoull(value.c_str(), nullptr, 10));
+            else if (name == "--host")
+                options.host = value;
+            else if (name == "--port")
+                options.port = std::atoi(value.c_str());
+            else if (name == "--target")
+                options.target = value;
+            else if (name == "--daily")
+                options.dailyFile = value;
+            else if (name == "--dynamic")
+                options.dynamicFile = value;
+            else if (name == "--json")
+                options.jsonFile = value;
+            else
+            {
+                usage();
+                std::exit(2);
+            }
+        }
+
+        if (options.rate <= 0.0 || options.seconds <= 0.0)
+        {
+            usage();
+            std::exit(2);
+        }
+        return options;
+    }
+
+    std::string readFile(const std::string &path)
+    {
+        std::ifstream stream(path, std::ios::binary);
+        if (!stream)
+            throw std::runtime_error("Cannot read " + path);
+        return std::string(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+    }
+
+    std::string xmlResponse(const std::string &body)
+    {
+        return "HTTP/1.1 200 OK\r\nContent-Type: application/xml; charset=windows-1251\r\nContent-Length: " +
+               std::to_string(body.size()) + "\r\n\r\n" + body;
+    }
+
+    // Every connection needs a descriptor on each side when the stub server runs in this process.
+    void raiseDescriptorLimit()
+    {
+        struct rlimit limit;
+        if (getrlimit(RLIMIT_NOFILE, &limit) == 0 && limit.rlim_cur < limit.rlim_max)
+        {
+            limit.rlim_cur = limit.rlim_max;
+            setrlimit(RLIMIT_NOFILE, &limit);
+        }
+    }
+
+    // Size of the first complete response in the buffer or 0. The stub server always sends Content-Length.
+    std::size_t completeResponseSize(const std::string &buffer)
+    {
+        const auto headEnd = buffer.find("\r\n\r\n");
+        if (headEnd == std::string::npos)
+            return 0;
+
+        const auto lengthPosition = buffer.find("Content-Length: ");
+        if (lengthPosition == std::string::npos || lengthPosition > headEnd)
+            return headEnd + 4;
+        const std::size_t length = std::strtoull(buffer.c_str() + lengthPosition + 16, nullptr, 10);
+        return buffer.size() >= headEnd + 4 + length ? headEnd + 4 + length : 0;
+    }
+
+    // Keep-alive HTTP server replaying captured cbr.ru bodies: XML_dynamic.asp targets get the dynamic capture, every
+    // other target the daily one. Runs its own IOContext so that the client and the server scale separately.
+    class StubServer
+    {
+    public:
+        StubServer(std::string dailyResponse_, std::string dynamicResponse_, std::size_t threads, const ThreadPlacement &placement)
+            : dailyResponse(std::move(dailyResponse_)), dynamicResponse(std::move(dynamicResponse_)), endpoint("127.0.0.1", 0),
+              acceptor(context, endpoint)
+        {
+            context.inc_work();
+            accept_next();
+            threadsField = context.run_threads(threads, placement);
+        }
+
+        StubServer(const StubServer &other) = delete;
+        StubServer &operator=(const StubServer &other) = delete;
+
+        virtual ~StubServer()
+        {
+            acceptor.close();
+            {
+                std::lock_guard lock(connectionsMutex);
+                for (const auto &[pointer, weak] : connectionsField)
+                {
+                    if (auto connection = weak.lock())
+                        ::shutdown(connection->socket->get_socket(), SHUT_RDWR);
+                }
+            }
+            context.dec_work();
+            for (auto &thread : threadsField)
+                thread.join();
+        }
+
+        [[nodiscard]] int port() const
+        {
+            return acceptor.local_port();
+        }
+
+        [[nodiscard]] uint64_t requests_served() const noexcept
+        {
+            return requestsServed.load(std::memory_order_relaxed);
+        }
+
+    private:
+        struct Connection : std::enable_shared_from_this<Connection>
+        {
+            static constexpr int MAX_INLINE_DEPTH = 32;
+
+            Connection(StubServer &server_, TCPAsyncAcceptor::socket_pointer socket_) : server(server_), socket(std::move(socket_)), readBuffer(16 * 1024)
+            {
+            }
+
+            StubServer &server;
+            TCPAsyncAcceptor::socket_pointer socket;
+            std::vector<char> readBuffer;
+            std::string pending;
+            std::vector<char> writeBuffer;
+
+            void read()
+            {
+                static thread_local int inlineDepth = 0;
+                if (inlineDepth >= MAX_INLINE_DEPTH)
+                {
+                    server.context.post([self = shared_from_this()]
+                                        { self->read(); });
+                    return;
+                }
+
+                ++inlineDepth;
+                socket->async_read(readBuffer, [self = shared_from_this()](const std::error_code &error, size_t bytes)
+                                   {
+                    if (error || bytes == 0)
+                    {
+                        self->server.release(self.get());
+                        return;
+                    }
+                    self->pending.append(self->readBuffer.data(), bytes);
+                    self->process(); });
+                --inlineDepth;
+            }
+
+            void process()
+            {
+                std::size_t offset = 0;
+                std::size_t headEnd = 0;
+                uint64_t served = 0;
+                while ((headEnd = pending.find("\r\n\r\n", offset)) != std::string::npos)
+                {
+                    const auto &response = pending.find("XML_dynamic", offset) < headEnd ? server.dynamicResponse : server.dailyResponse;
+                    writeBuffer.insert(writeBuffer.end(), response.cbegin(), response.cend());
+                    offset = headEnd + 4;
+                    ++served;
+                }
+                pending.erase(0, offset);
+                server.requestsServed.fetch_add(served, std::memory_order_relaxed);
+
+                if (writeBuffer.empty())
+                    read();
+                else
+                    write();
+            }
+
+            void write()
+            {
+                socket->async_write(writeBuffer, [self = shared_from_this()](const std::error_code &error, size_t bytes)
+                                    {
+                    if (error)
+                    {
+                        self->server.release(self.get());
+                        return;
+                    }
+                    self->writeBuffer.erase(self->writeBuffer.begin(), self->writeBuffer.begin() + bytes);
+                    if (!self->writeBuffer.empty())
+                        self->write();
+                    else if (self->pending.find("\r\n\r\n") != std::string::npos)
+                        self->process();
+                    else
+                        self->read(); });
+            }
+        };
+
+        std::string dailyResponse;
+        std::string dynamicResponse;
+        IOContext context;
+        EndpointIPv4 endpoint;
+        TCPAsyncAcceptor acceptor;
+        std::vector<std::thread> threadsField;
+        std::mutex connectionsMutex;
+        std::unordered_map<Connection *, std::weak_ptr<Connection>> connectionsField;
+        std::atomic<uint64_t> requestsServed{0};
+
+        void accept_next()
+        {
+            acceptor.async_accept([this](const std::error_code &error, TCPAsyncAcceptor::socket_pointer socket)
+                                  {
+                if (error)
+                    return;
+
+                int enable = 1;
+                setsockopt(socket->get_socket(), IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+                auto connection = std::make_shared<Connection>(*this, std::move(socket));
+                {
+                    std::lock_guard lock(connectionsMutex);
+                    connectionsField.emplace(connection.get(), connection);
+                }
+                connection->read();
+                accept_next(); });
+        }
+
+        void release(Connection *connection)
+        {
+            std::lock_guard lock(connectionsMutex);
+            connectionsField.erase(connection);
+        }
+    };
+
+    // Per run() thread, merged after the run; recording needs no synchronization.
+    struct ThreadStatistics
+    {
+        LatencyHistogram latencies;
+        uint64_t completed = 0;
+        uint64_t failed = 0;
+    };
+
+    thread_local ThreadStatistics *threadStatistics = nullptr;
+
+    // Open-loop client: requests are due on a fixed schedule whether or not earlier responses have arrived, and the
+    // latency of a request is measured from the time it was due, not from the time it could be sent. A stalled server
+    // therefore shows up in the percentiles instead of silently lowering the request rate (coordinated omission).
+    class ClientConnection : public std::enable_shared_from_this<ClientConnection>
+    {
+    public:
+        ClientConnection(IOContext &context_, const std::string &request_, clock_type::time_point firstSend, clock_type::duration interval_,
+                         clock_type::time_point end_, std::atomic<std::size_t> &active_)
+            : context(context_), strand(context_), socket(context_), request(request_), nextSend(firstSend), interval(interval_),
+              end(end_), active(active_), readBuffer(64 * 1024)
+        {
+        }
+
+        void start(EndpointIPv4 &endpoint)
+        {
+            socket.async_connect(endpoint, strand.wrap([self = shared_from_this()](const std::error_code &error)
+                                                       {
+                if (error)
+                {
+                    self->finish(false);
+                    return;
+                }
+                int enable = 1;
+                setsockopt(self->socket.get_socket(), IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+                self->read();
+                self->schedule(); }));
+        }
+
+        // Drain timeout: whatever is still outstanding is counted as failed.
+        void abort()
+        {
+            strand.post([self = shared_from_this()]
+                        { self->socket.cancel(); });
+        }
+
+    private:
+        IOContext &context;
+        Strand strand;
+        TCPAsyncSocket socket;
+        const std::string &request;
+        clock_type::time_point nextSend;
+        clock_type::duration interval;
+        clock_type::time_point end;
+        std::atomic<std::size_t> &active;
+        std::vector<char> readBuffer;
+        std::string inbox;
+        std::string outbox;
+        std::deque<clock_type::time_point> outstanding;
+        bool scheduleDone = false;
+        bool finished = false;
+
+        void schedule()
+        {
+            if (nextSend >= end)
+            {
+                scheduleDone = true;
+                return;
+            }
+            context.post_at(nextSend, strand.wrap([self = shared_from_this()]
+                                                  { self->send_due(); }));
+        }
+
+        // A late timer sends every request that has become due meanwhile; each keeps its own due time.
+        void send_due()
+        {
+            if (finished)
+                return;
+
+            const auto now = clock_type::now();
+            while (nextSend <= now && nextSend < end)
+            {
+                outbox += request;
+                outstanding.push_back(nextSend);
+                nextSend += interval;
+            }
+            flush();
+            schedule();
+        }
+
+        // IOContext keeps one pending operation per descriptor and the read stays armed all the time, so requests are
+        // written directly; whatever the kernel does not take now is retried after the next read or timer.
+        void flush()
+        {
+            while (!outbox.empty())
+            {
+                const auto sent = ::send(socket.get_socket(), outbox.data(), outbox.size(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                if (sent < 0)
+                {
+                    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+                        socket.cancel();
+                    return;
+                }
+                outbox.erase(0, static_cast<std::size_t>(sent));
+            }
+        }
+
+        void read()
+        {
+            socket.async_read(readBuffer, strand.wrap([self = shared_from_this()](const std::error_code &error, size_t bytes)
+                                                      { self->on_read(error, bytes); }));
+        }
+
+        void on_read(const std::error_code &error, size_t bytes)
+        {
+            if (error || bytes == 0)
+            {
+                finish(false);
+                return;
+            }
+
+            inbox.append(readBuffer.data(), bytes);
+            const auto now = clock_type::now();
+            std::size_t size = 0;
+            while (!outstanding.empty() && (size = completeResponseSize(inbox)) != 0)
+            {
+                inbox.erase(0, size);
+                threadStatistics->latencies.record(std::chrono::duration_cast<std::chrono::nanoseconds>(now - outstanding.front()).count());
+                ++threadStatistics->completed;
+                outstanding.pop_front();
+            }
+
+            flush();
+            if (scheduleDone && outstanding.empty())
+                finish(true);
+            else
+                read();
+        }
+
+        void finish(bool success)
+        {
+            if (finished)
+                return;
+            finished = true;
+            if (!success)
+            {
+                // Requests that were sent and never answered, and the ones a dead connection can no longer send.
+                threadStatistics->failed += outstanding.size();
+                if (nextSend < end)
+                    threadStatistics->failed += (end - nextSend + interval - clock_type::duration(1)) / interval;
+            }
+            outstanding.clear();
+            socket.close();
+            active.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    };
+}
+
+int main(int argc, char **argv)
+{
+    const auto options = parseOptions(argc, argv);
+    raiseDescriptorLimit();
+
+    std::unique_ptr<StubServer> server;
+    int port = options.port;
+    if (port == 0)
+    {
+        const auto daily = options.dailyFile.empty() ? cbrDailyDocument() : readFile(options.dailyFile);
+        const auto dynamic = options.dynamicFile.empty() ? daily : readFile(options.dynamicFile);
+        // With --pin the server threads take the CPUs after the client threads.
+        ThreadPlacement placement;
+        for (std::size_t idx = 0; options.pin && idx < options.serverThreads; ++idx)
+            placement.cpuSets.push_back(ThreadPlacement::compact().cpus_for(options.threads + idx));
+        server = std::make_unique<StubServer>(xmlResponse(daily), xmlResponse(dynamic), options.serverThreads, placement);
+        port = server->port();
+    }
+
+    const std::string request = "GET " + options.target + " HTTP/1.1\r\nHost: " + options.host + "\r\nConnection: keep-alive\r\n\r\n";
+    EndpointIPv4 endpoint(options.host, port);
+    IOContext context;
+    if (options.busyPoll > 0 && !context.set_busy_poll(std::chrono::microseconds(options.busyPoll)))
+        std::cerr << "kernel epoll busy polling unavailable, spinning in user space only\n";
+    std::atomic<std::size_t> active{options.connections};
+
+    // The schedule starts after a grace period for the connects; request k of the run is due at start + k / rate.
+    const auto requestInterval = std::chrono::duration<double>(1.0 / options.rate);
+    const auto connectionInterval = std::chrono::duration_cast<clock_type::duration>(requestInterval * options.connections);
+    const auto start = clock_type::now() + std::chrono::milliseconds(500);
+    const auto end = start + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(options.seconds));
+
+    std::vector<std::shared_ptr<ClientConnection>> connections;
+    connections.reserve(options.connections);
+    for (std::size_t idx = 0; idx < options.connections; ++idx)
+    {
+        const auto firstSend = start + std::chrono::duration_cast<clock_type::duration>(requestInterval * idx);
+        connections.push_back(std::make_shared<ClientConnection>(context, request, firstSend, connectionInterval, end, active));
+    }
+
+    // Responses still missing two seconds after the last request was due are failures.
+    const auto drainTimer = context.post_at(end + std::chrono::seconds(2), [&connections]
+                                            {
+        for (const auto &connection : connections)
+            connection->abort(); });
+
+    std::vector<std::unique_ptr<ThreadStatistics>> statistics;
+    for (std::size_t idx = 0; idx < options.threads; ++idx)
+        statistics.push_back(std::make_unique<ThreadStatistics>());
+
+    // The connects are started from a run() thread, so handlers completing inline have statistics to record into.
+    context.post([&]
+                 {
+        for (const auto &connection : connections)
+            connection->start(endpoint); });
+
+    std::vector<std::thread> threads;
+    for (std::size_t idx = 0; idx < options.threads; ++idx)
+    {
+        threads.emplace_back([&context, &options, idx, stats = statistics[idx].get()]
+                             {
+            if (options.pin)
+                placeCurrentThread(ThreadPlacement::compact().cpus_for(idx));
+            threadStatistics = stats;
+            context.run(); });
+    }
+
+    // Let run() return as soon as every connection has finished instead of waiting for the drain timer.
+    while (active.load(std::memory_order_acquire) != 0 && clock_type::now() < end + std::chrono::seconds(2))
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    context.cancel_timer(drainTimer);
+    for (auto &thread : threads)
+        thread.join();
+
+    ThreadStatistics total;
+    for (const auto &stats : statistics)
+    {
+        total.latencies.merge(stats->latencies);
+        total.completed += stats->completed;
+        total.failed += stats->failed;
+    }
+
+    const auto microseconds = [&total](double percentile)
+    {
+        return total.latencies.value_at_percentile(percentile) / 1000.0;
+    };
+    std::cout << "connections " << options.connections << ", client threads " << options.threads << ", target rate " << options.rate
+              << " req/s for " << options.seconds << " s\n"
+              << "completed " << total.completed << " (" << total.completed / options.seconds << " req/s), failed " << total.failed << "\n"
+              << "latency us: p50 " << microseconds(50.0) << ", p90 " << microseconds(90.0) << ", p99 " << microseconds(99.0)
+              << ", p99.9 " << microseconds(99.9) << ", max " << total.latencies.max() / 1000.0 << ", mean "
+              << total.latencies.mean() / 1000.0 << "\n";
+
+    const auto metrics = context.metrics();
+    std::cout << "client reactor: " << metrics.events_per_wait() << " events per wait, " << metrics.wakeups << " wakeups, "
+              << metrics.tasksExecuted << " tasks, handler p99 " << metrics.handlerTime.value_at_percentile(99.0) / 1000.0
+              << " us, task p99 " << metrics.taskTime.value_at_percentile(99.0) / 1000.0 << " us\n";
+    if (options.busyPoll > 0)
+        std::cout << "busy poll " << metrics.busyPollMicroseconds << " us: " << metrics.busyPolls << " polls, " << metrics.busyPollHits
+                  << " with events, spin ratio " << metrics.spin_ratio() << "\n";
+
+    if (!options.jsonFile.empty())
+    {
+        JsonReport report;
+        report.add("load/open_loop", {{"completed", static_cast<double>(total.completed)},
+                                      {"failed", static_cast<double>(total.failed)},
+                                      {"requests_per_second", total.completed / options.seconds},
+                                      {"p50_us", microseconds(50.0)},
+                                      {"p90_us", microseconds(90.0)},
+                                      {"p99_us", microseconds(99.0)},
+                                      {"p999_us", microseconds(99.9)},
+                                      {"max_us", total.latencies.max() / 1000.0}});
+        std::ofstream stream(options.jsonFile);
+        report.write(stream, {{"connections", static_cast<double>(options.connections)},
+                              {"client_threads", static_cast<double>(options.threads)},
+                              {"server_threads", static_cast<double>(options.port == 0 ? options.serverThreads : 0)},
+                              {"busy_poll_us", static_cast<double>(options.busyPoll)},
+                              {"pinned", options.pin ? 1.0 : 0.0},
+                              {"target_rate", options.rate},
+                              {"seconds", options.seconds}});
+    }
+    return total.failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,164 @@
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "rate_server.hpp"
+
+namespace
+{
+    using clock_type = std::chrono::steady_clock;
+
+    rates_table_type generateTable(std::size_t count)
+    {
+        std::mt19937 generator(42);
+        std::uniform_real_distribution<float> values(0.5f, 150.0f);
+        rates_table_type table;
+
+        for (std::size_t idx = 0; idx < count; ++idx)
+        {
+            Valute valute;
+            valute.CharCode = "C" + std::to_string(idx);
+            valute.ID = "R" + std::to_string(idx);
+            valute.NumCode = static_cast<int>(idx);
+            valute.Nominal = 1;
+            valute.Value = values(generator);
+            valute.VunitRate = valute.Value;
+            table.emplace(valute.CharCode, valute);
+        }
+        return table;
+    }
+
+    int connectLoopback(int port)
+    {
+        const int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+        int enable = 1;
+        setsockopt(descriptor, IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        struct sockaddr_in address;
+        memset(&address, 0, sizeof(address));
+        address.sin_family = AF_INET;
+        address.sin_port = htons(port);
+        address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        if (connect(descriptor, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0)
+        {
+            throw std::runtime_error("Failed to connect to the rate server");
+        }
+        return descriptor;
+    }
+
+    // Size of the first complete response in the buffer or 0.
+    std::size_t completeResponseSize(const std::string &buffer)
+    {
+        const auto headEnd = buffer.find("\r\n\r\n");
+        if (headEnd == std::string::npos)
+            return 0;
+
+        const auto lengthPosition = buffer.find("Content-Length: ");
+        const std::size_t length = std::strtoull(buffer.c_str() + lengthPosition + 16, nullptr, 10);
+        return buffer.size() >= headEnd + 4 + length ? headEnd + 4 + length : 0;
+    }
+
+    // Keep-alive client sending batches of pipelined requests, latencies are measured per response.
+    void runClient(int port, std::size_t depth, clock_type::time_point deadline, std::vector<double> &latencies)
+    {
+        const std::array<std::string, 3> targets{"/rates/C1", "/cross/C2/C7", "/cross/RUB/C30"};
+        const int descriptor = connectLoopback(port);
+        std::string buffer;
+        std::array<char, 16 * 1024> chunk;
+
+        for (std::size_t round = 0; clock_type::now() < deadline; ++round)
+        {
+            std::string requests;
+            for (std::size_t idx = 0; idx < depth; ++idx)
+            {
+                requests += "GET " + targets[(round + idx) % targets.size()] + " HTTP/1.1\r\nHost: localhost\r\n\r\n";
+            }
+
+            const auto sent = clock_type::now();
+            if (write(descriptor, requests.data(), requests.size()) != static_cast<ssize_t>(requests.size()))
+                break;
+
+            for (std::size_t received = 0; received < depth;)
+            {
+                std::size_t size = 0;
+                while ((size = completeResponseSize(buffer)) != 0 && received < depth)
+                {
+                    buffer.erase(0, size);
+                    latencies.push_back(std::chrono::duration<double, std::micro>(clock_type::now() - sent).count());
+                    ++received;
+                }
+                if (received == depth)
+                    break;
+
+                const auto count = read(descriptor, chunk.data(), chunk.size());
+                if (count <= 0)
+                {
+                    close(descriptor);
+                    return;
+                }
+                buffer.append(chunk.data(), count);
+            }
+        }
+        close(descriptor);
+    }
+}
+
+// Usage: RateServerBench [connections] [pipeline depth] [seconds]
+int main(int argc, char **argv)
+{
+    const std::size_t connections = argc > 1 ? std::strtoull(argv[1], nullptr, 10) : 8;
+    const std::size_t depth = argc > 2 ? std::strtoull(argv[2], nullptr, 10) : 1;
+    const double seconds = argc > 3 ? std::strtod(argv[3], nullptr) : 2.0;
+
+    IOContext context;
+    EndpointIPv4 endpoint("127.0.0.1", 0);
+    RateServer server(context, endpoint);
+    server.update(generateTable(49), 20000);
+    server.start();
+    const int port = server.local_port();
+
+    std::thread reactor([&]
+                        { context.run(); });
+
+    const auto deadline = clock_type::now() + std::chrono::duration_cast<clock_type::duration>(std::chrono::duration<double>(seconds));
+    std::vector<std::vector<double>> latencies(connections);
+    std::vector<std::thread> clients;
+    const auto start = clock_type::now();
+    for (std::size_t idx = 0; idx < connections; ++idx)
+    {
+        clients.emplace_back([&, idx]
+                             { runClient(port, depth, deadline, latencies[idx]); });
+    }
+    for (auto &client : clients)
+    {
+        client.join();
+    }
+    const auto elapsed = std::chrono::duration<double>(clock_type::now() - start).count();
+
+    context.post([&]
+                 { server.stop(); });
+    reactor.join();
+
+    std::vector<double> all;
+    for (const auto &values : latencies)
+    {
+        all.insert(all.end(), values.cbegin(), values.cend());
+    }
+
+    std::cout << "rate_server/get connections=" << connections << " depth=" << depth << ": "
+              << all.size() / elapsed << " req/s, p50 " << percentile(all, 0.50) << " us, p99 "
+              << percentile(all, 0.99) << " us (" << all.size() << " requests)\n";
+    return 0;
+}
@@ -0,0 +1,49 @@
+#include <random>
+#include <string>
+#include <vector>
+
+#include "benchmark.hpp"
+#include "time_series.hpp"
+
+int main(int, char **)
+{
+    constexpr std::size_t CURRENCIES = 40;
+    constexpr std::size_t BUSINESS_DAYS = 2'520;
+
+    std::mt19937 generator(7);
+    std::normal_distribution<float> step(0.0f, 0.004f);
+
+    rates_table_type table;
+    for (std::size_t idx = 0; idx < CURRENCIES; ++idx)
+    {
+        Valute valute;
+        valute.CharCode = "C" + std::to_string(idx);
+        valute.Nominal = 1;
+        valute.Value = 10.0f + idx;
+        table.emplace(valute.CharCode, valute);
+    }
+
+    RateTimeSeries history;
+    const auto start = dayFromCivil(2015, 1, 1);
+    day_type day = start;
+
+    runBenchmark("time_series/append_day_40_currencies", BUSINESS_DAYS, [&](std::size_t)
+                 {
+        for (auto &[code, valute] : table)
+        {
+            valute.Value *= 1.0f + step(generator);
+        }
+        history.append(day++, table); });
+
+    std::uniform_int_distribution<int> offset(0, 30);
+    runBenchmark("time_series/aggregate_10_years", 100'000, [&](std::size_t iteration)
+                 {
+        const auto code = "C" + std::to_string(iteration % CURRENCIES);
+        doNotOptimize(history.aggregate(code, start + offset(generator), day - offset(generator))); });
+
+    runBenchmark("time_series/aggregate_one_month", 1'000'000, [&](std::size_t iteration)
+                 {
+        doNotOptimize(history.aggregate("C1", start + static_cast<day_type>(iteration % 2'000), start + static_cast<day_type>(iteration % 2'000) + 30)); });
+
+    return 0;
+}
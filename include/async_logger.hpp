@@ -0,0 +1,280 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <array>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <cstring>
+#include <cstdint>
+#include <ctime>
+#include <unistd.h>
+
+#include "service_function.hpp"
+
+// Messages below this level are removed at compile time: log<LogLevel::DEBUG>(...) compiles to nothing unless the
+// build defines ASYNC_CONNECT_MIN_LOG_LEVEL=0.
+#ifndef ASYNC_CONNECT_MIN_LOG_LEVEL
+#define ASYNC_CONNECT_MIN_LOG_LEVEL 1
+#endif
+
+// One message as copied by the producing thread: raw arguments, formatted later by the writer thread.
+struct LogRecord
+{
+    static constexpr std::size_t PAYLOAD_SIZE = 240;
+
+    int64_t timestamp = 0;
+    LogLevel level = LogLevel::INFO;
+    uint16_t size = 0;
+    std::array<char, PAYLOAD_SIZE> payload;
+};
+
+// Single-producer single-consumer ring of LogRecords: the owning thread claims and publishes, the writer thread drains.
+class LogRing
+{
+public:
+    explicit LogRing(std::size_t capacity_);
+
+    LogRing(const LogRing &other) = delete;
+    LogRing &operator=(const LogRing &other) = delete;
+
+    virtual ~LogRing() = default;
+
+    // Producer only; nullptr when the ring is full.
+    [[nodiscard]] inline LogRecord *claim() noexcept
+    {
+        const auto head = headField.load(std::memory_order_relaxed);
+        if (head - tailField.load(std::memory_order_acquire) >= capacity)
+            return nullptr;
+        return &records[head & mask];
+    }
+
+    inline void publish() noexcept
+    {
+        headField.store(headField.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    // Consumer only.
+    [[nodiscard]] inline uint64_t head() const noexcept
+    {
+        return headField.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] inline uint64_t tail() const noexcept
+    {
+        return tailField.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline const LogRecord &at(uint64_t index) const noexcept
+    {
+        return records[index & mask];
+    }
+
+    inline void release(uint64_t tail) noexcept
+    {
+        tailField.store(tail, std::memory_order_release);
+    }
+
+    // Set when the producing thread has exited; the ring is removed once drained.
+    std::atomic<bool> abandoned{false};
+
+private:
+    std::size_t capacity;
+    std::size_t mask;
+    std::unique_ptr<LogRecord[]> records;
+    alignas(64) std::atomic<uint64_t> headField{0};
+    alignas(64) std::atomic<uint64_t> tailField{0};
+};
+
+// Asynchronous logger. The calling thread only copies the arguments into its own lock-free ring; a background thread
+// formats them ("user date LEVEL MESSAGE: text") and writes batches to the descriptor. The user name is looked up once
+// and the date text is rebuilt once per second. Messages that find the ring full are dropped and counted, the writer
+// reports the number of drops in the output.
+class AsyncLogger
+{
+public:
+    static constexpr std::size_t DEFAULT_RING_SIZE = 1024;
+
+    explicit AsyncLogger(int descriptor_ = STDOUT_FILENO, std::size_t ringSize_ = DEFAULT_RING_SIZE);
+
+    AsyncLogger(const AsyncLogger &other) = delete;
+    AsyncLogger &operator=(const AsyncLogger &other) = delete;
+
+    // Writes whatever is still queued.
+    virtual ~AsyncLogger();
+
+    // Process-wide logger writing to stdout.
+    static AsyncLogger &getLogger();
+
+    // Supported arguments: integers, floating point, bool, char, strings and std::error_code. Strings are copied;
+    // text beyond LogRecord::PAYLOAD_SIZE is cut.
+    template <LogLevel Level, typename... ArgumentTypes>
+    inline void log(const ArgumentTypes &...arguments) noexcept
+    {
+        if constexpr (static_cast<int>(Level) >= ASYNC_CONNECT_MIN_LOG_LEVEL)
+            push(Level, arguments...);
+    }
+
+    // Runtime level, for callers that do not know it at compile time.
+    void loggingMessage(const LogLevel &logLevel, const std::string &message) noexcept;
+
+    // Blocks until every message published before the call has been written.
+    void flush();
+
+    [[nodiscard]] inline uint64_t dropped() const noexcept
+    {
+        return droppedField.load(std::memory_order_relaxed);
+    }
+
+private:
+    enum class ArgumentTag : char
+    {
+        SIGNED,
+        UNSIGNED,
+        FLOATING,
+        BOOLEAN,
+        CHARACTER,
+        TEXT,
+        ERROR_CODE
+    };
+
+    struct ErrorArgument
+    {
+        int value;
+        const std::error_category *category;
+    };
+
+    class Writer
+    {
+    public:
+        explicit Writer(LogRecord &record_) noexcept : record(record_)
+        {
+        }
+
+        template <typename ValueType>
+        void put(ArgumentTag tag, const ValueType &value) noexcept
+        {
+            if (record.size + 1 + sizeof(ValueType) > LogRecord::PAYLOAD_SIZE)
+                return;
+            record.payload[record.size++] = static_cast<char>(tag);
+            std::memcpy(record.payload.data() + record.size, &value, sizeof(ValueType));
+            record.size += sizeof(ValueType);
+        }
+
+        void put_text(std::string_view text) noexcept
+        {
+            if (record.size + 1 + sizeof(uint16_t) >= LogRecord::PAYLOAD_SIZE)
+                return;
+            const auto length = static_cast<uint16_t>(std::min(text.size(), LogRecord::PAYLOAD_SIZE - record.size - 1 - sizeof(uint16_t)));
+            record.payload[record.size++] = static_cast<char>(ArgumentTag::TEXT);
+            std::memcpy(record.payload.data() + record.size, &length, sizeof(length));
+            record.size += sizeof(length);
+            std::memcpy(record.payload.data() + record.size, text.data(), length);
+            record.size += length;
+        }
+
+    private:
+        LogRecord &record;
+    };
+
+    template <typename ArgumentType>
+    static void encode(Writer &writer, const ArgumentType &argument) noexcept
+    {
+        using value_type = std::decay_t<ArgumentType>;
+
+        if constexpr (std::is_same_v<value_type, bool>)
+            writer.put(ArgumentTag::BOOLEAN, argument);
+        else if constexpr (std::is_same_v<value_type, char>)
+            writer.put(ArgumentTag::CHARACTER, argument);
+        else if constexpr (std::is_integral_v<value_type> && std::is_signed_v<value_type>)
+            writer.put(ArgumentTag::SIGNED, static_cast<int64_t>(argument));
+        else if constexpr (std::is_integral_v<value_type>)
+            writer.put(ArgumentTag::UNSIGNED, static_cast<uint64_t>(argument));
+        else if constexpr (std::is_floating_point_v<value_type>)
+            writer.put(ArgumentTag::FLOATING, static_cast<double>(argument));
+        else if constexpr (std::is_same_v<value_type, std::error_code>)
+        {
+            // Categories are static objects, the message is looked up by the writer thread.
+            writer.put(ArgumentTag::ERROR_CODE, ErrorArgument{argument.value(), &argument.category()});
+        }
+        else if constexpr (std::is_array_v<ArgumentType>)
+        {
+            // A string literal: its extent less the terminating null, no length scan and no null check.
+            static_assert(std::is_same_v<std::remove_cv_t<std::remove_extent_t<ArgumentType>>, char>, "Unsupported log argument");
+            writer.put_text(std::string_view(argument, std::extent_v<ArgumentType> - 1));
+        }
+        else if constexpr (std::is_pointer_v<value_type>)
+        {
+            static_assert(std::is_same_v<std::remove_cv_t<std::remove_pointer_t<value_type>>, char>, "Unsupported log argument");
+            writer.put_text(argument != nullptr ? std::string_view(argument) : std::string_view("(null)"));
+        }
+        else
+        {
+            static_assert(std::is_convertible_v<const value_type &, std::string_view>, "Unsupported log argument");
+            writer.put_text(std::string_view(argument));
+        }
+    }
+
+    template <typename... ArgumentTypes>
+    void push(LogLevel level, const ArgumentTypes &...arguments) noexcept
+    {
+        auto *ring = thread_ring();
+        auto *record = ring != nullptr ? ring->claim() : nullptr;
+        if (record == nullptr)
+        {
+            droppedField.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        record->timestamp = coarseNow();
+        record->level = level;
+        record->size = 0;
+        Writer writer(*record);
+        (encode(writer, arguments), ...);
+        ring->publish();
+    }
+
+    static int64_t coarseNow() noexcept
+    {
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME_COARSE, &now);
+        return static_cast<int64_t>(now.tv_sec) * 1'000'000'000 + now.tv_nsec;
+    }
+
+    // Ring of the calling thread, registered on its first message; nullptr if it cannot be allocated.
+    LogRing *thread_ring() noexcept;
+
+    void work();
+    bool drain(std::string &output);
+    void format(const LogRecord &record, std::string &output);
+    void write_output(const std::string &output);
+
+    const uint64_t loggerId;
+    int descriptor;
+    std::size_t ringSize;
+    std::string userPrefix;
+
+    std::mutex ringsMutex;
+    std::vector<std::shared_ptr<LogRing>> ringsField;
+
+    std::mutex wakeMutex;
+    std::condition_variable wakeCondition;
+    std::condition_variable drainedCondition;
+    uint64_t drainPasses = 0;
+    bool stopping = false;
+
+    std::atomic<uint64_t> droppedField{0};
+    uint64_t reportedDrops = 0;
+
+    int64_t cachedSecond = -1;
+    std::string cachedDate;
+
+    std::thread writerThread;
+};
@@ -19,14 +19,24 @@
 #include <mutex>
 #include <atomic>
 #include <queue>
+#include <deque>
+#include <optional>
 #include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <chrono>
+#include <unordered_map>
 #include <thread>
 #include <sstream>
 #include <fcntl.h>
 #include <unistd.h>
 #include <cerrno>
 
+#include "buffer_chain.hpp"
 #include "epoll.hpp"
+#include "completion_token.hpp"
+#include "io_metrics.hpp"
+#include "thread_placement.hpp"
+#include "threading_policy.hpp"
 
 class EndpointIPv4
 {
@@ -55,25 +65,56 @@ private:
     struct sockaddr_in addr_struct;
 };
 
-class TCPAsyncSocket;
+template <typename ThreadingPolicy>
+class BasicTCPAsyncSocket;
+class WorkStealingPool;
 
 enum class OperationType
 {
     CONNECT,
     READ,
-    WRITE
+    WRITE,
+    ACCEPT,
+    // Readiness only, the socket drains the descriptor itself.
+    READ_CHAIN,
+    // Writability only, the socket flushes its write queue itself.
+    WRITE_QUEUE
 };
 
 using connection_handler_type = std::function<void(const std::error_code&)>;
 using read_write_handler_type = std::function<void(const std::error_code&, size_t bytes_transfered)>;
+using chain_handler_type = std::function<void(const std::error_code &, BufferChain chain)>;
+
+// Descriptor in the low 32 bits, registration generation in the high 32 bits. An epoll event carries an id of the same
+// form, taken when the descriptor was last armed, so an event fetched before the descriptor was re-armed, or closed and
+// reused, cannot complete a newer operation.
+using operation_id_type = uint64_t;
+
+constexpr operation_id_type INVALID_OPERATION_ID = 0;
+
+[[nodiscard]] inline int operationDescriptor(const operation_id_type &id) noexcept
+{
+    return static_cast<int>(static_cast<uint32_t>(id));
+}
 
 struct AsyncOperation
 {    
-    TCPAsyncSocket* socketPointer;
+    operation_id_type id = INVALID_OPERATION_ID;
     OperationType type;
     std::variant<connection_handler_type, read_write_handler_type> socket_handler;
     std::vector<char>* bufferArray;
     size_t totalBytesRequested = 0;
+    // Per-socket byte counter of the owning TCPAsyncSocket, if any.
+    std::atomic<uint64_t> *transferCounter = nullptr;
+};
+
+// What is pending on one descriptor: at most one operation waiting for input (read, read chain, accept) and one
+// waiting for output (connect, write, queue flush). The descriptor is armed for the events of both under armedTag.
+struct DescriptorOperations
+{
+    std::optional<AsyncOperation> input;
+    std::optional<AsyncOperation> output;
+    operation_id_type armedTag = INVALID_OPERATION_ID;
 };
 
 struct OperationInvoker
@@ -84,7 +125,7 @@ struct OperationInvoker
 
     void operator () (const connection_handler_type& handler) const
     {
-        if(type == OperationType::CONNECT) handler(errorCode);
+        if(type == OperationType::CONNECT || type == OperationType::ACCEPT || type == OperationType::READ_CHAIN || type == OperationType::WRITE_QUEUE) handler(errorCode);
     }
 
     void operator() (const read_write_handler_type handler) const
@@ -96,66 +137,234 @@ struct OperationInvoker
     }    
 };
 
-class IOContext
+// The reactor. ThreadingPolicy is MultiThreaded or SingleThreaded (see threading_policy.hpp); IOContext is the
+// multi-threaded one.
+template <typename ThreadingPolicy>
+class BasicIOContext
 {
     public:
 
+    using threading_policy = ThreadingPolicy;
     using task_type = std::function<void()>;
+    using clock_type = std::chrono::steady_clock;
+    using timer_id_type = uint64_t;
+
+    // Every run() thread waits into its own event buffer. The batch starts small and doubles while epoll_wait fills it,
+    // it halves after SHRINK_AFTER_WAITS waits that used at most a quarter of it.
+    static constexpr int MIN_EVENT_BATCH = 16;
+    static constexpr int MAX_EVENT_BATCH = 1024;
+    static constexpr int SHRINK_AFTER_WAITS = 64;
 
-    IOContext();
+    BasicIOContext();
 
-    virtual ~IOContext();
+    BasicIOContext(const BasicIOContext &other) = delete;
+    BasicIOContext &operator=(const BasicIOContext &other) = delete;
 
+    virtual ~BasicIOContext();
+
+    // Returns once no work is left: no pending operation, timer, queued task or CPU dispatch. A context that has
+    // nothing to do returns at once.
     void run();
 
+    // Starts `count` threads that place themselves (CPU affinity, node-local memory) and then run(); returns once every
+    // thread is placed, so the per-thread state run() allocates is on the right node. A thread whose placement failed
+    // runs unpinned and the first error is stored in placementError. The caller joins the threads.
+    std::vector<std::thread> run_threads(std::size_t count, const ThreadPlacement &placement = ThreadPlacement(),
+                                         std::error_code *placementError = nullptr)
+        requires ThreadingPolicy::concurrent;
+
+    // The CPU every thread of the last run_threads() call was pinned to, -1 if they were not all on one CPU. A
+    // per-core context passes it to TCPAsyncAcceptor::set_incoming_cpu().
+    [[nodiscard]] inline int pinned_cpu() const noexcept
+    {
+        return pinnedCpu.load(std::memory_order_relaxed);
+    }
+
+    // Makes the run() threads poll instead of block; they still leave only once the work is done.
     void stop();
 
     void post(task_type task);
 
-    void register_operations(int sockId, uint32_t eventMask, AsyncOperation operation);
+    // Runs the task on one of the run() threads once the deadline has passed. A pending timer counts as work.
+    timer_id_type post_at(clock_type::time_point deadline, task_type task);
+
+    timer_id_type post_after(clock_type::duration delay, task_type task);
+
+    // Returns false when the timer has already fired or was cancelled.
+    bool cancel_timer(timer_id_type id);
+
+    // Runs the CPU-heavy task on the CPU pool and then posts the continuation back to this context. Keeps run() going
+    // until the continuation has been queued. The task must not throw.
+    void dispatch_cpu(task_type task, task_type continuation)
+        requires ThreadingPolicy::concurrent;
 
+    // WorkStealingPool::shared() unless set; the pool must outlive the context.
+    void set_cpu_pool(WorkStealingPool &pool) noexcept
+        requires ThreadingPolicy::concurrent;
+
+    // A descriptor has one pending operation per direction: EPOLLOUT in the mask makes it the output operation,
+    // otherwise it is the input one. A second one in the same direction is refused: its handler is posted with
+    // device_or_resource_busy and INVALID_OPERATION_ID is returned.
+    operation_id_type register_operations(int sockId, uint32_t eventMask, AsyncOperation operation);
+
+    // Drops the pending operations of the descriptor without calling their handlers.
     void deregister_operation(int sockId);
 
+    // Completes the operation with operation_canceled (posted, never inline) if it is still pending.
+    bool cancel_operation(operation_id_type id);
+
+    // Cancels whatever operations are pending on the descriptor.
+    bool cancel_operations(int sockId);
+
     void inc_work();
 
     void dec_work();
 
+    // Taken while the loop keeps running; see IOMetricsSnapshot.
+    [[nodiscard]] IOMetricsSnapshot metrics();
+
+    // Handler and task durations cost two clock reads per handler; on by default.
+    void set_handler_timing(bool enable) noexcept;
+
+    // Bytes moved outside the reactor, e.g. by a read that completed inline.
+    void add_transferred_bytes(OperationType type, size_t bytes) noexcept;
+
+    // Hybrid waiting: after its last event or task a run() thread keeps polling epoll without blocking for up to the
+    // budget, then blocks again. Zero, the default, always blocks. Every spinning thread keeps a core busy, so use no
+    // more run() threads than spare cores. Returns true if the kernel also took the epoll busy-poll parameters, which
+    // poll the NIC queues of the registered sockets (EPIOCSPARAMS, Linux 6.9).
+    bool set_busy_poll(std::chrono::microseconds budget);
+
+    [[nodiscard]] std::chrono::microseconds busy_poll() const noexcept;
+
     private:
+
+    using mutex_type = typename ThreadingPolicy::mutex_type;
+
+    template <typename ValueType>
+    using atomic_type = typename ThreadingPolicy::template atomic_type<ValueType>;
     
     Epoll epollManager;
-    std::map<int, AsyncOperation> pendingOperations;
-    std::atomic<bool> stopRun{false};
-    std::atomic<size_t> workCount{0};
+    std::unordered_map<int, DescriptorOperations> pendingOperations;
+    uint32_t operationGeneration = 0;
+    atomic_type<bool> stopRun{false};
+    atomic_type<size_t> workCount{0};
 
-    std::mutex operationsMutex;    
-    int pipefd[2];
+    mutex_type operationsMutex;    
+    // Wakes threads blocked in epoll_wait; a single-threaded context has none to wake and no pipe.
+    int pipefd[2] = {-1, -1};
 
     std::queue<task_type> tasksQueue;
-    std::mutex tasksMutex;
+    mutex_type tasksMutex;
+
+    using timer_key_type = std::pair<clock_type::time_point, timer_id_type>;
+
+    int timerfd = -1;
+    mutex_type timersMutex;
+    std::map<timer_key_type, task_type> timersField;
+    std::unordered_map<timer_id_type, clock_type::time_point> timerDeadlines;
+    timer_id_type nextTimerId = 1;
+
+    atomic_type<WorkStealingPool *> cpuPool{nullptr};
+
+    IOMetrics metricsField;
+    atomic_type<bool> handlerTiming{true};
+    atomic_type<size_t> runningThreads{0};
+    atomic_type<int64_t> busyPollNanoseconds{0};
+    atomic_type<int> pinnedCpu{-1};
+
+    IOMetrics::Shard &local_shard() noexcept;
 
     void handle_event(const epoll_event& event);    
+    // The system call of a read, write or connect that became ready; handle_event() makes it while the descriptor's
+    // entry is locked, so a concurrent close() cannot hand the number to another socket in between.
+    void transfer(AsyncOperation &operation, uint32_t events, std::error_code &errorCode, size_t &bytesTransfered);
+    void complete_operation(AsyncOperation &operation, const std::error_code &errorCode, size_t bytesTransfered);
+    // Arms the descriptor for the operations left in the entry under a new tag; false if epoll refused.
+    bool arm_locked(int sockId, DescriptorOperations &operations);
+    // Cancels the operation `id` of the entry, or both of them for INVALID_OPERATION_ID.
+    bool cancel_locked(std::unique_lock<mutex_type> &lock, std::unordered_map<int, DescriptorOperations>::iterator iter,
+                       operation_id_type id);
     void handle_pipe_event();
+    void handle_timer_event();
+    void arm_timer(clock_type::time_point deadline);
     void process_pending_tasks();
 };
 
-class TCPAsyncSocket : public std::enable_shared_from_this<TCPAsyncSocket>
+using IOContext = BasicIOContext<MultiThreaded>;
+
+// Cancels one particular operation: pass it to an async_* call and cancel() completes exactly that operation with
+// operation_canceled while it is pending. Each call re-binds the slot, an operation that already finished is left alone.
+template <typename ThreadingPolicy>
+class BasicCancellationSlot
 {
 public:
-    using context_type = IOContext;
-    using context_reference = IOContext &;
+    using context_type = BasicIOContext<ThreadingPolicy>;
+
+    BasicCancellationSlot() = default;
+
+    BasicCancellationSlot(const BasicCancellationSlot &other) = delete;
+    BasicCancellationSlot &operator=(const BasicCancellationSlot &other) = delete;
+
+    virtual ~BasicCancellationSlot() = default;
+
+    void bind(context_type &context_, operation_id_type id_) noexcept
+    {
+        context.store(&context_, std::memory_order_relaxed);
+        id.store(id_, std::memory_order_release);
+    }
+
+    bool cancel()
+    {
+        const auto bound = id.exchange(INVALID_OPERATION_ID, std::memory_order_acq_rel);
+        const auto boundContext = context.load(std::memory_order_relaxed);
+        return bound != INVALID_OPERATION_ID && boundContext != nullptr && boundContext->cancel_operation(bound);
+    }
+
+private:
+    typename ThreadingPolicy::template atomic_type<context_type *> context{nullptr};
+    typename ThreadingPolicy::template atomic_type<operation_id_type> id{INVALID_OPERATION_ID};
+};
+
+using CancellationSlot = BasicCancellationSlot<MultiThreaded>;
+
+// A socket belongs to a context of the same threading policy.
+template <typename ThreadingPolicy>
+class BasicTCPAsyncSocket : public std::enable_shared_from_this<BasicTCPAsyncSocket<ThreadingPolicy>>
+{
+public:
+    using context_type = BasicIOContext<ThreadingPolicy>;
+    using context_reference = context_type &;
+    using cancellation_slot_type = BasicCancellationSlot<ThreadingPolicy>;
     using socket_type = int;
 
-    explicit TCPAsyncSocket(context_type &context_);
+    // Upper bound of one async_read_chain(), so that one fast sender cannot hold a run() thread indefinitely.
+    static constexpr std::size_t READ_CHAIN_LIMIT = 1024 * 1024;
+
+    // Write queue defaults: above the high-water mark the pressure handler is told to pause, at the low-water mark to
+    // resume, and async_send() refuses what would take the queue past its capacity.
+    static constexpr std::size_t WRITE_LOW_WATER_MARK = 64 * 1024;
+    static constexpr std::size_t WRITE_HIGH_WATER_MARK = 256 * 1024;
+    static constexpr std::size_t WRITE_QUEUE_CAPACITY = 1024 * 1024;
+    // Queued buffers handed to one gathering write.
+    static constexpr std::size_t WRITE_BATCH = 64;
+
+    using pressure_handler_type = std::function<void(bool paused)>;
+
+    explicit BasicTCPAsyncSocket(context_type &context_);
+
+    // Takes ownership of an already connected non-blocking descriptor.
+    BasicTCPAsyncSocket(context_type &context_, socket_type socket_);
 
-    TCPAsyncSocket(const TCPAsyncSocket &other) = delete;
+    BasicTCPAsyncSocket(const BasicTCPAsyncSocket &other) = delete;
 
-    TCPAsyncSocket &operator=(const TCPAsyncSocket &other) = delete;
+    BasicTCPAsyncSocket &operator=(const BasicTCPAsyncSocket &other) = delete;
 
-    TCPAsyncSocket(TCPAsyncSocket &&other) noexcept;
+    BasicTCPAsyncSocket(BasicTCPAsyncSocket &&other) noexcept;
 
-    TCPAsyncSocket &operator=(TCPAsyncSocket &&other) noexcept;
+    BasicTCPAsyncSocket &operator=(BasicTCPAsyncSocket &&other) noexcept;
 
-    virtual ~TCPAsyncSocket();
+    virtual ~BasicTCPAsyncSocket();
 
     [[nodiscard]] inline const int &get_socket() const noexcept
     {
@@ -167,18 +376,239 @@ public:
         return socketField >= 0;
     }
 
-    void async_connect(EndpointIPv4 &endpoint, std::function<void(const std::error_code &)> handler);  
+    [[nodiscard]] inline uint64_t bytes_read() const noexcept
+    {
+        return bytesReadField.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline uint64_t bytes_written() const noexcept
+    {
+        return bytesWrittenField.load(std::memory_order_relaxed);
+    }
+
+    // CPU that processed the last packets of the connection (SO_INCOMING_CPU), -1 if unknown.
+    [[nodiscard]] int incoming_cpu() const noexcept;
+
+    // SO_BUSY_POLL: blocking reads of this socket poll the device queue for up to the budget. Raising it above
+    // net.core.busy_read needs CAP_NET_ADMIN.
+    std::error_code set_busy_poll(std::chrono::microseconds budget);
+
+    void async_connect(EndpointIPv4 &endpoint, std::function<void(const std::error_code &)> handler, cancellation_slot_type *slot = nullptr);  
     
-    void async_read(std::vector<char>& buffer, std::function<void(const std::error_code&, size_t)> handler);
+    void async_read(std::vector<char>& buffer, std::function<void(const std::error_code&, size_t)> handler, cancellation_slot_type *slot = nullptr);
+
+    void async_write(std::vector<char>& buffer, std::function<void(const std::error_code&, size_t)> handler, cancellation_slot_type *slot = nullptr);
+
+    // Reads until the descriptor has nothing more (a read that does not fill its block, or EAGAIN) or `limit` bytes
+    // are gathered, into pooled blocks sized from the earlier reads of this socket, and hands everything to the
+    // handler at once. Waits for readiness only when nothing is there yet. The end of the stream is reported after
+    // the data before it, as connection_reset with an empty chain.
+    void async_read_chain(chain_handler_type handler, cancellation_slot_type *slot = nullptr, std::size_t limit = READ_CHAIN_LIMIT);
+
+    // Queues the whole buffer behind the earlier sends and writes as much of the queue as the socket takes, up to
+    // WRITE_BATCH buffers per gathering write; the rest goes out when the socket becomes writable. The handler runs once its
+    // buffer is fully written. Fails with no_buffer_space, queuing nothing, when the queue would exceed its capacity.
+    // Safe from any thread. While the socket is full the flush is the output operation of the descriptor, so a read
+    // may stay pending meanwhile but async_write() must not be mixed in: the reactor refuses a second output operation,
+    // and the sends queued at that point fail with device_or_resource_busy.
+    std::error_code async_send(std::vector<char> data, read_write_handler_type handler = nullptr);
+
+    // invalid_argument unless lowWaterMark <= highWaterMark <= capacity.
+    std::error_code set_write_limits(std::size_t lowWaterMark, std::size_t highWaterMark, std::size_t capacity);
+
+    // Called with true when the queue grows above the high-water mark and with false once it has drained to the
+    // low-water mark, outside the queue lock.
+    void set_write_pressure_handler(pressure_handler_type handler);
+
+    [[nodiscard]] std::size_t queued_bytes() const;
+
+    // The pending operation completes with operation_canceled.
+    void cancel();
 
-    void async_write(std::vector<char>& buffer, std::function<void(const std::error_code&, size_t)> handler);
+    // Cancels the pending operation and closes the descriptor; also done by the destructor.
+    void close();
+
+    template <CompletionTag TokenType>
+    auto async_connect(EndpointIPv4 &endpoint, TokenType token)
+    {
+        return TokenCompletion<>::initiate(token, [this, &endpoint](auto handler)
+                                           { async_connect(endpoint, std::move(handler)); });
+    }
+
+    template <CompletionTag TokenType>
+    auto async_read(std::vector<char> &buffer, TokenType token)
+    {
+        return TokenCompletion<size_t>::initiate(token, [this, &buffer](auto handler)
+                                                 { async_read(buffer, std::move(handler)); });
+    }
+
+    template <CompletionTag TokenType>
+    auto async_write(std::vector<char> &buffer, TokenType token)
+    {
+        return TokenCompletion<size_t>::initiate(token, [this, &buffer](auto handler)
+                                                 { async_write(buffer, std::move(handler)); });
+    }
+
+    template <CompletionTag TokenType>
+    auto async_read_chain(TokenType token)
+    {
+        return TokenCompletion<BufferChain>::initiate(token, [this](auto handler)
+                                                      { async_read_chain(std::move(handler)); });
+    }
 
 private:
 
     context_reference context;
     socket_type socketField;
+    std::atomic<uint64_t> bytesReadField{0};
+    std::atomic<uint64_t> bytesWrittenField{0};
+    // Operations of one socket never overlap, so only one chain read uses it at a time.
+    ReadSizer readSizer;
 
+    struct QueuedWrite
+    {
+        std::vector<char> data;
+        read_write_handler_type handler;
+    };
+
+    using write_completions_type = std::vector<std::pair<read_write_handler_type, size_t>>;
+
+    // What a flush leaves to run once the queue lock is released.
+    struct WriteCompletions
+    {
+        write_completions_type finished;
+        std::error_code failure;
+        // Entries before it were written in full and complete without an error, the ones from it on were failed.
+        std::size_t firstFailed = 0;
+        std::optional<bool> pressure;
+        pressure_handler_type pressureCallback;
+
+        void run() const;
+    };
+
+    // The chain read and queue flush completions reach the socket through its anchor and hold the anchor's mutex
+    // while they use it. close(), the destructor and a move take the same mutex, so they wait for such a completion
+    // to finish with the descriptor, and one that runs later finds the socket gone. No handler of the user runs under it.
+    struct Anchor
+    {
+        typename ThreadingPolicy::mutex_type mutex;
+        BasicTCPAsyncSocket *socket = nullptr;
+    };
+
+    std::shared_ptr<Anchor> anchor;
+
+    mutable typename ThreadingPolicy::mutex_type writeMutex;
+    std::deque<QueuedWrite> writeQueue;
+    // Bytes of the front buffer already written.
+    std::size_t writeOffset = 0;
+    std::size_t queuedBytes = 0;
+    std::size_t lowWaterMark = WRITE_LOW_WATER_MARK;
+    std::size_t highWaterMark = WRITE_HIGH_WATER_MARK;
+    std::size_t writeCapacity = WRITE_QUEUE_CAPACITY;
+    bool writeArmed = false;
+    bool writePaused = false;
+    pressure_handler_type pressureHandler;
+
+    // Writes until the queue is empty or the socket is full, then waits for writability; unlocks and returns the
+    // handlers of the finished sends to run. A failure fails everything still queued with it.
+    [[nodiscard]] WriteCompletions flush(std::unique_lock<typename ThreadingPolicy::mutex_type> &lock, std::error_code failure = std::error_code());
+    // Moves every queued handler to the finished ones, from firstFailed on, and empties the queue.
+    void fail_queue(write_completions_type &finished, std::size_t &firstFailed);
+    // Removes written bytes from the queue.
+    void consume(std::size_t bytes, write_completions_type &finished);
+    // The pressure change the queue size calls for, if any.
+    [[nodiscard]] std::optional<bool> update_pressure() noexcept;
+
+    // Reads what is there into the chain. False when there was nothing yet; an error or the end of the stream is
+    // reported only if the chain is empty.
+    bool drain_into(BufferChain &chain, std::size_t limit, std::error_code &errorCode);
+    // Waits for the descriptor to become readable and then drains it for the handler.
+    void arm_read_chain(chain_handler_type handler, cancellation_slot_type *slot, std::size_t limit);
+    // Takes over the anchor of other, and with it the completions pending on its descriptor.
+    void adopt_anchor(BasicTCPAsyncSocket &other);
     void set_nonblocking();
 };
 
+using TCPAsyncSocket = BasicTCPAsyncSocket<MultiThreaded>;
+
+class TCPAsyncAcceptor
+{
+public:
+    using context_type = IOContext;
+    using context_reference = IOContext &;
+    using socket_type = int;
+    using socket_pointer = std::shared_ptr<TCPAsyncSocket>;
+    using accept_handler_type = std::function<void(const std::error_code &, socket_pointer)>;
+
+    // Connections taken from the kernel queue per readiness event; the surplus waits in the acceptor for the next async_accept.
+    static constexpr std::size_t ACCEPT_BATCH_SIZE = 64;
+
+    explicit TCPAsyncAcceptor(context_type &context_);
+
+    // Opens, binds and listens; throws std::system_error on failure.
+    TCPAsyncAcceptor(context_type &context_, EndpointIPv4 &endpoint, bool reusePort = false, int backlog = SOMAXCONN);
+
+    TCPAsyncAcceptor(const TCPAsyncAcceptor &other) = delete;
+    TCPAsyncAcceptor &operator=(const TCPAsyncAcceptor &other) = delete;
+
+    virtual ~TCPAsyncAcceptor();
+
+    [[nodiscard]] inline const int &get_socket() const noexcept
+    {
+        return acceptorField;
+    }
+
+    [[nodiscard]] inline bool is_open() const noexcept
+    {
+        return acceptorField >= 0;
+    }
+
+    std::error_code set_reuse_address(bool enable);
+
+    // SO_REUSEPORT lets every IOContext of a pool own a listener on the same port; the kernel balances connections between them.
+    std::error_code set_reuse_port(bool enable);
+
+    // SO_INCOMING_CPU: among SO_REUSEPORT listeners of a port the kernel prefers the one whose CPU processed the
+    // connection's packets, so a context pinned to that CPU handles it without crossing caches.
+    std::error_code set_incoming_cpu(int cpu);
 
+    std::error_code bind(EndpointIPv4 &endpoint);
+
+    std::error_code listen(int backlog = SOMAXCONN);
+
+    [[nodiscard]] int local_port() const;
+
+    void async_accept(accept_handler_type handler);
+
+    template <CompletionTag TokenType>
+    auto async_accept(TokenType token)
+    {
+        return TokenCompletion<socket_pointer>::initiate(token, [this](auto handler)
+                                                         { async_accept(std::move(handler)); });
+    }
+
+    // Pending accepts complete with operation_canceled.
+    void close();
+
+private:
+    // The readiness completion reaches the acceptor through its anchor, whose mutex guards the accept state. The
+    // destructor clears the pointer under it, so a completion already taken by a run() thread finds the acceptor gone
+    // instead of using a destroyed one. Accept handlers run after the mutex is released.
+    struct Anchor
+    {
+        std::mutex mutex;
+        TCPAsyncAcceptor *acceptor = nullptr;
+    };
+
+    context_reference context;
+    socket_type acceptorField;
+
+    std::shared_ptr<Anchor> anchor;
+    std::deque<socket_type> acceptedField;
+    std::deque<accept_handler_type> waitersField;
+    bool armed = false;
+
+    std::error_code drain();
+    void on_readable(std::unique_lock<std::mutex> &lock, const std::error_code &errorCode);
+    void dispatch(std::unique_lock<std::mutex> &lock);
+};
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <array>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Recycles read buffers in power-of-two size classes from MIN_BLOCK_SIZE to MAX_BLOCK_SIZE. Blocks are not
+// zeroed; each class keeps at most MAX_CACHED_BLOCKS free blocks and frees the rest.
+class BufferPool
+{
+public:
+    static constexpr std::size_t MIN_BLOCK_SIZE = 2 * 1024;
+    static constexpr std::size_t MAX_BLOCK_SIZE = 64 * 1024;
+    static constexpr std::size_t MAX_CACHED_BLOCKS = 64;
+
+    BufferPool() = default;
+
+    BufferPool(const BufferPool &other) = delete;
+    BufferPool &operator=(const BufferPool &other) = delete;
+
+    virtual ~BufferPool();
+
+    static BufferPool &shared();
+
+    // Rounds the size up to its class; sizes outside [MIN_BLOCK_SIZE, MAX_BLOCK_SIZE] are clamped.
+    [[nodiscard]] static std::size_t block_size(std::size_t size) noexcept;
+
+    // A block of block_size(size) bytes.
+    [[nodiscard]] char *acquire(std::size_t size);
+
+    // `capacity` must be the size acquire() returned the block for.
+    void release(char *block, std::size_t capacity) noexcept;
+
+    // Free blocks currently cached.
+    [[nodiscard]] std::size_t cached() const;
+
+private:
+    static constexpr std::size_t CLASS_COUNT = 6;
+
+    [[nodiscard]] static std::size_t class_of(std::size_t capacity) noexcept;
+
+    mutable std::mutex poolMutex;
+    std::array<std::vector<char *>, CLASS_COUNT> freeBlocks;
+};
+
+// Bytes gathered by one read, in pooled blocks that go back to their pool when the chain is destroyed or cleared.
+class BufferChain
+{
+public:
+    struct Block
+    {
+        char *data;
+        std::size_t size;
+        std::size_t capacity;
+    };
+
+    BufferChain() = default;
+
+    explicit BufferChain(BufferPool &pool_) noexcept;
+
+    BufferChain(const BufferChain &other) = delete;
+    BufferChain &operator=(const BufferChain &other) = delete;
+
+    BufferChain(BufferChain &&other) noexcept;
+
+    BufferChain &operator=(BufferChain &&other) noexcept;
+
+    virtual ~BufferChain();
+
+    [[nodiscard]] inline std::size_t size() const noexcept
+    {
+        return sizeField;
+    }
+
+    [[nodiscard]] inline bool empty() const noexcept
+    {
+        return sizeField == 0;
+    }
+
+    // In order; only the last block may be partly filled.
+    [[nodiscard]] inline const std::vector<Block> &blocks() const noexcept
+    {
+        return blocksField;
+    }
+
+    // Appends an empty block of at least `capacity` bytes to fill and commit().
+    Block &add_block(std::size_t capacity);
+
+    // Marks `bytes` more bytes of the last block as filled.
+    void commit(std::size_t bytes) noexcept;
+
+    // Returns the last block to the pool, e.g. one a read left empty; its bytes leave the chain.
+    void pop_block() noexcept;
+
+    // Copies the content into one string.
+    [[nodiscard]] std::string to_string() const;
+
+    void clear() noexcept;
+
+private:
+    BufferPool *pool = &BufferPool::shared();
+    std::vector<Block> blocksField;
+    std::size_t sizeField = 0;
+};
+
+// Read size of one connection. The first block of a read is as large as the recent reads of the connection: the
+// estimate grows at once to a larger read and halves after SHRINK_AFTER_READS reads that needed at most a quarter of
+// it, so one large response does not keep the connection on large blocks. Each further block of a read doubles.
+class ReadSizer
+{
+public:
+    static constexpr int SHRINK_AFTER_READS = 8;
+
+    [[nodiscard]] inline std::size_t first_block() const noexcept
+    {
+        return estimate;
+    }
+
+    [[nodiscard]] static std::size_t next_block(std::size_t previous) noexcept;
+
+    // Bytes one read gathered.
+    void record(std::size_t bytes) noexcept;
+
+private:
+    std::size_t estimate = BufferPool::MIN_BLOCK_SIZE;
+    int smallReads = 0;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <system_error>
+
+#include "async_operations.hpp"
+#include "http_client.hpp"
+#include "response_cache.hpp"
+#include "single_flight.hpp"
+#include "exchange_rates.hpp"
+
+using rates_handler_type = std::function<void(const std::error_code &, rates_pointer)>;
+using history_handler_type = std::function<void(const std::error_code &, history_pointer)>;
+
+// Client for the cbr.ru XML API. Responses are cached by request URI: documents that can no longer change are served
+// without any network, other ones are revalidated with If-None-Match / If-Modified-Since. Concurrent requests for the same
+// URI share one fetch and receive the same parsed table.
+class CbrClient
+{
+public:
+    static constexpr const char *DEFAULT_HOST = "www.cbr.ru";
+    static constexpr const char *DAILY_PATH = "/scripts/XML_daily.asp";
+    static constexpr const char *DYNAMIC_PATH = "/scripts/XML_dynamic.asp";
+
+    CbrClient(IOContext &context_, std::string ipAddress, int port = 80, std::string host = DEFAULT_HOST);
+
+    CbrClient(const CbrClient &other) = delete;
+    CbrClient &operator=(const CbrClient &other) = delete;
+
+    virtual ~CbrClient() = default;
+
+    void get_daily_rates(const day_type &day, rates_handler_type handler);
+
+    template <CompletionTag TokenType>
+    auto get_daily_rates(const day_type &day, TokenType token)
+    {
+        return TokenCompletion<rates_pointer>::initiate(token, [this, &day](auto handler)
+                                                        { get_daily_rates(day, std::move(handler)); });
+    }
+
+    // One currency over [from, to] in a single request. valuteId is the cbr.ru identifier ("R01235" for USD), see Valute::ID.
+    // Records carry ID, Nominal, Value and VunitRate; the document is parsed as it streams in.
+    void get_dynamic_rates(const std::string &valuteId, const day_type &from, const day_type &to, history_handler_type handler);
+
+    template <CompletionTag TokenType>
+    auto get_dynamic_rates(const std::string &valuteId, const day_type &from, const day_type &to, TokenType token)
+    {
+        return TokenCompletion<history_pointer>::initiate(token, [&, this](auto handler)
+                                                          { get_dynamic_rates(valuteId, from, to, std::move(handler)); });
+    }
+
+    [[nodiscard]] static std::string daily_target(const day_type &day);
+
+    [[nodiscard]] static std::string dynamic_target(const std::string &valuteId, const day_type &from, const day_type &to);
+
+    [[nodiscard]] inline ResponseCache &cache() noexcept
+    {
+        return cacheField;
+    }
+
+    [[nodiscard]] inline CacheStatistics cache_statistics() const noexcept
+    {
+        return cacheField.statistics();
+    }
+
+    // Requests that were attached to a fetch already in flight instead of opening their own connection.
+    [[nodiscard]] inline uint64_t coalesced_requests() const noexcept
+    {
+        return inFlight.coalesced();
+    }
+
+private:
+    struct DocumentRequest
+    {
+        std::string target;
+        bool immutable = false;
+        HttpResponseParser::body_handler_type bodyHandler;
+        std::function<std::error_code(HttpResponse &&response, CachedResponse &entry)> build;
+        std::function<void(const std::error_code &, const CachedResponse *entry)> complete;
+    };
+
+    struct BuildJob
+    {
+        DocumentRequest request;
+        HttpResponse response;
+        CachedResponse entry;
+        std::error_code error;
+    };
+
+    IOContext &context;
+    HttpClient httpClient;
+    ResponseCache cacheField;
+    SingleFlight<const CachedResponse *> inFlight;
+
+    void fetch(DocumentRequest request);
+};
@@ -0,0 +1,166 @@
+#pragma once
+
+#include <linux/futex.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <atomic>
+#include <future>
+#include <memory>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <stdexcept>
+#include <system_error>
+#include <cstdint>
+
+// Completion tokens accepted by the async_* functions in place of a callback:
+//  use_future — returns a std::future of the result, an error is stored as std::system_error;
+//  use_sync — blocks the calling thread until completion and returns the result or throws std::system_error.
+struct use_future_t
+{
+};
+
+struct use_sync_t
+{
+};
+
+inline constexpr use_future_t use_future{};
+inline constexpr use_sync_t use_sync{};
+
+template <typename TokenType>
+concept CompletionTag = std::is_same_v<std::decay_t<TokenType>, use_future_t> || std::is_same_v<std::decay_t<TokenType>, use_sync_t>;
+
+// Result of an operation completing with (error_code, values...): void, the single value or a tuple.
+template <typename... ValueTypes>
+struct CompletionValue
+{
+    using type = std::tuple<ValueTypes...>;
+};
+
+template <>
+struct CompletionValue<>
+{
+    using type = void;
+};
+
+template <typename ValueType>
+struct CompletionValue<ValueType>
+{
+    using type = ValueType;
+};
+
+template <typename... ValueTypes>
+using completion_value_type = typename CompletionValue<std::decay_t<ValueTypes>...>::type;
+
+// Marks the threads inside IOContext::run(); use_sync there would block the reactor that has to complete the operation.
+class ReactorThread
+{
+public:
+    ReactorThread() noexcept
+    {
+        ++depth();
+    }
+
+    ReactorThread(const ReactorThread &other) = delete;
+    ReactorThread &operator=(const ReactorThread &other) = delete;
+
+    ~ReactorThread()
+    {
+        --depth();
+    }
+
+    [[nodiscard]] static bool inside() noexcept
+    {
+        return depth() > 0;
+    }
+
+private:
+    static int &depth() noexcept
+    {
+        thread_local int value = 0;
+        return value;
+    }
+};
+
+// One-shot event on a private futex: the waiter sleeps in the kernel until notify(), no polling and no mutex.
+class FutexEvent
+{
+public:
+    void wait() noexcept
+    {
+        while (state.load(std::memory_order_acquire) == 0)
+        {
+            syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state), FUTEX_WAIT_PRIVATE, 0, nullptr, nullptr, 0);
+        }
+    }
+
+    void notify() noexcept
+    {
+        state.store(1, std::memory_order_release);
+        syscall(SYS_futex, reinterpret_cast<uint32_t *>(&state), FUTEX_WAKE_PRIVATE, 1, nullptr, nullptr, 0);
+    }
+
+private:
+    static_assert(sizeof(std::atomic<uint32_t>) == sizeof(uint32_t) && std::atomic<uint32_t>::is_always_lock_free);
+
+    std::atomic<uint32_t> state{0};
+};
+
+template <typename... ValueTypes>
+struct TokenCompletion
+{
+    using value_type = completion_value_type<ValueTypes...>;
+
+    // initiation(handler) starts the operation with a callback taking (const std::error_code &, ValueTypes...).
+    template <typename Initiation>
+    static std::future<value_type> initiate(use_future_t, Initiation &&initiation)
+    {
+        auto promise = std::make_shared<std::promise<value_type>>();
+        auto future = promise->get_future();
+
+        initiation([promise](const std::error_code &error, ValueTypes... values)
+                   {
+            if (error)
+            {
+                promise->set_exception(std::make_exception_ptr(std::system_error(error)));
+            }
+            else if constexpr (std::is_void_v<value_type>)
+            {
+                promise->set_value();
+            }
+            else
+            {
+                promise->set_value(value_type(std::move(values)...));
+            } });
+        return future;
+    }
+
+    template <typename Initiation>
+    static value_type initiate(use_sync_t, Initiation &&initiation)
+    {
+        if (ReactorThread::inside())
+            throw std::logic_error("use_sync must not be used on a thread running an IOContext");
+
+        struct SyncState
+        {
+            std::error_code error;
+            std::optional<std::conditional_t<std::is_void_v<value_type>, bool, value_type>> value;
+            FutexEvent done;
+        } state;
+
+        initiation([statePointer = &state](const std::error_code &error, ValueTypes... values)
+                   {
+            statePointer->error = error;
+            if constexpr (std::is_void_v<value_type>)
+                statePointer->value.emplace(true);
+            else
+                statePointer->value.emplace(value_type(std::move(values)...));
+            statePointer->done.notify(); });
+
+        state.done.wait();
+        if (state.error)
+            throw std::system_error(state.error);
+        if constexpr (!std::is_void_v<value_type>)
+            return std::move(*state.value);
+    }
+};
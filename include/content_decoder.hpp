@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <optional>
+#include <functional>
+#include <cstddef>
+#include <limits>
+
+enum class ContentEncoding
+{
+    IDENTITY,
+    GZIP,
+    DEFLATE
+};
+
+// Returns std::nullopt for encodings that are not supported.
+[[nodiscard]] std::optional<ContentEncoding> parseContentEncoding(const std::string &value);
+
+// Streaming zlib inflater: compressed input is decoded in fixed-size pieces and handed to the sink as it is produced.
+class ContentDecoder
+{
+public:
+    using sink_type = std::function<void(const char *data, std::size_t size)>;
+
+    static constexpr std::size_t OUTPUT_CHUNK_SIZE = 16 * 1024;
+    static constexpr std::size_t UNLIMITED = std::numeric_limits<std::size_t>::max();
+
+    // write() fails once the decoded output would exceed maxDecodedSize_.
+    ContentDecoder(ContentEncoding encoding_, sink_type sink_, std::size_t maxDecodedSize_ = UNLIMITED);
+
+    ContentDecoder(const ContentDecoder &other) = delete;
+    ContentDecoder &operator=(const ContentDecoder &other) = delete;
+
+    ContentDecoder(ContentDecoder &&other) noexcept;
+    ContentDecoder &operator=(ContentDecoder &&other) noexcept;
+
+    virtual ~ContentDecoder();
+
+    // Returns false if the input is corrupt or decodes past the size limit.
+    bool write(const char *data, std::size_t size);
+
+    // Returns true if the compressed stream was complete.
+    bool finish();
+
+    [[nodiscard]] inline ContentEncoding encoding() const noexcept
+    {
+        return encodingField;
+    }
+
+    [[nodiscard]] inline std::size_t decoded_bytes() const noexcept
+    {
+        return decodedBytesField;
+    }
+
+private:
+    struct Stream;
+
+    ContentEncoding encodingField;
+    sink_type sink;
+    std::unique_ptr<Stream> stream;
+    std::size_t maxDecodedSizeField;
+    std::size_t decodedBytesField = 0;
+    std::optional<char> firstByte;
+    bool streamEnded = false;
+    bool failed = false;
+
+    bool initialize(int windowBits);
+    bool inflate_input(const char *data, std::size_t size);
+};
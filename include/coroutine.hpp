@@ -0,0 +1,434 @@
+#pragma once
+
+#include <coroutine>
+#include <exception>
+#include <optional>
+#include <variant>
+#include <utility>
+#include <atomic>
+#include <array>
+#include <functional>
+#include <type_traits>
+#include <system_error>
+#include <cstddef>
+
+#include "async_operations.hpp"
+
+// Per-thread free lists of coroutine frames by size class. Frames larger than MAX_CACHED_SIZE go straight to the heap.
+class FrameAllocator
+{
+public:
+    static constexpr std::size_t GRANULARITY = 64;
+    static constexpr std::size_t MAX_CACHED_SIZE = 4096;
+    static constexpr std::size_t MAX_CACHED_FRAMES = 256;
+
+    [[nodiscard]] static void *allocate(std::size_t size);
+
+    static void deallocate(void *frame, std::size_t size) noexcept;
+
+    // Frames of the calling thread that had to be taken from the heap.
+    [[nodiscard]] static std::size_t heap_allocations() noexcept;
+};
+
+// Routes the frames of a coroutine type through FrameAllocator.
+struct RecycledFrame
+{
+    static void *operator new(std::size_t size)
+    {
+        return FrameAllocator::allocate(size);
+    }
+
+    static void operator delete(void *frame, std::size_t size) noexcept
+    {
+        FrameAllocator::deallocate(frame, size);
+    }
+};
+
+template <typename ValueType = void>
+class Task;
+
+struct TaskPromiseBase : RecycledFrame
+{
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+
+    struct FinalAwaiter
+    {
+        bool await_ready() const noexcept
+        {
+            return false;
+        }
+
+        template <typename PromiseType>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<PromiseType> handle) noexcept
+        {
+            auto next = handle.promise().continuation;
+            return next ? next : std::noop_coroutine();
+        }
+
+        void await_resume() const noexcept
+        {
+        }
+    };
+
+    std::suspend_always initial_suspend() const noexcept
+    {
+        return {};
+    }
+
+    FinalAwaiter final_suspend() const noexcept
+    {
+        return {};
+    }
+
+    void unhandled_exception() noexcept
+    {
+        exception = std::current_exception();
+    }
+};
+
+template <typename ValueType>
+struct TaskPromise : TaskPromiseBase
+{
+    std::optional<ValueType> value;
+
+    Task<ValueType> get_return_object() noexcept;
+
+    template <typename ResultType>
+    void return_value(ResultType &&result)
+    {
+        value.emplace(std::forward<ResultType>(result));
+    }
+
+    ValueType result()
+    {
+        if (exception)
+            std::rethrow_exception(exception);
+        return std::move(*value);
+    }
+};
+
+template <>
+struct TaskPromise<void> : TaskPromiseBase
+{
+    Task<void> get_return_object() noexcept;
+
+    void return_void() const noexcept
+    {
+    }
+
+    void result()
+    {
+        if (exception)
+            std::rethrow_exception(exception);
+    }
+};
+
+// Lazily started coroutine: the body runs when the task is awaited, and the awaiting coroutine resumes by symmetric transfer.
+template <typename ValueType>
+class [[nodiscard]] Task
+{
+public:
+    using promise_type = TaskPromise<ValueType>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    explicit Task(handle_type handle_) noexcept : handle(handle_)
+    {
+    }
+
+    Task(const Task &other) = delete;
+    Task &operator=(const Task &other) = delete;
+
+    Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr))
+    {
+    }
+
+    Task &operator=(Task &&other) noexcept
+    {
+        if (this != &other)
+        {
+            if (handle)
+                handle.destroy();
+            handle = std::exchange(other.handle, nullptr);
+        }
+        return *this;
+    }
+
+    virtual ~Task()
+    {
+        if (handle)
+            handle.destroy();
+    }
+
+    bool await_ready() const noexcept
+    {
+        return !handle || handle.done();
+    }
+
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept
+    {
+        handle.promise().continuation = awaiting;
+        return handle;
+    }
+
+    ValueType await_resume()
+    {
+        return handle.promise().result();
+    }
+
+private:
+    handle_type handle;
+};
+
+template <typename ValueType>
+Task<ValueType> TaskPromise<ValueType>::get_return_object() noexcept
+{
+    return Task<ValueType>(std::coroutine_handle<TaskPromise<ValueType>>::from_promise(*this));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object() noexcept
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+// Decides whether the completion handler or await_suspend resumes the coroutine; the handler may run on another
+// reactor thread before the operation has been started completely.
+class CompletionLatch
+{
+public:
+    // Returns false when the operation has already completed and the coroutine must not suspend.
+    bool suspend(std::coroutine_handle<> handle_) noexcept
+    {
+        handle = handle_;
+        return state.exchange(SUSPENDED, std::memory_order_acq_rel) != COMPLETED;
+    }
+
+    // Resumes inline on the completing thread if the coroutine is already suspended.
+    void complete() noexcept
+    {
+        if (state.exchange(COMPLETED, std::memory_order_acq_rel) == SUSPENDED)
+            handle.resume();
+    }
+
+private:
+    static constexpr int STARTED = 0;
+    static constexpr int SUSPENDED = 1;
+    static constexpr int COMPLETED = 2;
+
+    std::atomic<int> state{STARTED};
+    std::coroutine_handle<> handle;
+};
+
+struct IoResult
+{
+    std::error_code error;
+    std::size_t bytes = 0;
+};
+
+class ConnectAwaiter
+{
+public:
+    ConnectAwaiter(TCPAsyncSocket &socket_, EndpointIPv4 &endpoint_) noexcept : socket(socket_), endpoint(endpoint_)
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        socket.async_connect(endpoint, [this](const std::error_code &error_)
+                             {
+            error = error_;
+            latch.complete(); });
+        return latch.suspend(handle);
+    }
+
+    std::error_code await_resume() const noexcept
+    {
+        return error;
+    }
+
+private:
+    TCPAsyncSocket &socket;
+    EndpointIPv4 &endpoint;
+    std::error_code error;
+    CompletionLatch latch;
+};
+
+class TransferAwaiter
+{
+public:
+    TransferAwaiter(TCPAsyncSocket &socket_, std::vector<char> &buffer_, OperationType type_) noexcept : socket(socket_), buffer(buffer_), type(type_)
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    bool await_suspend(std::coroutine_handle<> handle)
+    {
+        auto handler = [this](const std::error_code &error, size_t bytes)
+        {
+            result.error = error;
+            result.bytes = bytes;
+            latch.complete();
+        };
+
+        if (type == OperationType::READ)
+            socket.async_read(buffer, handler);
+        else
+            socket.async_write(buffer, handler);
+        return latch.suspend(handle);
+    }
+
+    IoResult await_resume() const noexcept
+    {
+        return result;
+    }
+
+private:
+    TCPAsyncSocket &socket;
+    std::vector<char> &buffer;
+    OperationType type;
+    IoResult result;
+    CompletionLatch latch;
+};
+
+class WaitAwaiter
+{
+public:
+    WaitAwaiter(IOContext &context_, IOContext::clock_type::duration delay_) noexcept : context(context_), delay(delay_)
+    {
+    }
+
+    bool await_ready() const noexcept
+    {
+        return delay <= IOContext::clock_type::duration::zero();
+    }
+
+    void await_suspend(std::coroutine_handle<> handle)
+    {
+        context.post_after(delay, [handle]
+                           { handle.resume(); });
+    }
+
+    void await_resume() const noexcept
+    {
+    }
+
+private:
+    IOContext &context;
+    IOContext::clock_type::duration delay;
+};
+
+// co_await async_connect(socket, endpoint) -> std::error_code
+[[nodiscard]] inline ConnectAwaiter async_connect(TCPAsyncSocket &socket, EndpointIPv4 &endpoint) noexcept
+{
+    return ConnectAwaiter(socket, endpoint);
+}
+
+// auto [error, bytes] = co_await async_read(socket, buffer);
+[[nodiscard]] inline TransferAwaiter async_read(TCPAsyncSocket &socket, std::vector<char> &buffer) noexcept
+{
+    return TransferAwaiter(socket, buffer, OperationType::READ);
+}
+
+[[nodiscard]] inline TransferAwaiter async_write(TCPAsyncSocket &socket, std::vector<char> &buffer) noexcept
+{
+    return TransferAwaiter(socket, buffer, OperationType::WRITE);
+}
+
+// Resumes on a run() thread of the context after the delay.
+[[nodiscard]] inline WaitAwaiter async_wait(IOContext &context, IOContext::clock_type::duration delay) noexcept
+{
+    return WaitAwaiter(context, delay);
+}
+
+// Eagerly destroyed frame driving a spawned task to completion.
+struct SpawnedTask
+{
+    struct promise_type : RecycledFrame
+    {
+        SpawnedTask get_return_object() noexcept
+        {
+            return SpawnedTask{std::coroutine_handle<promise_type>::from_promise(*this)};
+        }
+
+        std::suspend_always initial_suspend() const noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() const noexcept
+        {
+            return {};
+        }
+
+        void return_void() const noexcept
+        {
+        }
+
+        void unhandled_exception() const noexcept
+        {
+            std::terminate();
+        }
+    };
+
+    std::coroutine_handle<promise_type> handle;
+};
+
+template <typename ValueType, typename CompletionType>
+SpawnedTask runSpawned(IOContext &context, Task<ValueType> task, CompletionType completion)
+{
+    std::exception_ptr exception;
+
+    if constexpr (std::is_void_v<ValueType>)
+    {
+        try
+        {
+            co_await std::move(task);
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+        completion(exception);
+    }
+    else
+    {
+        std::optional<ValueType> value;
+        try
+        {
+            value.emplace(co_await std::move(task));
+        }
+        catch (...)
+        {
+            exception = std::current_exception();
+        }
+        completion(exception, value.has_value() ? std::move(*value) : ValueType());
+    }
+
+    context.dec_work();
+}
+
+// Starts the task on a run() thread of the context; the context keeps running until the task has finished.
+// completion is called as completion(exception) for Task<void> and completion(exception, value) otherwise.
+template <typename ValueType, typename CompletionType>
+void co_spawn(IOContext &context, Task<ValueType> task, CompletionType completion)
+{
+    context.inc_work();
+    const auto spawned = runSpawned(context, std::move(task), std::move(completion));
+    context.post([handle = spawned.handle]
+                 { handle.resume(); });
+}
+
+// Exceptions escaping a detached task are dropped.
+inline void co_spawn(IOContext &context, Task<void> task)
+{
+    co_spawn(context, std::move(task), [](std::exception_ptr) {});
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstddef>
+
+#include "exchange_rates.hpp"
+
+class CrossRateMatrix
+{
+public:
+    using index_type = std::size_t;
+    using rate_type = double;
+
+    static constexpr const char *BASE_CURRENCY = "RUB";
+
+    CrossRateMatrix() = default;
+
+    explicit CrossRateMatrix(const rates_table_type &table);
+
+    CrossRateMatrix(const CrossRateMatrix &other) = default;
+    CrossRateMatrix &operator=(const CrossRateMatrix &other) = default;
+
+    CrossRateMatrix(CrossRateMatrix &&other) noexcept = default;
+    CrossRateMatrix &operator=(CrossRateMatrix &&other) noexcept = default;
+
+    virtual ~CrossRateMatrix() = default;
+
+    void rebuild(const rates_table_type &table);
+
+    // Recomputes only the rows and columns of currencies whose Value / Nominal changed.
+    // Falls back to rebuild() when the set of currencies differs. Returns the number of changed currencies.
+    std::size_t update(const rates_table_type &table);
+
+    [[nodiscard]] inline std::size_t size() const noexcept
+    {
+        return codesField.size();
+    }
+
+    [[nodiscard]] inline bool empty() const noexcept
+    {
+        return codesField.empty();
+    }
+
+    [[nodiscard]] inline const std::vector<std::string> &codes() const noexcept
+    {
+        return codesField;
+    }
+
+    // Amount of `to` currency for one unit of `from` currency.
+    [[nodiscard]] inline rate_type rate(const index_type &from, const index_type &to) const noexcept
+    {
+        return matrixField[from * strideField + to];
+    }
+
+    [[nodiscard]] rate_type rate(const std::string &from, const std::string &to) const;
+
+    [[nodiscard]] std::optional<index_type> index_of(const std::string &code) const noexcept;
+
+    [[nodiscard]] inline const rate_type *row(const index_type &from) const noexcept
+    {
+        return matrixField.data() + from * strideField;
+    }
+
+private:
+    std::vector<std::string> codesField;
+    std::unordered_map<std::string, index_type> indexField;
+    std::vector<rate_type> unitRatesField;
+    std::vector<rate_type> inverseRatesField;
+    std::vector<rate_type> matrixField;
+    std::size_t strideField = 0;
+
+    void recompute_row(const index_type &from);
+};
+
+[[nodiscard]] CrossRateMatrix::rate_type unitRate(const Valute &valute);
@@ -93,8 +93,20 @@ public:
 
     EpollStatus remove(const descriptor_type &descriptor, const event_type &event);
 
+    // Registers the descriptor with an arbitrary 64-bit tag in data.u64 instead of data.fd.
+    EpollStatus add_tagged(const descriptor_type &descriptor, const event_type &event, const uint64_t &tag);
+
+    EpollStatus mod_tagged(const descriptor_type &descriptor, const event_type &event, const uint64_t &tag);
+
     EpollStatus wait(const int &timeout, int &count);
 
+    // Waits into a caller-owned buffer; several threads may wait on the same instance this way.
+    EpollStatus wait(const int &timeout, epoll_event_type *events, const int &maxEvents, int &count);
+
+    // Kernel busy polling of the NAPI contexts behind the registered sockets (EPIOCSPARAMS, Linux 6.9). Fails with
+    // ENOTTY on older kernels; a budget above 64 needs CAP_NET_ADMIN.
+    EpollStatus set_busy_poll(const uint32_t &microseconds, const uint16_t &budget, const bool &prefer);
+
     [[nodiscard]] inline epoll_event_type &at(const std::size_t &index)
     {
         if (index >= 0 && index < maxEpollEvents)
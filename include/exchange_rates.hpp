@@ -0,0 +1,42 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+
+struct Valute
+{
+    std::string ID;
+    int NumCode;
+    std::string CharCode;
+    int Nominal;
+    std::string Name;
+    float Value;
+    float VunitRate;
+};
+
+using rates_table_type = std::unordered_map<std::string, Valute>;
+
+// Days since 1970-01-01 in the proleptic Gregorian calendar.
+using day_type = int32_t;
+
+struct DatedValute
+{
+    day_type day;
+    Valute valute;
+};
+
+// One currency over a range of days, in the order cbr.ru returned them.
+using rates_history_type = std::vector<DatedValute>;
+
+[[nodiscard]] day_type dayFromCivil(int year, unsigned month, unsigned day) noexcept;
+
+// Accepts the cbr.ru date formats "dd/mm/yyyy" and "dd.mm.yyyy"; the day must exist in its month.
+[[nodiscard]] std::optional<day_type> parseCbrDate(const std::string &text) noexcept;
+
+[[nodiscard]] std::string formatCbrDate(const day_type &day);
+
+// Current date in Moscow (UTC+3), the calendar cbr.ru publishes rates in.
+[[nodiscard]] day_type currentCbrDay() noexcept;
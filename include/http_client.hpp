@@ -0,0 +1,84 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <system_error>
+
+#include "async_operations.hpp"
+#include "http_message.hpp"
+
+enum class ClientError
+{
+    CE_BAD_RESPONSE = 1,
+    CE_UNEXPECTED_STATUS,
+    CE_BAD_DOCUMENT
+};
+
+const std::error_category &clientErrorCategory() noexcept;
+
+std::error_code make_error_code(ClientError error) noexcept;
+
+namespace std
+{
+    template <>
+    struct is_error_code_enum<ClientError> : true_type
+    {
+    };
+}
+
+using http_response_handler_type = std::function<void(const std::error_code &, HttpResponse &&, std::size_t bodyBytes)>;
+
+// One request per connection ("Connection: close"); the response is read with async_read_chain() until the parser
+// reports completion.
+class HttpClient
+{
+public:
+    HttpClient(IOContext &context_, std::string ipAddress_, int port_, std::string host_);
+
+    HttpClient(const HttpClient &other) = delete;
+    HttpClient &operator=(const HttpClient &other) = delete;
+
+    virtual ~HttpClient() = default;
+
+    // With a body handler the decoded body is streamed to it and the response passed to the completion handler has an empty body.
+    void async_request(const std::string &method, const std::string &target, const http_headers_type &headers, http_response_handler_type handler,
+                       HttpResponseParser::body_handler_type bodyHandler = nullptr);
+
+    inline void async_get(const std::string &target, const http_headers_type &headers, http_response_handler_type handler,
+                          HttpResponseParser::body_handler_type bodyHandler = nullptr)
+    {
+        async_request("GET", target, headers, std::move(handler), std::move(bodyHandler));
+    }
+
+    // The result is std::tuple<HttpResponse, std::size_t bodyBytes>.
+    template <CompletionTag TokenType>
+    auto async_request(const std::string &method, const std::string &target, const http_headers_type &headers, TokenType token,
+                       HttpResponseParser::body_handler_type bodyHandler = nullptr)
+    {
+        return TokenCompletion<HttpResponse, std::size_t>::initiate(token, [&, bodyHandler = std::move(bodyHandler)](auto handler) mutable
+                                                                    { async_request(method, target, headers, std::move(handler), std::move(bodyHandler)); });
+    }
+
+    template <CompletionTag TokenType>
+    auto async_get(const std::string &target, const http_headers_type &headers, TokenType token,
+                   HttpResponseParser::body_handler_type bodyHandler = nullptr)
+    {
+        return async_request("GET", target, headers, token, std::move(bodyHandler));
+    }
+
+    [[nodiscard]] inline const std::string &host() const noexcept
+    {
+        return hostField;
+    }
+
+    [[nodiscard]] inline IOContext &get_context() const noexcept
+    {
+        return context;
+    }
+
+private:
+    IOContext &context;
+    std::string ipAddress;
+    int port;
+    std::string hostField;
+};
@@ -0,0 +1,157 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <functional>
+#include <cstddef>
+
+#include "content_decoder.hpp"
+
+using http_headers_type = std::vector<std::pair<std::string, std::string>>;
+
+struct HttpResponse
+{
+    int statusCode = 0;
+    std::string reason;
+    http_headers_type headers;
+    std::string body;
+
+    // Header names are stored in lower case.
+    [[nodiscard]] std::optional<std::string> header(const std::string &name) const;
+};
+
+struct HttpRequest
+{
+    std::string method;
+    std::string target;
+    int versionMinor = 1;
+    http_headers_type headers;
+
+    [[nodiscard]] std::optional<std::string> header(const std::string &name) const;
+
+    // HTTP/1.1 defaults to a persistent connection, HTTP/1.0 only with "Connection: keep-alive".
+    [[nodiscard]] bool keep_alive() const;
+};
+
+// Parses a request line and headers ending with an empty line, [begin, end) must not include the final "\r\n\r\n".
+[[nodiscard]] bool parseHttpRequestHead(const char *begin, const char *end, HttpRequest &request);
+
+enum class HttpParseStatus
+{
+    HP_NEED_MORE,
+    HP_COMPLETE,
+    HP_FAILED
+};
+
+std::string httpParseStatusToString(const HttpParseStatus &status);
+
+[[nodiscard]] std::string toLower(std::string text);
+
+[[nodiscard]] std::string buildHttpRequest(const std::string &method, const std::string &target, const std::string &host, const http_headers_type &headers);
+
+// Incremental HTTP/1.1 response parser: Content-Length, chunked and close-delimited bodies.
+// gzip/deflate bodies are inflated chunk by chunk on the way to the body handler (or to response().body if none is set).
+class HttpResponseParser
+{
+public:
+    using body_handler_type = std::function<void(const char *data, std::size_t size)>;
+
+    // Most of a Content-Length body reserved up front; a larger body grows as it arrives, so a bogus length cannot
+    // allocate on its own.
+    static constexpr std::size_t MAX_BODY_RESERVE = 1024 * 1024;
+
+    // A compressed body buffered in response().body fails the response once it inflates past this size.
+    static constexpr std::size_t MAX_DECODED_BODY_SIZE = 64 * 1024 * 1024;
+
+    HttpResponseParser() = default;
+
+    HttpResponseParser(const HttpResponseParser &other) = delete;
+    HttpResponseParser &operator=(const HttpResponseParser &other) = delete;
+
+    HttpResponseParser(HttpResponseParser &&other) = delete;
+    HttpResponseParser &operator=(HttpResponseParser &&other) = delete;
+
+    virtual ~HttpResponseParser() = default;
+
+    inline void set_body_handler(body_handler_type handler) noexcept
+    {
+        bodyHandler = std::move(handler);
+    }
+
+    inline void set_decode_content(bool decode) noexcept
+    {
+        decodeContent = decode;
+    }
+
+    // Applies only without a body handler, which sees the decoded body piece by piece and can stop on its own.
+    inline void set_max_decoded_body_size(std::size_t size) noexcept
+    {
+        maxDecodedBodySize = size;
+    }
+
+    HttpParseStatus feed(const char *data, std::size_t size);
+
+    // Called when the peer closed the connection.
+    HttpParseStatus finish();
+
+    [[nodiscard]] inline HttpParseStatus status() const noexcept
+    {
+        return statusField;
+    }
+
+    [[nodiscard]] inline const HttpResponse &response() const noexcept
+    {
+        return responseField;
+    }
+
+    [[nodiscard]] inline HttpResponse &response() noexcept
+    {
+        return responseField;
+    }
+
+    // Raw body bytes received from the wire, before any transfer or content decoding.
+    [[nodiscard]] inline std::size_t body_bytes() const noexcept
+    {
+        return bodyBytesField;
+    }
+
+    [[nodiscard]] inline ContentEncoding content_encoding() const noexcept
+    {
+        return decoder ? decoder->encoding() : ContentEncoding::IDENTITY;
+    }
+
+private:
+    enum class State
+    {
+        STATUS_LINE,
+        HEADERS,
+        BODY_LENGTH,
+        BODY_UNTIL_CLOSE,
+        CHUNK_SIZE,
+        CHUNK_DATA,
+        CHUNK_DATA_END,
+        TRAILERS,
+        DONE
+    };
+
+    State state = State::STATUS_LINE;
+    HttpParseStatus statusField = HttpParseStatus::HP_NEED_MORE;
+    HttpResponse responseField;
+    std::string lineBuffer;
+    std::size_t remaining = 0;
+    std::size_t bodyBytesField = 0;
+    body_handler_type bodyHandler;
+    std::unique_ptr<ContentDecoder> decoder;
+    bool decodeContent = true;
+    std::size_t maxDecodedBodySize = MAX_DECODED_BODY_SIZE;
+
+    bool parse_line(const std::string &line);
+    bool start_body();
+    bool append_body(const char *data, std::size_t size);
+    void deliver_body(const char *data, std::size_t size);
+    HttpParseStatus complete();
+    HttpParseStatus fail();
+};
@@ -0,0 +1,155 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "latency_histogram.hpp"
+
+enum class IOCounter
+{
+    WAITS,
+    EVENTS,
+    WAKEUPS,
+    TASKS,
+    TIMERS,
+    COMPLETIONS,
+    CANCELLATIONS,
+    BYTES_READ,
+    BYTES_WRITTEN,
+    BUSY_POLLS,
+    BUSY_POLL_HITS,
+    SPIN_NANOSECONDS,
+    SLEEP_NANOSECONDS,
+    COUNT
+};
+
+// Point-in-time view of an IOContext. Counters are totals since construction, gauges are sampled when the snapshot
+// is taken, histograms hold every value recorded so far (durations in nanoseconds).
+struct IOMetricsSnapshot
+{
+    uint64_t waits = 0;
+    uint64_t events = 0;
+    uint64_t wakeups = 0;
+    uint64_t tasksExecuted = 0;
+    uint64_t timersFired = 0;
+    uint64_t operationsCompleted = 0;
+    uint64_t operationsCanceled = 0;
+    uint64_t bytesRead = 0;
+    uint64_t bytesWritten = 0;
+
+    // Busy-poll mode only: non-blocking waits while spinning, those that returned events, and the time spent
+    // spinning versus blocked in epoll_wait.
+    uint64_t busyPolls = 0;
+    uint64_t busyPollHits = 0;
+    uint64_t spinNanoseconds = 0;
+    uint64_t sleepNanoseconds = 0;
+
+    std::size_t queuedTasks = 0;
+    std::size_t pendingOperations = 0;
+    std::size_t pendingTimers = 0;
+    std::size_t outstandingWork = 0;
+    std::size_t runningThreads = 0;
+    uint64_t busyPollMicroseconds = 0;
+
+    LatencyHistogram eventsPerWait;
+    LatencyHistogram taskTime;
+    LatencyHistogram handlerTime;
+
+    [[nodiscard]] inline double events_per_wait() const noexcept
+    {
+        return waits == 0 ? 0.0 : static_cast<double>(events) / waits;
+    }
+
+    // Share of the waiting time spent spinning.
+    [[nodiscard]] inline double spin_ratio() const noexcept
+    {
+        const auto total = spinNanoseconds + sleepNanoseconds;
+        return total == 0 ? 0.0 : static_cast<double>(spinNanoseconds) / total;
+    }
+};
+
+// Histogram with atomic buckets in the LatencyHistogram layout: a single thread records, any thread may read.
+class AtomicHistogram
+{
+public:
+    explicit AtomicHistogram(uint64_t maxValue_);
+
+    AtomicHistogram(const AtomicHistogram &other) = delete;
+    AtomicHistogram &operator=(const AtomicHistogram &other) = delete;
+
+    virtual ~AtomicHistogram() = default;
+
+    // Owner thread only.
+    inline void record(uint64_t value) noexcept
+    {
+        auto &bucket = buckets[LatencyHistogram::bucket_index(value < maxValue ? value : maxValue)];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    void add_to(LatencyHistogram &histogram) const noexcept;
+
+private:
+    uint64_t maxValue;
+    std::unique_ptr<std::atomic<uint64_t>[]> buckets;
+    std::size_t bucketsCount;
+};
+
+// Metrics storage of one IOContext, sharded per thread. A run() thread owns its shard and is its only writer, so
+// recording is a relaxed load and store without a locked instruction. Threads outside run() share one extra shard
+// updated with fetch_add. Snapshots sum the shards while the loop keeps running.
+class IOMetrics
+{
+public:
+    static constexpr uint64_t MAX_RECORDED_DURATION = uint64_t(1) << 36;
+    static constexpr uint64_t MAX_RECORDED_EVENTS = 1 << 16;
+
+    struct alignas(64) Shard
+    {
+        explicit Shard(bool owned_);
+
+        const bool owned;
+        std::array<std::atomic<uint64_t>, static_cast<std::size_t>(IOCounter::COUNT)> counters{};
+        AtomicHistogram eventsPerWait;
+        AtomicHistogram taskTime;
+        AtomicHistogram handlerTime;
+
+        inline void add(IOCounter counter, uint64_t value) noexcept
+        {
+            auto &cell = counters[static_cast<std::size_t>(counter)];
+            if (owned)
+                cell.store(cell.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+            else
+                cell.fetch_add(value, std::memory_order_relaxed);
+        }
+    };
+
+    IOMetrics();
+
+    IOMetrics(const IOMetrics &other) = delete;
+    IOMetrics &operator=(const IOMetrics &other) = delete;
+
+    virtual ~IOMetrics() = default;
+
+    // Shard owned by the calling thread, created on its first run().
+    [[nodiscard]] Shard &thread_shard();
+
+    [[nodiscard]] inline Shard &shared_shard() noexcept
+    {
+        return *sharedShard;
+    }
+
+    // Adds the counters and histograms of every shard to the snapshot; gauges are left to the caller.
+    void collect(IOMetricsSnapshot &snapshot) const;
+
+private:
+    mutable std::mutex shardsMutex;
+    std::unordered_map<std::thread::id, std::unique_ptr<Shard>> shardsField;
+    std::unique_ptr<Shard> sharedShard;
+};
@@ -0,0 +1,64 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+// Log-linear histogram in the style of HdrHistogram: values below 2^SUB_BUCKET_BITS are counted exactly, larger values
+// are grouped by power of two and every group is split into 2^(SUB_BUCKET_BITS - 1) linear sub-buckets, so a reported
+// value is never more than 1/128 above the recorded one. Recording is a few shifts and an increment. Not thread-safe:
+// keep one histogram per thread and merge them for reporting.
+class LatencyHistogram
+{
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 8;
+
+    // Values above maxValue are counted as maxValue. The default covers about 68 seconds in nanoseconds.
+    explicit LatencyHistogram(uint64_t maxValue_ = uint64_t(1) << 36);
+
+    void record(uint64_t value) noexcept;
+
+    void record(uint64_t value, uint64_t count) noexcept;
+
+    // Both histograms must have the same maximum.
+    void merge(const LatencyHistogram &other) noexcept;
+
+    void reset() noexcept;
+
+    // Highest value equivalent to the one at the percentile, in [0, 100]; 0 for an empty histogram.
+    [[nodiscard]] uint64_t value_at_percentile(double percentile) const noexcept;
+
+    [[nodiscard]] double mean() const noexcept;
+
+    [[nodiscard]] inline uint64_t count() const noexcept
+    {
+        return countField;
+    }
+
+    [[nodiscard]] inline uint64_t min() const noexcept
+    {
+        return countField == 0 ? 0 : minField;
+    }
+
+    [[nodiscard]] inline uint64_t max() const noexcept
+    {
+        return maxField;
+    }
+
+    [[nodiscard]] inline uint64_t max_value() const noexcept
+    {
+        return maxValue;
+    }
+
+    // Bucket layout, shared with histograms that keep their counts elsewhere (e.g. in atomics).
+    [[nodiscard]] static std::size_t bucket_index(uint64_t value) noexcept;
+
+    [[nodiscard]] static uint64_t highest_equivalent_value(std::size_t index) noexcept;
+
+private:
+    uint64_t maxValue;
+    std::vector<uint64_t> counts;
+    uint64_t countField = 0;
+    uint64_t minField = UINT64_MAX;
+    uint64_t maxField = 0;
+};
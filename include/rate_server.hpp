@@ -0,0 +1,90 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+
+#include "async_operations.hpp"
+#include "exchange_rates.hpp"
+#include "http_message.hpp"
+
+// Responses for every route, serialized once per data refresh. Immutable after construction.
+class RateSnapshot
+{
+public:
+    RateSnapshot(const rates_table_type &table, const day_type &day);
+
+    RateSnapshot(const RateSnapshot &other) = delete;
+    RateSnapshot &operator=(const RateSnapshot &other) = delete;
+
+    virtual ~RateSnapshot() = default;
+
+    // Complete HTTP response (status line, headers and JSON body) for /rates, /rates/{code} or /cross/{a}/{b}.
+    [[nodiscard]] const std::string *find(const std::string &target) const noexcept;
+
+    [[nodiscard]] inline const day_type &day() const noexcept
+    {
+        return dayField;
+    }
+
+    [[nodiscard]] inline std::size_t responses_count() const noexcept
+    {
+        return responsesField.size();
+    }
+
+private:
+    day_type dayField;
+    std::unordered_map<std::string, std::string> responsesField;
+};
+
+// HTTP/1.1 server for the last fetched rates. Keep-alive and pipelining are supported: every batch of pipelined
+// requests found in one read is answered with a single write.
+class RateServer
+{
+public:
+    using snapshot_pointer = std::shared_ptr<const RateSnapshot>;
+
+    static constexpr std::size_t READ_BUFFER_SIZE = 16 * 1024;
+    static constexpr std::size_t MAX_REQUEST_SIZE = 64 * 1024;
+
+    RateServer(IOContext &context_, EndpointIPv4 &endpoint, bool reusePort = false);
+
+    RateServer(const RateServer &other) = delete;
+    RateServer &operator=(const RateServer &other) = delete;
+
+    // Stops the server. Connections still open then keep the shared state alive until their handlers have run, the
+    // context must outlive them.
+    virtual ~RateServer();
+
+    void start();
+
+    // Stops accepting and shuts down open connections; their pending reads complete and the connections are released.
+    void stop();
+
+    // Serializes the table into a new snapshot and publishes it; requests in flight keep the previous one.
+    void update(const rates_table_type &table, const day_type &day);
+
+    [[nodiscard]] snapshot_pointer snapshot() const noexcept;
+
+    [[nodiscard]] inline int local_port() const
+    {
+        return acceptor->local_port();
+    }
+
+    [[nodiscard]] std::size_t requests_served() const noexcept;
+
+    [[nodiscard]] std::size_t connections_count() const;
+
+private:
+    class Connection;
+    struct State;
+
+    std::shared_ptr<State> state;
+    // Shared with the pending accept, whose handler may still be running on a run() thread when the server is gone.
+    std::shared_ptr<TCPAsyncAcceptor> acceptor;
+
+    // Takes only what the accept handler keeps using, never the server itself.
+    static void accept_next(const std::shared_ptr<State> &state, const std::shared_ptr<TCPAsyncAcceptor> &acceptor);
+};
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <string>
+#include <functional>
+#include <stdexcept>
+#include <cstddef>
+
+#include "exchange_rates.hpp"
+
+// Parses the ValCurs document returned by XML_daily.asp. Throws std::runtime_error on a malformed document.
+[[nodiscard]] rates_table_type parseDailyRates(std::string document);
+
+// cbr.ru writes decimals with a comma ("80,1234").
+[[nodiscard]] float parseCbrDecimal(const char *text, std::size_t size);
+
+// Streaming parser for the ValCurs/Record documents returned by XML_dynamic.asp.
+// Chunks may be split anywhere; every complete <Record> is handed to the handler, only the unfinished tail is buffered.
+class DynamicRatesParser
+{
+public:
+    using record_handler_type = std::function<void(DatedValute &&record)>;
+
+    static constexpr std::size_t MAX_PENDING_SIZE = 64 * 1024;
+
+    explicit DynamicRatesParser(record_handler_type handler_);
+
+    DynamicRatesParser(const DynamicRatesParser &other) = delete;
+    DynamicRatesParser &operator=(const DynamicRatesParser &other) = delete;
+
+    virtual ~DynamicRatesParser() = default;
+
+    // Returns false once the document is known to be malformed.
+    bool feed(const char *data, std::size_t size);
+
+    // Returns true if a complete ValCurs document was parsed.
+    [[nodiscard]] bool finish() const noexcept;
+
+    [[nodiscard]] inline std::size_t records_count() const noexcept
+    {
+        return recordsCount;
+    }
+
+private:
+    record_handler_type handler;
+    std::string pending;
+    std::string element;
+    std::string text;
+    DatedValute record;
+    bool insideRoot = false;
+    bool rootClosed = false;
+    bool insideRecord = false;
+    bool hasValue = false;
+    bool failed = false;
+    std::size_t recordsCount = 0;
+
+    bool handle_tag(const char *begin, const char *end);
+    bool start_record(const std::string &attributes);
+    bool end_element(const std::string &name);
+};
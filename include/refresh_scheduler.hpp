@@ -0,0 +1,101 @@
+#pragma once
+
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <random>
+#include <vector>
+#include <functional>
+#include <system_error>
+
+#include "async_operations.hpp"
+#include "cbr_client.hpp"
+
+struct RefreshPolicy
+{
+    using duration_type = std::chrono::milliseconds;
+
+    duration_type interval = std::chrono::minutes(30);
+
+    // cbr.ru publishes the next rates on working days in the afternoon, Moscow time.
+    duration_type publicationTime = std::chrono::hours(15) + std::chrono::minutes(30);
+    duration_type publicationWindow = std::chrono::minutes(45);
+    duration_type publicationInterval = std::chrono::minutes(2);
+
+    // Failed refreshes are retried sooner than the regular interval.
+    duration_type retryInterval = std::chrono::seconds(30);
+
+    // Every delay is spread by +-jitter of itself, so that several instances do not poll in lockstep.
+    double jitter = 0.1;
+};
+
+// Delay before the next refresh at the given Moscow time of day, without jitter. Inside the publication window the
+// short interval is used, outside of it a regular refresh never skips over the start of the window.
+[[nodiscard]] RefreshPolicy::duration_type refreshDelay(const RefreshPolicy &policy, RefreshPolicy::duration_type timeOfDay);
+
+// Keeps the daily tables of the configured days fresh in the background on timers of the IOContext. Readers get the
+// last good table without blocking; a refreshed table is swapped in atomically and failures keep the previous one.
+// Queries are added before start(); stop() the scheduler and let the context finish pending fetches before destroying it.
+class RefreshScheduler
+{
+public:
+    using query_type = std::size_t;
+    using update_handler_type = std::function<void(query_type query, const day_type &day, rates_pointer rates)>;
+
+    RefreshScheduler(IOContext &context_, CbrClient &client_, RefreshPolicy policy_ = RefreshPolicy());
+
+    RefreshScheduler(const RefreshScheduler &other) = delete;
+    RefreshScheduler &operator=(const RefreshScheduler &other) = delete;
+
+    virtual ~RefreshScheduler();
+
+    // Daily rates of the current Moscow day shifted by dayOffset, tomorrow's table is published in advance.
+    query_type add_daily(int dayOffset = 0);
+
+    // Called on a run() thread whenever a query gets a new table.
+    void set_update_handler(update_handler_type handler);
+
+    // Refreshes every query right away and then on schedule until stop().
+    void start();
+
+    void stop();
+
+    // Last good table of the query or nullptr before the first successful refresh. Never blocks.
+    [[nodiscard]] rates_pointer rates(query_type query) const noexcept;
+
+    [[nodiscard]] inline uint64_t refreshes() const noexcept
+    {
+        return refreshesField.load(std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline uint64_t failures() const noexcept
+    {
+        return failuresField.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct Query
+    {
+        query_type index = 0;
+        int dayOffset = 0;
+        rates_pointer rates;
+        IOContext::timer_id_type timer = 0;
+    };
+
+    IOContext &context;
+    CbrClient &client;
+    RefreshPolicy policy;
+
+    std::vector<std::unique_ptr<Query>> queries;
+    update_handler_type updateHandler;
+    std::atomic<bool> running{false};
+    std::atomic<uint64_t> refreshesField{0};
+    std::atomic<uint64_t> failuresField{0};
+
+    std::mutex scheduleMutex;
+    std::mt19937 generator{std::random_device{}()};
+
+    void refresh(Query &query);
+    void schedule(Query &query, RefreshPolicy::duration_type delay);
+};
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <string>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <optional>
+#include <unordered_map>
+#include <cstdint>
+
+#include "exchange_rates.hpp"
+
+using rates_pointer = std::shared_ptr<const rates_table_type>;
+using history_pointer = std::shared_ptr<const rates_history_type>;
+
+struct CachedResponse
+{
+    std::string etag;
+    std::string lastModified;
+    rates_pointer rates;
+    history_pointer history;
+    std::size_t bodySize = 0;
+    bool immutable = false;
+};
+
+struct CacheStatistics
+{
+    uint64_t hits = 0;
+    uint64_t notModified = 0;
+    uint64_t misses = 0;
+    uint64_t bytesSaved = 0;
+
+    // Requests answered without downloading the body (immutable hits and 304 revalidations).
+    [[nodiscard]] inline double hit_ratio() const noexcept
+    {
+        const auto total = hits + notModified + misses;
+        return total == 0 ? 0.0 : static_cast<double>(hits + notModified) / total;
+    }
+};
+
+// Parsed responses keyed by request URI together with their HTTP validators. Thread-safe.
+class ResponseCache
+{
+public:
+    ResponseCache() = default;
+
+    ResponseCache(const ResponseCache &other) = delete;
+    ResponseCache &operator=(const ResponseCache &other) = delete;
+
+    virtual ~ResponseCache() = default;
+
+    [[nodiscard]] std::optional<CachedResponse> find(const std::string &uri) const;
+
+    void store(const std::string &uri, CachedResponse response);
+
+    void erase(const std::string &uri);
+
+    void clear();
+
+    [[nodiscard]] std::size_t size() const;
+
+    void record_hit(const CachedResponse &response) noexcept;
+
+    void record_not_modified(const CachedResponse &response) noexcept;
+
+    void record_miss() noexcept;
+
+    [[nodiscard]] CacheStatistics statistics() const noexcept;
+
+private:
+    mutable std::mutex entriesMutex;
+    std::unordered_map<std::string, CachedResponse> entriesField;
+
+    std::atomic<uint64_t> hitsField{0};
+    std::atomic<uint64_t> notModifiedField{0};
+    std::atomic<uint64_t> missesField{0};
+    std::atomic<uint64_t> bytesSavedField{0};
+};
@@ -29,20 +29,5 @@ enum class LogLevel
 
 [[nodiscard]] std::string logLevelToString(const LogLevel& logLevel);
 
-class ConsoleLogger
-{
-    public:
-
-    ConsoleLogger(ConsoleLogger&& other) noexcept = default;
-    ConsoleLogger& operator = (ConsoleLogger&& other) noexcept = default;
-
-    static ConsoleLogger& getLogger();
-
-    static void loggingMessage(const LogLevel& logLevel, const std::string& message);
-
-    private:
-
-    ConsoleLogger(){}
-    ConsoleLogger(const ConsoleLogger& other) = default;
-    ConsoleLogger& operator = (const ConsoleLogger& other) = default;
-};
\ No newline at end of file
+// Currency names of the CBR documents are windows-1251; returns the input unchanged if iconv has no converter.
+[[nodiscard]] std::string win1251_to_utf8_impl(const std::string& input);
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <system_error>
+#include <cstdint>
+
+// Coalesces concurrent operations with the same key: the first caller runs the operation, later callers are attached
+// to it and every handler receives the same result. Thread-safe.
+template <typename ResultType>
+class SingleFlight
+{
+public:
+    using result_type = ResultType;
+    using handler_type = std::function<void(const std::error_code &, const result_type &)>;
+
+    SingleFlight() = default;
+
+    SingleFlight(const SingleFlight &other) = delete;
+    SingleFlight &operator=(const SingleFlight &other) = delete;
+
+    virtual ~SingleFlight() = default;
+
+    // Returns true when the caller is the first one for the key and has to start the operation and call complete().
+    [[nodiscard]] bool join(const std::string &key, handler_type handler)
+    {
+        std::lock_guard lock(flightsMutex);
+        auto [iter, inserted] = flightsField.try_emplace(key);
+        iter->second.push_back(std::move(handler));
+        if (!inserted)
+            coalescedField.fetch_add(1, std::memory_order_relaxed);
+        return inserted;
+    }
+
+    // Detaches the waiters before invoking them, so a handler may start a new operation with the same key.
+    void complete(const std::string &key, const std::error_code &error, const result_type &result)
+    {
+        std::vector<handler_type> handlers;
+        {
+            std::lock_guard lock(flightsMutex);
+            auto iter = flightsField.find(key);
+            if (iter == flightsField.end())
+                return;
+
+            handlers = std::move(iter->second);
+            flightsField.erase(iter);
+        }
+
+        for (auto &handler : handlers)
+        {
+            handler(error, result);
+        }
+    }
+
+    [[nodiscard]] std::size_t in_flight() const
+    {
+        std::lock_guard lock(flightsMutex);
+        return flightsField.size();
+    }
+
+    // Callers that were attached to an operation already in flight.
+    [[nodiscard]] inline uint64_t coalesced() const noexcept
+    {
+        return coalescedField.load(std::memory_order_relaxed);
+    }
+
+private:
+    mutable std::mutex flightsMutex;
+    std::unordered_map<std::string, std::vector<handler_type>> flightsField;
+    std::atomic<uint64_t> coalescedField{0};
+};
@@ -0,0 +1,53 @@
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <functional>
+
+#include "async_operations.hpp"
+
+// Serializing executor on top of a multi-threaded IOContext: handlers posted to the same strand never run concurrently
+// and run in the order they were posted. Posting takes no lock: a Vyukov MPSC queue with one heap node per task plus a
+// pending counter; the poster that moves the counter from zero schedules a drain on the context. A task that throws
+// leaves through run(), the tasks behind it stay queued for the next run(). Copies share the same strand.
+class Strand
+{
+public:
+    using task_type = IOContext::task_type;
+
+    // Handlers executed per drain before the strand yields its run() thread to other work.
+    static constexpr std::size_t MAX_BATCH_SIZE = 64;
+
+    explicit Strand(IOContext &context_);
+
+    Strand(const Strand &other) = default;
+    Strand &operator=(const Strand &other) = default;
+
+    Strand(Strand &&other) noexcept = default;
+    Strand &operator=(Strand &&other) noexcept = default;
+
+    virtual ~Strand() = default;
+
+    void post(task_type task) const;
+
+    // Runs the task inline when the calling thread is already executing this strand, posts it otherwise.
+    void dispatch(task_type task) const;
+
+    [[nodiscard]] bool running_in_this_thread() const noexcept;
+
+    // Wraps a completion handler so that it is executed on the strand, e.g. socket.async_read(buffer, strand.wrap(handler)).
+    template <typename HandlerType>
+    [[nodiscard]] auto wrap(HandlerType handler) const
+    {
+        return [strand = *this, handler = std::move(handler)](const auto &...arguments)
+        {
+            strand.post([handler, arguments...]() mutable
+                        { handler(arguments...); });
+        };
+    }
+
+private:
+    struct State;
+
+    std::shared_ptr<State> state;
+};
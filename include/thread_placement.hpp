@@ -0,0 +1,70 @@
+#pragma once
+
+#include <string>
+#include <system_error>
+#include <vector>
+#include <cstddef>
+
+// Parses the kernel CPU list format ("0-3,8,10-11"); malformed parts are skipped.
+std::vector<int> parseCpuList(const std::string &text);
+
+struct NumaNode
+{
+    int id;
+    std::vector<int> cpus;
+};
+
+// CPUs the process may run on, grouped by NUMA node.
+class CpuTopology
+{
+public:
+    explicit CpuTopology(std::vector<NumaNode> nodes_);
+
+    // Read once from /sys/devices/system/node and the affinity mask of the process; a single node when the node
+    // directory is missing.
+    static const CpuTopology &system();
+
+    [[nodiscard]] inline const std::vector<NumaNode> &nodes() const noexcept
+    {
+        return nodesField;
+    }
+
+    // -1 for a CPU the process may not use.
+    [[nodiscard]] int node_of(int cpu) const noexcept;
+
+private:
+    std::vector<NumaNode> nodesField;
+};
+
+enum class PlacementPolicy
+{
+    // Threads run wherever the scheduler puts them.
+    NONE,
+    // Thread i on the i-th CPU, filling one node before the next: threads share caches.
+    COMPACT,
+    // Threads alternate between nodes: more memory bandwidth, less sharing.
+    SPREAD
+};
+
+// Where the threads of a pool run. Pinned threads also prefer memory of their node, so whatever they allocate for
+// themselves (event batch, metrics shard, trace and log buffers, grown deques) is local to the CPU that uses it.
+struct ThreadPlacement
+{
+    PlacementPolicy policy = PlacementPolicy::NONE;
+    // Explicit CPU sets, thread i runs on cpuSets[i % size]; takes precedence over the policy.
+    std::vector<std::vector<int>> cpuSets;
+    bool localMemory = true;
+
+    static ThreadPlacement compact();
+
+    static ThreadPlacement spread();
+
+    static ThreadPlacement cpus(std::vector<std::vector<int>> cpuSets_);
+
+    // CPUs of thread `index`; empty when it is not pinned.
+    [[nodiscard]] std::vector<int> cpus_for(std::size_t index, const CpuTopology &topology = CpuTopology::system()) const;
+};
+
+// Pins the calling thread to the CPUs and, with localMemory, makes it prefer their NUMA node for new pages when they
+// all belong to one node of a multi-node machine. An empty set leaves the thread alone.
+std::error_code placeCurrentThread(const std::vector<int> &cpus, bool localMemory = true, const CpuTopology &topology = CpuTopology::system());
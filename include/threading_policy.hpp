@@ -0,0 +1,97 @@
+#pragma once
+
+#include <atomic>
+#include <mutex>
+
+// Threading policies of BasicIOContext and BasicTCPAsyncSocket. A policy names the mutex and the counter types the
+// context keeps its state in and says whether other threads may touch it.
+
+// Any number of threads may call run() and post from anywhere.
+struct MultiThreaded
+{
+    static constexpr bool concurrent = true;
+
+    using mutex_type = std::mutex;
+
+    template <typename ValueType>
+    using atomic_type = std::atomic<ValueType>;
+};
+
+// Satisfies Lockable and does nothing.
+class NullMutex
+{
+public:
+    constexpr void lock() noexcept
+    {
+    }
+
+    constexpr bool try_lock() noexcept
+    {
+        return true;
+    }
+
+    constexpr void unlock() noexcept
+    {
+    }
+};
+
+// The part of the std::atomic interface the context uses, as plain loads and stores: no locked instructions and no
+// fences, and the compiler may keep the value in a register.
+template <typename ValueType>
+class PlainAtomic
+{
+public:
+    constexpr PlainAtomic(ValueType value_ = ValueType()) noexcept : value(value_)
+    {
+    }
+
+    PlainAtomic(const PlainAtomic &other) = delete;
+    PlainAtomic &operator=(const PlainAtomic &other) = delete;
+
+    [[nodiscard]] inline ValueType load(std::memory_order = std::memory_order_seq_cst) const noexcept
+    {
+        return value;
+    }
+
+    inline void store(ValueType value_, std::memory_order = std::memory_order_seq_cst) noexcept
+    {
+        value = value_;
+    }
+
+    inline ValueType exchange(ValueType value_, std::memory_order = std::memory_order_seq_cst) noexcept
+    {
+        const auto previous = value;
+        value = value_;
+        return previous;
+    }
+
+    inline ValueType fetch_add(ValueType delta, std::memory_order = std::memory_order_seq_cst) noexcept
+    {
+        const auto previous = value;
+        value += delta;
+        return previous;
+    }
+
+    inline ValueType fetch_sub(ValueType delta, std::memory_order = std::memory_order_seq_cst) noexcept
+    {
+        const auto previous = value;
+        value -= delta;
+        return previous;
+    }
+
+private:
+    ValueType value;
+};
+
+// One thread owns the context: it calls run() and everything else, including post(), cancel_operation() and the
+// socket operations, either from inside run() or while no run() is active. Nothing is locked, the counters are plain
+// integers and post() and dec_work() skip the wakeup write, since the only thread that could wait is the caller.
+struct SingleThreaded
+{
+    static constexpr bool concurrent = false;
+
+    using mutex_type = NullMutex;
+
+    template <typename ValueType>
+    using atomic_type = PlainAtomic<ValueType>;
+};
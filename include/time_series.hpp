@@ -0,0 +1,83 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <optional>
+#include <unordered_map>
+#include <stdexcept>
+#include <cstddef>
+
+#include "exchange_rates.hpp"
+
+struct RangeAggregate
+{
+    double min = 0.0;
+    double max = 0.0;
+    double mean = 0.0;
+    double first = 0.0;
+    double last = 0.0;
+    std::size_t count = 0;
+
+    [[nodiscard]] inline double change_percent() const noexcept
+    {
+        return first != 0.0 ? (last - first) / first * 100.0 : 0.0;
+    }
+};
+
+// Columnar history of unit rates (Value / Nominal), one contiguous array per currency over a shared axis of business days.
+// Not synchronized: appends and queries from different threads must be serialized by the caller.
+class RateTimeSeries
+{
+public:
+    using value_type = double;
+
+    static constexpr std::size_t BLOCK_SIZE = 256;
+
+    RateTimeSeries() = default;
+
+    RateTimeSeries(const RateTimeSeries &other) = default;
+    RateTimeSeries &operator=(const RateTimeSeries &other) = default;
+
+    RateTimeSeries(RateTimeSeries &&other) noexcept = default;
+    RateTimeSeries &operator=(RateTimeSeries &&other) noexcept = default;
+
+    virtual ~RateTimeSeries() = default;
+
+    // Days must be appended in increasing order; appending the last day again replaces its values.
+    // Currencies missing from a table carry their previous value forward.
+    void append(const day_type &day, const rates_table_type &table);
+
+    [[nodiscard]] std::optional<RangeAggregate> aggregate(const std::string &code, const day_type &from, const day_type &to) const;
+
+    [[nodiscard]] std::optional<value_type> last(const std::string &code) const noexcept;
+
+    [[nodiscard]] inline const std::vector<day_type> &days() const noexcept
+    {
+        return daysField;
+    }
+
+    [[nodiscard]] inline std::size_t currencies_count() const noexcept
+    {
+        return columnsField.size();
+    }
+
+private:
+    struct BlockSummary
+    {
+        value_type min;
+        value_type max;
+        value_type sum;
+    };
+
+    struct Column
+    {
+        std::size_t firstIndex = 0;
+        std::vector<value_type> values;
+        std::vector<BlockSummary> blocks;
+    };
+
+    std::vector<day_type> daysField;
+    std::unordered_map<std::string, Column> columnsField;
+
+    static void seal_block(Column &column);
+};
@@ -0,0 +1,255 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Tracing of the async operation lifecycle. With ASYNC_CONNECT_TRACING=0 (the default) the ASYNC_CONNECT_TRACE_* macros
+// expand to nothing and their arguments are not evaluated; configure with -DASYNC_CONNECT_TRACING=ON to record spans.
+#ifndef ASYNC_CONNECT_TRACING
+#define ASYNC_CONNECT_TRACING 0
+#endif
+
+// One Chrome trace event, timestamps in Tracer::now() ticks. Names and categories must be string literals, only the
+// pointers are stored.
+struct TraceEvent
+{
+    const char *name;
+    const char *category;
+    int64_t timestamp;
+    int64_t duration;
+    uint64_t id;
+    char phase;
+};
+
+// Events of one thread in fixed-size chunks that never move: the owning thread appends, write_json() reads up to the
+// published size while recording goes on.
+class TraceBuffer
+{
+public:
+    static constexpr std::size_t CHUNK_SIZE = 4096;
+    static constexpr std::size_t MAX_CHUNKS = 256;
+
+    explicit TraceBuffer(int threadId_);
+
+    TraceBuffer(const TraceBuffer &other) = delete;
+    TraceBuffer &operator=(const TraceBuffer &other) = delete;
+
+    virtual ~TraceBuffer();
+
+    // Owner thread only; false when the buffer holds CHUNK_SIZE * MAX_CHUNKS events.
+    inline bool append(const TraceEvent &event) noexcept
+    {
+        const auto size = sizeField.load(std::memory_order_relaxed);
+        auto *chunk = chunks[size / CHUNK_SIZE].load(std::memory_order_relaxed);
+        if (chunk == nullptr)
+        {
+            chunk = add_chunk(size / CHUNK_SIZE);
+            if (chunk == nullptr)
+                return false;
+        }
+        chunk[size % CHUNK_SIZE] = event;
+        sizeField.store(size + 1, std::memory_order_release);
+        return true;
+    }
+
+    [[nodiscard]] inline std::size_t size() const noexcept
+    {
+        return sizeField.load(std::memory_order_acquire);
+    }
+
+    [[nodiscard]] inline const TraceEvent &at(std::size_t index) const noexcept
+    {
+        return chunks[index / CHUNK_SIZE].load(std::memory_order_relaxed)[index % CHUNK_SIZE];
+    }
+
+    [[nodiscard]] inline int thread_id() const noexcept
+    {
+        return threadId;
+    }
+
+    // Empties the buffer but keeps its chunks, whose pages are then already mapped.
+    inline void reset() noexcept
+    {
+        sizeField.store(0, std::memory_order_relaxed);
+    }
+
+private:
+    TraceEvent *add_chunk(std::size_t index) noexcept;
+
+    int threadId;
+    std::array<std::atomic<TraceEvent *>, MAX_CHUNKS> chunks{};
+    std::atomic<std::size_t> sizeField{0};
+};
+
+// Collects trace events in per-thread buffers and writes them in the Chrome trace-event JSON format, which
+// chrome://tracing and ui.perfetto.dev open directly. Recording is a clock read and a store into the buffer of the
+// calling thread, without locks.
+class Tracer
+{
+public:
+    using clock_type = std::chrono::steady_clock;
+
+    static constexpr std::chrono::milliseconds CALIBRATION_TIME{10};
+
+    Tracer();
+
+    Tracer(const Tracer &other) = delete;
+    Tracer &operator=(const Tracer &other) = delete;
+
+    virtual ~Tracer() = default;
+
+    // Used by the ASYNC_CONNECT_TRACE_* macros.
+    static Tracer &global();
+
+    // Enabled on construction; a disabled tracer drops events after one relaxed load.
+    inline void set_enabled(bool enable) noexcept
+    {
+        enabledField.store(enable, std::memory_order_relaxed);
+    }
+
+    [[nodiscard]] inline bool enabled() const noexcept
+    {
+        return enabledField.load(std::memory_order_relaxed);
+    }
+
+    // Time stamp counter where there is one (a third cheaper than clock_gettime), steady_clock nanoseconds otherwise;
+    // write_json() converts to time since construction.
+    [[nodiscard]] static inline int64_t now() noexcept
+    {
+#if defined(__x86_64__) || defined(__i386__)
+        return static_cast<int64_t>(__rdtsc());
+#else
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(clock_type::now().time_since_epoch()).count();
+#endif
+    }
+
+    // A span on the calling thread ("X"), from start to now. A non-zero id is written as an argument.
+    inline void complete(const char *category, const char *name, int64_t start, uint64_t id = 0) noexcept
+    {
+        if (enabled())
+            record(TraceEvent{name, category, start, now() - start, id, 'X'});
+    }
+
+    // Async spans ("b", "n", "e") are matched by category and id, so they may begin and end on different threads.
+    inline void async_begin(const char *category, const char *name, uint64_t id) noexcept
+    {
+        if (enabled())
+            record(TraceEvent{name, category, now(), 0, id, 'b'});
+    }
+
+    inline void async_instant(const char *category, const char *name, uint64_t id) noexcept
+    {
+        if (enabled())
+            record(TraceEvent{name, category, now(), 0, id, 'n'});
+    }
+
+    inline void async_end(const char *category, const char *name, uint64_t id) noexcept
+    {
+        if (enabled())
+            record(TraceEvent{name, category, now(), 0, id, 'e'});
+    }
+
+    // Writes every event recorded so far, threads may keep recording meanwhile. Ticks are calibrated against
+    // steady_clock over the tracer's lifetime, within CALIBRATION_TIME of construction the call waits for it.
+    void write_json(std::ostream &stream) const;
+
+    bool write_json(const std::string &path) const;
+
+    // Events lost because a thread buffer was full.
+    [[nodiscard]] inline uint64_t dropped() const noexcept
+    {
+        return droppedField.load(std::memory_order_relaxed);
+    }
+
+    // Discards the recorded events and keeps the buffers for reuse: writing into them again avoids the page faults of
+    // fresh memory, which cost about as much as the span itself. No thread may record while this runs.
+    void clear();
+
+private:
+    // Buffer of the calling thread for the tracer it used last. Trivially destructible, so the access needs no
+    // initialisation guard; the tracer owns the buffer.
+    struct BufferCache
+    {
+        uint64_t tracerId;
+        TraceBuffer *buffer;
+    };
+
+    static inline thread_local BufferCache bufferCache{0, nullptr};
+
+    inline void record(const TraceEvent &event) noexcept
+    {
+        auto *buffer = bufferCache.tracerId == tracerId ? bufferCache.buffer : register_thread();
+        if (buffer == nullptr || !buffer->append(event))
+            droppedField.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Registers a buffer for the calling thread; nullptr if it cannot be allocated.
+    TraceBuffer *register_thread() noexcept;
+
+    const uint64_t tracerId;
+    const int64_t epoch;
+    const clock_type::time_point epochTime;
+    std::atomic<bool> enabledField{true};
+    std::atomic<uint64_t> droppedField{0};
+
+    mutable std::mutex buffersMutex;
+    std::vector<std::shared_ptr<TraceBuffer>> buffersField;
+};
+
+// Records a complete span from construction to destruction.
+class TraceSpan
+{
+public:
+    TraceSpan(Tracer &tracer_, const char *category_, const char *name_, uint64_t id_ = 0) noexcept : tracer(tracer_),
+                                                                                                       category(category_),
+                                                                                                       name(name_),
+                                                                                                       id(id_),
+                                                                                                       start(tracer_.enabled() ? Tracer::now() : 0)
+    {
+    }
+
+    TraceSpan(const TraceSpan &other) = delete;
+    TraceSpan &operator=(const TraceSpan &other) = delete;
+
+    ~TraceSpan()
+    {
+        if (start != 0)
+            tracer.complete(category, name, start, id);
+    }
+
+private:
+    Tracer &tracer;
+    const char *category;
+    const char *name;
+    uint64_t id;
+    int64_t start;
+};
+
+#if ASYNC_CONNECT_TRACING
+#define ASYNC_CONNECT_TRACE_CONCAT_IMPL(first, second) first##second
+#define ASYNC_CONNECT_TRACE_CONCAT(first, second) ASYNC_CONNECT_TRACE_CONCAT_IMPL(first, second)
+#define ASYNC_CONNECT_TRACE_SPAN(category, name) \
+    const TraceSpan ASYNC_CONNECT_TRACE_CONCAT(traceSpan, __LINE__)(Tracer::global(), category, name)
+#define ASYNC_CONNECT_TRACE_SPAN_ID(category, name, id) \
+    const TraceSpan ASYNC_CONNECT_TRACE_CONCAT(traceSpan, __LINE__)(Tracer::global(), category, name, id)
+#define ASYNC_CONNECT_TRACE_ASYNC_BEGIN(category, name, id) Tracer::global().async_begin(category, name, id)
+#define ASYNC_CONNECT_TRACE_ASYNC_INSTANT(category, name, id) Tracer::global().async_instant(category, name, id)
+#define ASYNC_CONNECT_TRACE_ASYNC_END(category, name, id) Tracer::global().async_end(category, name, id)
+#else
+#define ASYNC_CONNECT_TRACE_SPAN(category, name) ((void)0)
+#define ASYNC_CONNECT_TRACE_SPAN_ID(category, name, id) ((void)0)
+#define ASYNC_CONNECT_TRACE_ASYNC_BEGIN(category, name, id) ((void)0)
+#define ASYNC_CONNECT_TRACE_ASYNC_INSTANT(category, name, id) ((void)0)
+#define ASYNC_CONNECT_TRACE_ASYNC_END(category, name, id) ((void)0)
+#endif
@@ -0,0 +1,208 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+#include "thread_placement.hpp"
+
+// Chase-Lev work-stealing deque: the owner pushes and takes at the bottom, thieves steal from the top.
+// The ring grows on demand; retired rings are kept until the deque is destroyed because thieves may still read them.
+template <typename ValueType>
+class ChaseLevDeque
+{
+public:
+    static_assert(std::is_pointer_v<ValueType>, "ChaseLevDeque stores pointers");
+
+    explicit ChaseLevDeque(std::size_t capacity = 256) : ringField(new Ring(roundUpToPowerOfTwo(capacity)))
+    {
+        retiredRings.emplace_back(ringField.load(std::memory_order_relaxed));
+    }
+
+    ChaseLevDeque(const ChaseLevDeque &other) = delete;
+    ChaseLevDeque &operator=(const ChaseLevDeque &other) = delete;
+
+    virtual ~ChaseLevDeque() = default;
+
+    // Owner thread only.
+    void push(ValueType value)
+    {
+        const auto bottom = bottomField.load(std::memory_order_relaxed);
+        const auto top = topField.load(std::memory_order_acquire);
+        auto ring = ringField.load(std::memory_order_relaxed);
+
+        if (bottom - top > static_cast<int64_t>(ring->capacity) - 1)
+            ring = grow(ring, top, bottom);
+
+        ring->put(bottom, value);
+        std::atomic_thread_fence(std::memory_order_release);
+        bottomField.store(bottom + 1, std::memory_order_relaxed);
+    }
+
+    // Owner thread only; returns nullptr when empty.
+    ValueType take()
+    {
+        const auto bottom = bottomField.load(std::memory_order_relaxed) - 1;
+        auto ring = ringField.load(std::memory_order_relaxed);
+        bottomField.store(bottom, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        auto top = topField.load(std::memory_order_relaxed);
+
+        if (top > bottom)
+        {
+            bottomField.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+
+        ValueType value = ring->get(bottom);
+        if (top == bottom)
+        {
+            // Last element: race the thieves for it.
+            if (!topField.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                value = nullptr;
+            bottomField.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return value;
+    }
+
+    // Any thread; returns nullptr when empty or when another thief won the race.
+    ValueType steal()
+    {
+        auto top = topField.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        const auto bottom = bottomField.load(std::memory_order_acquire);
+
+        if (top >= bottom)
+            return nullptr;
+
+        auto ring = ringField.load(std::memory_order_acquire);
+        ValueType value = ring->get(top);
+        if (!topField.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+            return nullptr;
+        return value;
+    }
+
+    [[nodiscard]] std::size_t size_approx() const noexcept
+    {
+        const auto size = bottomField.load(std::memory_order_relaxed) - topField.load(std::memory_order_relaxed);
+        return size > 0 ? static_cast<std::size_t>(size) : 0;
+    }
+
+private:
+    struct Ring
+    {
+        explicit Ring(std::size_t capacity_) : capacity(capacity_), mask(capacity_ - 1), slots(new std::atomic<ValueType>[capacity_])
+        {
+        }
+
+        void put(int64_t index, ValueType value) noexcept
+        {
+            slots[index & mask].store(value, std::memory_order_relaxed);
+        }
+
+        ValueType get(int64_t index) const noexcept
+        {
+            return slots[index & mask].load(std::memory_order_relaxed);
+        }
+
+        std::size_t capacity;
+        std::size_t mask;
+        std::unique_ptr<std::atomic<ValueType>[]> slots;
+    };
+
+    alignas(64) std::atomic<int64_t> topField{0};
+    alignas(64) std::atomic<int64_t> bottomField{0};
+    std::atomic<Ring *> ringField;
+    std::vector<std::unique_ptr<Ring>> retiredRings;
+
+    static std::size_t roundUpToPowerOfTwo(std::size_t value) noexcept
+    {
+        std::size_t result = 2;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+
+    Ring *grow(Ring *ring, int64_t top, int64_t bottom)
+    {
+        auto larger = new Ring(ring->capacity * 2);
+        for (auto index = top; index < bottom; ++index)
+        {
+            larger->put(index, ring->get(index));
+        }
+        retiredRings.emplace_back(larger);
+        ringField.store(larger, std::memory_order_release);
+        return larger;
+    }
+};
+
+// CPU pool for work that must not run on reactor threads. Every worker owns a Chase-Lev deque: tasks submitted from a
+// worker go to its own deque, tasks from other threads go through a shared injection queue, idle workers steal.
+class WorkStealingPool
+{
+public:
+    using task_type = std::function<void()>;
+
+    explicit WorkStealingPool(std::size_t threads = std::thread::hardware_concurrency());
+
+    // Worker i is placed with placement.cpus_for(i) before it takes its first job; placement errors leave it unpinned.
+    WorkStealingPool(std::size_t threads, const ThreadPlacement &placement);
+
+    WorkStealingPool(const WorkStealingPool &other) = delete;
+    WorkStealingPool &operator=(const WorkStealingPool &other) = delete;
+
+    // Runs the queued tasks and joins the workers.
+    virtual ~WorkStealingPool();
+
+    // Tasks must not throw.
+    void submit(task_type task);
+
+    [[nodiscard]] inline std::size_t threads_count() const noexcept
+    {
+        return workers.size();
+    }
+
+    [[nodiscard]] inline uint64_t steals() const noexcept
+    {
+        return stealsField.load(std::memory_order_relaxed);
+    }
+
+    // Process-wide pool with one worker per hardware thread, created on first use.
+    [[nodiscard]] static WorkStealingPool &shared();
+
+private:
+    struct Job
+    {
+        task_type task;
+    };
+
+    struct Worker
+    {
+        ChaseLevDeque<Job *> deque;
+        std::thread thread;
+    };
+
+    std::vector<std::unique_ptr<Worker>> workers;
+
+    std::mutex injectionMutex;
+    std::deque<Job *> injectionQueue;
+
+    std::mutex sleepMutex;
+    std::condition_variable sleepCondition;
+    std::atomic<std::size_t> queuedJobs{0};
+    std::atomic<std::size_t> sleepingWorkers{0};
+    std::atomic<bool> stopping{false};
+    std::atomic<uint64_t> stealsField{0};
+
+    void start(std::size_t threads, const ThreadPlacement &placement);
+    void work(std::size_t index, const std::vector<int> &cpus, bool localMemory);
+    Job *find_job(std::size_t index);
+    void wake_worker();
+};
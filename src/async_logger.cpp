@@ -0,0 +1,285 @@
+#include "async_logger.hpp"
+
+#include <chrono>
+#include <cerrno>
+#include <cstdio>
+
+namespace
+{
+    std::atomic<uint64_t> nextLoggerId{1};
+
+    // Ring of the calling thread for the logger it used last; a thread that exits marks its ring for removal.
+    struct RingCache
+    {
+        uint64_t loggerId = 0;
+        std::shared_ptr<LogRing> ring;
+
+        ~RingCache()
+        {
+            if (ring)
+                ring->abandoned.store(true, std::memory_order_release);
+        }
+    };
+
+    thread_local RingCache ringCache;
+
+    std::size_t roundUpToPowerOfTwo(std::size_t value) noexcept
+    {
+        std::size_t result = 2;
+        while (result < value)
+            result <<= 1;
+        return result;
+    }
+}
+
+LogRing::LogRing(std::size_t capacity_) : capacity(roundUpToPowerOfTwo(capacity_)), mask(capacity - 1), records(new LogRecord[capacity])
+{
+}
+
+AsyncLogger::AsyncLogger(int descriptor_, std::size_t ringSize_) : loggerId(nextLoggerId.fetch_add(1, std::memory_order_relaxed)),
+                                                                   descriptor(descriptor_),
+                                                                   ringSize(ringSize_)
+{
+    const auto userName = getUserName();
+    if (userName.has_value())
+        userPrefix = userName.value() + " ";
+
+    writerThread = std::thread([this]
+                               { work(); });
+}
+
+AsyncLogger::~AsyncLogger()
+{
+    {
+        std::lock_guard lock(wakeMutex);
+        stopping = true;
+    }
+    wakeCondition.notify_one();
+    writerThread.join();
+}
+
+AsyncLogger &AsyncLogger::getLogger()
+{
+    static AsyncLogger logger;
+    return logger;
+}
+
+void AsyncLogger::loggingMessage(const LogLevel &logLevel, const std::string &message) noexcept
+{
+    if (static_cast<int>(logLevel) >= ASYNC_CONNECT_MIN_LOG_LEVEL)
+        push(logLevel, message);
+}
+
+void AsyncLogger::flush()
+{
+    std::unique_lock lock(wakeMutex);
+    // The pass running now may have missed the latest messages, the one after it has not.
+    const auto target = drainPasses + 2;
+    wakeCondition.notify_one();
+    drainedCondition.wait(lock, [this, target]
+                          { return drainPasses >= target; });
+}
+
+LogRing *AsyncLogger::thread_ring() noexcept
+{
+    if (ringCache.loggerId == loggerId)
+        return ringCache.ring.get();
+
+    try
+    {
+        auto ring = std::make_shared<LogRing>(ringSize);
+        {
+            std::lock_guard lock(ringsMutex);
+            ringsField.push_back(ring);
+        }
+        if (ringCache.ring)
+            ringCache.ring->abandoned.store(true, std::memory_order_release);
+        ringCache.loggerId = loggerId;
+        ringCache.ring = std::move(ring);
+        return ringCache.ring.get();
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void AsyncLogger::work()
+{
+    std::string output;
+    std::unique_lock lock(wakeMutex);
+
+    while (true)
+    {
+        lock.unlock();
+        const bool written = drain(output);
+        lock.lock();
+
+        ++drainPasses;
+        drainedCondition.notify_all();
+
+        if (!written)
+        {
+            if (stopping)
+                return;
+            wakeCondition.wait_for(lock, std::chrono::milliseconds(1));
+        }
+    }
+}
+
+bool AsyncLogger::drain(std::string &output)
+{
+    std::vector<std::shared_ptr<LogRing>> rings;
+    {
+        std::lock_guard lock(ringsMutex);
+        std::erase_if(ringsField, [](const std::shared_ptr<LogRing> &ring)
+                      { return ring->abandoned.load(std::memory_order_acquire) && ring->head() == ring->tail(); });
+        rings = ringsField;
+    }
+
+    output.clear();
+    std::vector<std::pair<LogRing *, uint64_t>> consumed;
+    for (const auto &ring : rings)
+    {
+        const auto head = ring->head();
+        auto tail = ring->tail();
+        if (tail == head)
+            continue;
+
+        for (; tail != head; ++tail)
+        {
+            format(ring->at(tail), output);
+        }
+        consumed.emplace_back(ring.get(), head);
+    }
+
+    const auto drops = dropped();
+    if (drops != reportedDrops)
+    {
+        LogRecord record;
+        record.timestamp = coarseNow();
+        record.level = LogLevel::WARNING;
+        Writer writer(record);
+        encode(writer, drops - reportedDrops);
+        encode(writer, " log messages dropped, the ring of the producing thread was full");
+        format(record, output);
+        reportedDrops = drops;
+    }
+
+    if (output.empty())
+        return false;
+
+    write_output(output);
+    // Slots are handed back only after the text is out, so flush() returning means written.
+    for (const auto &[ring, head] : consumed)
+    {
+        ring->release(head);
+    }
+    return true;
+}
+
+void AsyncLogger::format(const LogRecord &record, std::string &output)
+{
+    const auto second = record.timestamp / 1'000'000'000;
+    if (second != cachedSecond)
+    {
+        const time_t time = static_cast<time_t>(second);
+        struct tm parts;
+        gmtime_r(&time, &parts);
+        std::array<char, 100> buffer;
+        const auto size = strftime(buffer.data(), buffer.size(), "%a, %d %B %Y %X UTC", &parts);
+        cachedDate.assign(buffer.data(), size);
+        cachedSecond = second;
+    }
+
+    output += userPrefix;
+    output += cachedDate;
+    output += ' ';
+    output += logLevelToString(record.level);
+    output += " MESSAGE: ";
+
+    const char *data = record.payload.data();
+    std::size_t offset = 0;
+    const auto read = [&](auto &value)
+    {
+        std::memcpy(&value, data + offset, sizeof(value));
+        offset += sizeof(value);
+    };
+
+    while (offset < record.size)
+    {
+        const auto tag = static_cast<ArgumentTag>(data[offset++]);
+        switch (tag)
+        {
+        case ArgumentTag::SIGNED:
+        {
+            int64_t value;
+            read(value);
+            output += std::to_string(value);
+            break;
+        }
+        case ArgumentTag::UNSIGNED:
+        {
+            uint64_t value;
+            read(value);
+            output += std::to_string(value);
+            break;
+        }
+        case ArgumentTag::FLOATING:
+        {
+            double value;
+            read(value);
+            std::array<char, 32> buffer;
+            const auto size = std::snprintf(buffer.data(), buffer.size(), "%g", value);
+            output.append(buffer.data(), size);
+            break;
+        }
+        case ArgumentTag::BOOLEAN:
+        {
+            bool value;
+            read(value);
+            output += value ? "true" : "false";
+            break;
+        }
+        case ArgumentTag::CHARACTER:
+        {
+            char value;
+            read(value);
+            output += value;
+            break;
+        }
+        case ArgumentTag::TEXT:
+        {
+            uint16_t length;
+            read(length);
+            output.append(data + offset, length);
+            offset += length;
+            break;
+        }
+        case ArgumentTag::ERROR_CODE:
+        {
+            ErrorArgument value;
+            read(value);
+            output += value.category->message(value.value);
+            break;
+        }
+        }
+    }
+    output += '\n';
+}
+
+void AsyncLogger::write_output(const std::string &output)
+{
+    std::size_t offset = 0;
+    while (offset < output.size())
+    {
+        const auto written = ::write(descriptor, output.data() + offset, output.size() - offset);
+        if (written < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            return;
+        }
+        offset += static_cast<std::size_t>(written);
+    }
+}
@@ -1,4 +1,82 @@
 #include "async_operations.hpp"
+#include "work_stealing_pool.hpp"
+#include "tracing.hpp"
+
+#include <algorithm>
+#include <future>
+#include <utility>
+#include <sys/uio.h>
+
+namespace
+{
+    [[maybe_unused]] const char *operationName(OperationType type) noexcept
+    {
+        switch (type)
+        {
+        case OperationType::CONNECT: return "connect";
+
+        case OperationType::READ: return "read";
+
+        case OperationType::WRITE: return "write";
+
+        case OperationType::ACCEPT: return "accept";
+
+        case OperationType::READ_CHAIN: return "read_chain";
+
+        case OperationType::WRITE_QUEUE: return "write_queue";
+        }
+        return "operation";
+    }
+
+    // Operations of one socket never overlap, so its counters have a single writer at any time.
+    inline void addTransferred(std::atomic<uint64_t> &counter, uint64_t bytes) noexcept
+    {
+        counter.store(counter.load(std::memory_order_relaxed) + bytes, std::memory_order_relaxed);
+    }
+
+    template <typename Function>
+    inline void runTimed(bool timed, AtomicHistogram &histogram, Function &&function)
+    {
+        if (!timed)
+        {
+            function();
+            return;
+        }
+
+        const auto start = IOContext::clock_type::now();
+        function();
+        histogram.record(std::chrono::duration_cast<std::chrono::nanoseconds>(IOContext::clock_type::now() - start).count());
+    }
+
+    // Metrics shard of the IOContext whose run() the calling thread is executing.
+    struct ShardBinding
+    {
+        const void *owner = nullptr;
+        IOMetrics::Shard *shard = nullptr;
+    };
+
+    thread_local ShardBinding currentShard;
+
+    class ShardScope
+    {
+    public:
+        ShardScope(const void *owner, IOMetrics::Shard &shard) noexcept : previous(currentShard)
+        {
+            currentShard = ShardBinding{owner, &shard};
+        }
+
+        ShardScope(const ShardScope &other) = delete;
+        ShardScope &operator=(const ShardScope &other) = delete;
+
+        ~ShardScope()
+        {
+            currentShard = previous;
+        }
+
+    private:
+        ShardBinding previous;
+    };
+}
 
 EndpointIPv4::EndpointIPv4(int port)
 {
@@ -52,8 +130,10 @@ int EndpointIPv4::get_port() const
     return ntohs(addr_struct.sin_port);
 }
 
-TCPAsyncSocket::TCPAsyncSocket(TCPAsyncSocket::context_type &context_) : context(context_), socketField(-1)
+template <typename ThreadingPolicy>
+BasicTCPAsyncSocket<ThreadingPolicy>::BasicTCPAsyncSocket(context_type &context_) : context(context_), socketField(-1), anchor(std::make_shared<Anchor>())
 {
+    anchor->socket = this;
     socketField = socket(AF_INET, SOCK_STREAM, 0);
     if (socketField == -1)
     {
@@ -62,27 +142,118 @@ TCPAsyncSocket::TCPAsyncSocket(TCPAsyncSocket::context_type &context_) : context
     set_nonblocking();
 }
 
-TCPAsyncSocket::TCPAsyncSocket(TCPAsyncSocket &&other) noexcept : context(other.context),
-                                                                  socketField(other.socketField)
+template <typename ThreadingPolicy>
+BasicTCPAsyncSocket<ThreadingPolicy>::BasicTCPAsyncSocket(context_type &context_, socket_type socket_) : context(context_), socketField(socket_), anchor(std::make_shared<Anchor>())
+{
+    anchor->socket = this;
+}
+
+template <typename ThreadingPolicy>
+BasicTCPAsyncSocket<ThreadingPolicy>::BasicTCPAsyncSocket(BasicTCPAsyncSocket &&other) noexcept : context(other.context),
+                                                                  socketField(other.socketField),
+                                                                  bytesReadField(other.bytes_read()),
+                                                                  bytesWrittenField(other.bytes_written())
 {
     other.socketField = -1;
+    adopt_anchor(other);
 }
 
-TCPAsyncSocket &TCPAsyncSocket::operator=(TCPAsyncSocket &&other) noexcept
+template <typename ThreadingPolicy>
+BasicTCPAsyncSocket<ThreadingPolicy> &BasicTCPAsyncSocket<ThreadingPolicy>::operator=(BasicTCPAsyncSocket &&other) noexcept
 {
     // context = std::forward<context_reference>(std::move(other.context));
-    socketField = std::move(other.socketField);
-    other.socketField = -1;
+    if (this != &other)
+    {
+        close();
+        {
+            std::lock_guard lock(anchor->mutex);
+            anchor->socket = nullptr;
+        }
+        socketField = std::move(other.socketField);
+        other.socketField = -1;
+        adopt_anchor(other);
+        bytesReadField.store(other.bytes_read(), std::memory_order_relaxed);
+        bytesWrittenField.store(other.bytes_written(), std::memory_order_relaxed);
+    }
     return *this;
 }
 
-TCPAsyncSocket::~TCPAsyncSocket()
+template <typename ThreadingPolicy>
+BasicTCPAsyncSocket<ThreadingPolicy>::~BasicTCPAsyncSocket()
+{
+    close();
+    if (anchor)
+    {
+        std::lock_guard lock(anchor->mutex);
+        anchor->socket = nullptr;
+    }
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::adopt_anchor(BasicTCPAsyncSocket &other)
 {
+    auto fresh = std::make_shared<Anchor>();
+    fresh->socket = &other;
+
+    std::lock_guard lock(other.anchor->mutex);
+    other.anchor->socket = this;
+    anchor = std::exchange(other.anchor, std::move(fresh));
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::cancel()
+{
+    write_completions_type canceled;
+    pressure_handler_type pressureCallback;
+    std::optional<bool> pressure;
+    {
+        std::lock_guard lock(writeMutex);
+        for (auto &write : writeQueue)
+        {
+            canceled.emplace_back(std::move(write.handler), 0);
+        }
+        if (!canceled.empty())
+            canceled.front().second = writeOffset;
+        writeQueue.clear();
+        writeOffset = 0;
+        queuedBytes = 0;
+        writeArmed = false;
+        pressure = update_pressure();
+        if (pressure.has_value())
+            pressureCallback = pressureHandler;
+    }
+
+    // After the queue is empty, so a flush that is running cannot register a new wait behind the cancellation.
     if (socketField != -1)
-        close(socketField);
+        context.cancel_operations(socketField);
+
+    if (pressure.has_value() && pressureCallback)
+        pressureCallback(*pressure);
+    // Posted like any cancellation, never inline; the socket may be gone when they run.
+    if (!canceled.empty())
+        context.post([canceled = std::move(canceled)]
+                     {
+            for (const auto &[handler, bytes] : canceled)
+            {
+                if (handler)
+                    handler(std::make_error_code(std::errc::operation_canceled), bytes);
+            } });
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::close()
+{
+    if (socketField == -1)
+        return;
+
+    cancel();
+    std::lock_guard lock(anchor->mutex);
+    ::close(socketField);
+    socketField = -1;
 }
 
-void TCPAsyncSocket::async_connect(EndpointIPv4 &endpoint, std::function<void(const std::error_code &)> handler)
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::async_connect(EndpointIPv4 &endpoint, std::function<void(const std::error_code &)> handler, cancellation_slot_type *slot)
 {
     if (!is_open())
     {
@@ -99,23 +270,25 @@ void TCPAsyncSocket::async_connect(EndpointIPv4 &endpoint, std::function<void(co
     else if (result == -1 && (errno == EINPROGRESS || errno == EWOULDBLOCK))
     {
         AsyncOperation operation;
-        operation.socketPointer = this;
         operation.type = OperationType::CONNECT;
 
         operation.socket_handler = connection_handler_type(std::move(handler));
 
-        context.register_operations(socketField, EPOLLOUT | EPOLLONESHOT, std::move(operation));
+        const auto id = context.register_operations(socketField, EPOLLOUT | EPOLLONESHOT, std::move(operation));
+        if (slot != nullptr)
+            slot->bind(context, id);
     }
     else
     {
         std::error_code errorCode(errno, std::system_category());
-        close(socketField);
+        ::close(socketField);
         socketField = -1;
         handler(errorCode);
     }
 }
 
-void TCPAsyncSocket::async_read(std::vector<char> &buffer, std::function<void(const std::error_code &, size_t)> handler)
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::async_read(std::vector<char> &buffer, std::function<void(const std::error_code &, size_t)> handler, cancellation_slot_type *slot)
 {
     if (!is_open())
     {
@@ -127,6 +300,8 @@ void TCPAsyncSocket::async_read(std::vector<char> &buffer, std::function<void(co
 
     if (bytesRead >= 0)
     {
+        addTransferred(bytesReadField, bytesRead);
+        context.add_transferred_bytes(OperationType::READ, bytesRead);
         handler(std::error_code(), static_cast<size_t>(bytesRead));
     }
     else
@@ -134,15 +309,16 @@ void TCPAsyncSocket::async_read(std::vector<char> &buffer, std::function<void(co
         if (errno == EAGAIN || errno == EWOULDBLOCK)
         {
             AsyncOperation operation;
-            // operation.socketPointer = shared_from_this();
-            operation.socketPointer = this;
             operation.type = OperationType::READ;
             operation.socket_handler = std::move(handler);
 
             operation.bufferArray = &buffer;
             operation.totalBytesRequested = buffer.size();
+            operation.transferCounter = &bytesReadField;
 
-            context.register_operations(socketField, EPOLLIN | EPOLLONESHOT, std::move(operation));
+            const auto id = context.register_operations(socketField, EPOLLIN | EPOLLONESHOT, std::move(operation));
+            if (slot != nullptr)
+                slot->bind(context, id);
         }
         else
         {
@@ -151,7 +327,8 @@ void TCPAsyncSocket::async_read(std::vector<char> &buffer, std::function<void(co
     }
 }
 
-void TCPAsyncSocket::async_write(std::vector<char> &buffer, std::function<void(const std::error_code &, size_t)> handler)
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::async_write(std::vector<char> &buffer, std::function<void(const std::error_code &, size_t)> handler, cancellation_slot_type *slot)
 {
     if (!is_open())
     {
@@ -163,6 +340,8 @@ void TCPAsyncSocket::async_write(std::vector<char> &buffer, std::function<void(c
 
     if (bytesWritten >= 0)
     {
+        addTransferred(bytesWrittenField, bytesWritten);
+        context.add_transferred_bytes(OperationType::WRITE, bytesWritten);
         handler(std::error_code(), static_cast<size_t>(bytesWritten));
     }
     else
@@ -170,19 +349,330 @@ void TCPAsyncSocket::async_write(std::vector<char> &buffer, std::function<void(c
         if (errno == EAGAIN || errno == EWOULDBLOCK)
         {
             AsyncOperation operation;
-            // operation.socketPointer = shared_from_this();
-            operation.socketPointer = this;
             operation.type = OperationType::WRITE;
             operation.socket_handler = std::move(handler);
             operation.bufferArray = &buffer;
             operation.totalBytesRequested = buffer.size();
+            operation.transferCounter = &bytesWrittenField;
+
+            const auto id = context.register_operations(socketField, EPOLLOUT | EPOLLONESHOT, std::move(operation));
+            if (slot != nullptr)
+                slot->bind(context, id);
+        }
+        else
+        {
+            handler(std::error_code(errno, std::system_category()), 0);
+        }
+    }
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::async_read_chain(chain_handler_type handler, cancellation_slot_type *slot, std::size_t limit)
+{
+    if (!is_open())
+    {
+        handler(std::make_error_code(std::errc::bad_file_descriptor), BufferChain());
+        return;
+    }
+
+    BufferChain chain;
+    std::error_code errorCode;
+    if (drain_into(chain, limit, errorCode))
+    {
+        handler(errorCode, std::move(chain));
+        return;
+    }
+
+    arm_read_chain(std::move(handler), slot, limit);
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::arm_read_chain(chain_handler_type handler, cancellation_slot_type *slot, std::size_t limit)
+{
+    AsyncOperation operation;
+    operation.type = OperationType::READ_CHAIN;
+    // Reaches the socket through its anchor and calls the handler after letting go of it; a socket destroyed
+    // meanwhile completes the read with operation_canceled.
+    operation.socket_handler = connection_handler_type([anchor = anchor, handler, slot, limit](const std::error_code &errorCode)
+                                                       {
+        if (errorCode)
+        {
+            handler(errorCode, BufferChain());
+            return;
+        }
+
+        BufferChain chain;
+        std::error_code readError;
+        {
+            std::lock_guard lock(anchor->mutex);
+            if (anchor->socket == nullptr)
+            {
+                readError = std::make_error_code(std::errc::operation_canceled);
+            }
+            else if (!anchor->socket->drain_into(chain, limit, readError))
+            {
+                anchor->socket->arm_read_chain(handler, slot, limit);
+                return;
+            }
+        }
+        handler(readError, std::move(chain)); });
+
+    const auto id = context.register_operations(socketField, EPOLLIN | EPOLLONESHOT, std::move(operation));
+    if (slot != nullptr)
+        slot->bind(context, id);
+}
+
+template <typename ThreadingPolicy>
+bool BasicTCPAsyncSocket<ThreadingPolicy>::drain_into(BufferChain &chain, std::size_t limit, std::error_code &errorCode)
+{
+    auto blockSize = readSizer.first_block();
+    while (chain.size() < limit)
+    {
+        auto &block = chain.add_block(blockSize);
+        ssize_t bytesRead;
+        do
+        {
+            bytesRead = ::read(socketField, block.data, block.capacity);
+        } while (bytesRead == -1 && errno == EINTR);
 
-            context.register_operations(socketField, EPOLLOUT | EPOLLONESHOT, std::move(operation));
+        if (bytesRead > 0)
+        {
+            chain.commit(static_cast<std::size_t>(bytesRead));
+            // A read that leaves room found the receive queue empty; asking again would only return EAGAIN.
+            if (static_cast<std::size_t>(bytesRead) < block.capacity)
+                break;
+            blockSize = ReadSizer::next_block(block.capacity);
+            continue;
         }
+
+        const auto readErrno = errno;
+        chain.pop_block();
+        if (!chain.empty())
+            break;
+        if (bytesRead == 0)
+            errorCode.assign(ECONNRESET, std::system_category());
+        else if (readErrno == EAGAIN || readErrno == EWOULDBLOCK)
+            return false;
+        else
+            errorCode.assign(readErrno, std::system_category());
+        return true;
     }
+
+    readSizer.record(chain.size());
+    addTransferred(bytesReadField, chain.size());
+    context.add_transferred_bytes(OperationType::READ, chain.size());
+    return true;
+}
+
+template <typename ThreadingPolicy>
+std::error_code BasicTCPAsyncSocket<ThreadingPolicy>::async_send(std::vector<char> data, read_write_handler_type handler)
+{
+    std::unique_lock lock(writeMutex);
+    if (!is_open())
+        return std::make_error_code(std::errc::bad_file_descriptor);
+    if (queuedBytes + data.size() > writeCapacity)
+        return std::make_error_code(std::errc::no_buffer_space);
+
+    queuedBytes += data.size();
+    writeQueue.push_back(QueuedWrite{std::move(data), std::move(handler)});
+    flush(lock).run();
+    return std::error_code();
+}
+
+template <typename ThreadingPolicy>
+std::error_code BasicTCPAsyncSocket<ThreadingPolicy>::set_write_limits(std::size_t lowWaterMark_, std::size_t highWaterMark_, std::size_t capacity)
+{
+    if (lowWaterMark_ > highWaterMark_ || highWaterMark_ > capacity)
+        return std::make_error_code(std::errc::invalid_argument);
+
+    std::lock_guard lock(writeMutex);
+    lowWaterMark = lowWaterMark_;
+    highWaterMark = highWaterMark_;
+    writeCapacity = capacity;
+    return std::error_code();
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::set_write_pressure_handler(pressure_handler_type handler)
+{
+    std::lock_guard lock(writeMutex);
+    pressureHandler = std::move(handler);
+}
+
+template <typename ThreadingPolicy>
+std::size_t BasicTCPAsyncSocket<ThreadingPolicy>::queued_bytes() const
+{
+    std::lock_guard lock(writeMutex);
+    return queuedBytes;
 }
 
-void TCPAsyncSocket::set_nonblocking()
+template <typename ThreadingPolicy>
+typename BasicTCPAsyncSocket<ThreadingPolicy>::WriteCompletions BasicTCPAsyncSocket<ThreadingPolicy>::flush(std::unique_lock<typename ThreadingPolicy::mutex_type> &lock,
+                                                                                                            std::error_code failure)
+{
+    WriteCompletions completions;
+    auto &finished = completions.finished;
+
+    if (failure)
+    {
+        completions.failure = failure;
+        fail_queue(finished, completions.firstFailed);
+    }
+
+    while (!writeArmed && !writeQueue.empty())
+    {
+        std::array<iovec, WRITE_BATCH> vectors;
+        std::size_t count = 0;
+        std::size_t attempted = 0;
+        for (auto iter = writeQueue.begin(); iter != writeQueue.end() && count < WRITE_BATCH; ++iter, ++count)
+        {
+            const auto offset = count == 0 ? writeOffset : 0;
+            vectors[count].iov_base = iter->data.data() + offset;
+            vectors[count].iov_len = iter->data.size() - offset;
+            attempted += vectors[count].iov_len;
+        }
+
+        // sendmsg is writev with flags: a closed peer fails the queue with EPIPE instead of raising SIGPIPE.
+        struct msghdr message;
+        memset(&message, 0, sizeof(message));
+        message.msg_iov = vectors.data();
+        message.msg_iovlen = count;
+        ssize_t written;
+        do
+        {
+            written = ::sendmsg(socketField, &message, MSG_NOSIGNAL);
+        } while (written == -1 && errno == EINTR);
+
+        if (written >= 0)
+        {
+            consume(static_cast<std::size_t>(written), finished);
+            // A short write filled the send buffer; another write would only return EAGAIN.
+            if (static_cast<std::size_t>(written) == attempted)
+                continue;
+        }
+        else if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            completions.failure.assign(errno, std::system_category());
+            fail_queue(finished, completions.firstFailed);
+            break;
+        }
+
+        AsyncOperation operation;
+        operation.type = OperationType::WRITE_QUEUE;
+        // cancel() fails the queue itself and the socket may already be gone, so a cancelled wait does nothing. Any
+        // other error, such as the reactor refusing the wait while async_write() holds the output slot, fails the queue.
+        // The socket is reached through its anchor, the handlers of the sends run after letting go of it.
+        operation.socket_handler = connection_handler_type([anchor = anchor](const std::error_code &errorCode)
+                                                           {
+            if (errorCode == std::errc::operation_canceled)
+                return;
+
+            WriteCompletions completions;
+            {
+                std::lock_guard anchorLock(anchor->mutex);
+                if (anchor->socket == nullptr)
+                    return;
+
+                auto &socket = *anchor->socket;
+                std::unique_lock lock(socket.writeMutex);
+                socket.writeArmed = false;
+                completions = socket.flush(lock, errorCode);
+            }
+            completions.run(); });
+
+        writeArmed = true;
+        context.register_operations(socketField, EPOLLOUT | EPOLLONESHOT, std::move(operation));
+    }
+
+    completions.pressure = update_pressure();
+    if (completions.pressure.has_value())
+        completions.pressureCallback = pressureHandler;
+    lock.unlock();
+    return completions;
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::WriteCompletions::run() const
+{
+    if (pressure.has_value() && pressureCallback)
+        pressureCallback(*pressure);
+    for (std::size_t index = 0; index < finished.size(); ++index)
+    {
+        const auto &[handler, bytes] = finished[index];
+        if (handler)
+            handler(index < firstFailed ? std::error_code() : failure, bytes);
+    }
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::fail_queue(write_completions_type &finished, std::size_t &firstFailed)
+{
+    firstFailed = finished.size();
+    for (auto &write : writeQueue)
+    {
+        finished.emplace_back(std::move(write.handler), 0);
+    }
+    if (!writeQueue.empty())
+        finished[firstFailed].second = writeOffset;
+    writeQueue.clear();
+    writeOffset = 0;
+    queuedBytes = 0;
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::consume(std::size_t bytes, write_completions_type &finished)
+{
+    addTransferred(bytesWrittenField, bytes);
+    context.add_transferred_bytes(OperationType::WRITE, bytes);
+    queuedBytes -= bytes;
+
+    while (!writeQueue.empty() && writeQueue.front().data.size() - writeOffset <= bytes)
+    {
+        bytes -= writeQueue.front().data.size() - writeOffset;
+        finished.emplace_back(std::move(writeQueue.front().handler), writeQueue.front().data.size());
+        writeQueue.pop_front();
+        writeOffset = 0;
+    }
+    writeOffset += bytes;
+}
+
+template <typename ThreadingPolicy>
+std::optional<bool> BasicTCPAsyncSocket<ThreadingPolicy>::update_pressure() noexcept
+{
+    if (!writePaused && queuedBytes > highWaterMark)
+    {
+        writePaused = true;
+        return true;
+    }
+    if (writePaused && queuedBytes <= lowWaterMark)
+    {
+        writePaused = false;
+        return false;
+    }
+    return std::nullopt;
+}
+
+template <typename ThreadingPolicy>
+int BasicTCPAsyncSocket<ThreadingPolicy>::incoming_cpu() const noexcept
+{
+    int cpu = -1;
+    socklen_t length = sizeof(cpu);
+    if (socketField == -1 || getsockopt(socketField, SOL_SOCKET, SO_INCOMING_CPU, &cpu, &length) == -1)
+        return -1;
+    return cpu;
+}
+
+template <typename ThreadingPolicy>
+std::error_code BasicTCPAsyncSocket<ThreadingPolicy>::set_busy_poll(std::chrono::microseconds budget)
+{
+    int value = static_cast<int>(budget.count());
+    if (setsockopt(socketField, SOL_SOCKET, SO_BUSY_POLL, &value, sizeof(value)) == -1)
+        return std::error_code(errno, std::system_category());
+    return std::error_code();
+}
+
+template <typename ThreadingPolicy>
+void BasicTCPAsyncSocket<ThreadingPolicy>::set_nonblocking()
 {
     int flags = fcntl(socketField, F_GETFL, 0);
     if (flags == -1)
@@ -195,7 +685,62 @@ void TCPAsyncSocket::set_nonblocking()
     }
 }
 
-IOContext::IOContext() : epollManager()
+namespace
+{
+    class EventBatch
+    {
+    public:
+        EventBatch() : events(IOContext::MIN_EVENT_BATCH)
+        {
+        }
+
+        [[nodiscard]] inline epoll_event *data() noexcept
+        {
+            return events.data();
+        }
+
+        [[nodiscard]] inline int size() const noexcept
+        {
+            return batchSize;
+        }
+
+        [[nodiscard]] inline const epoll_event &operator[](int index) const noexcept
+        {
+            return events[index];
+        }
+
+        void adapt(int count)
+        {
+            if (count == batchSize && batchSize < IOContext::MAX_EVENT_BATCH)
+            {
+                batchSize *= 2;
+                quietWaits = 0;
+                if (static_cast<int>(events.size()) < batchSize)
+                    events.resize(batchSize);
+            }
+            else if (count <= batchSize / 4 && batchSize > IOContext::MIN_EVENT_BATCH)
+            {
+                if (++quietWaits >= IOContext::SHRINK_AFTER_WAITS)
+                {
+                    batchSize /= 2;
+                    quietWaits = 0;
+                }
+            }
+            else
+            {
+                quietWaits = 0;
+            }
+        }
+
+    private:
+        std::vector<epoll_event> events;
+        int batchSize = IOContext::MIN_EVENT_BATCH;
+        int quietWaits = 0;
+    };
+}
+
+template <typename ThreadingPolicy>
+BasicIOContext<ThreadingPolicy>::BasicIOContext() : epollManager(MIN_EVENT_BATCH)
 {
     if (!epollManager.is_initialized())
         throw std::runtime_error("Failed to initialize Epoll instance");
@@ -206,27 +751,43 @@ IOContext::IOContext() : epollManager()
         throw std::runtime_error("Failed to create eventfd");
     }*/
 
-    if (pipe(pipefd) == -1)
+    if constexpr (ThreadingPolicy::concurrent)
     {
-        throw std::runtime_error("Failed to create pipe");
-    }
+        if (pipe(pipefd) == -1)
+        {
+            throw std::runtime_error("Failed to create pipe");
+        }
 
-    if (fcntl(pipefd[0], F_SETFL, O_NONBLOCK) == -1 || fcntl(pipefd[1], F_SETFL, O_NONBLOCK) == -1) 
-    {
-        close(pipefd[0]);
-        close(pipefd[1]);
-        throw std::runtime_error("Failed to set pipe non-blocking");
+        if (fcntl(pipefd[0], F_SETFL, O_NONBLOCK) == -1 || fcntl(pipefd[1], F_SETFL, O_NONBLOCK) == -1) 
+        {
+            close(pipefd[0]);
+            close(pipefd[1]);
+            throw std::runtime_error("Failed to set pipe non-blocking");
+        }
+
+        if (epollManager.add(pipefd[0], EPOLLIN) != EpollStatus::ES_SUCCESS)
+        {
+            close(pipefd[0]);
+            close(pipefd[1]);
+            throw std::runtime_error("Failed to add eventfd to Epoll");
+        }
     }
 
-    if (epollManager.add(pipefd[0], EPOLLIN | EPOLLET) != EpollStatus::ES_SUCCESS)
+    timerfd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    if (timerfd == -1 || epollManager.add(timerfd, EPOLLIN) != EpollStatus::ES_SUCCESS)
     {
-        close(pipefd[0]);
-        close(pipefd[1]);
-        throw std::runtime_error("Failed to add eventfd to Epoll");
+        if (pipefd[0] != -1)
+            close(pipefd[0]);
+        if (pipefd[1] != -1)
+            close(pipefd[1]);
+        if (timerfd != -1)
+            close(timerfd);
+        throw std::runtime_error("Failed to create timerfd");
     }
 }
 
-IOContext::~IOContext()
+template <typename ThreadingPolicy>
+BasicIOContext<ThreadingPolicy>::~BasicIOContext()
 {
     /*if (wakeupFD != -1)
         close(wakeupFD);*/
@@ -235,21 +796,34 @@ IOContext::~IOContext()
         close(pipefd[0]);
     if (pipefd[1] != -1)
         close(pipefd[1]);    
+    if (timerfd != -1)
+        close(timerfd);
 }
 
-void IOContext::run()
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::run()
 {    
-    std::stringstream stream;
-    stream << "RUN START thread ip = " << std::this_thread::get_id() << "\n";
-    std::cout << stream.str();
-    stream.str(std::string());
-    int event_count = 0;
+    const ReactorThread reactorThread;
+    auto &shard = metricsField.thread_shard();
+    const ShardScope shardScope(this, shard);
+    runningThreads.fetch_add(1, std::memory_order_relaxed);
 
-    while (!stopRun.load(std::memory_order_relaxed) || workCount.load(std::memory_order_relaxed) > 0)
+    int event_count = 0;
+    // Owned by this thread: threads running the same context must not share the buffer epoll_wait fills.
+    EventBatch batch;
+    // Busy-poll mode: the last wait of this thread that returned events, and whether the previous wait was an empty
+    // poll, so that the loop between two polls counts as spinning as well.
+    auto lastActivity = clock_type::now();
+    clock_type::time_point lastWaitEnd;
+    bool idleSpin = false;
+
+    // Runs while there is work: pending operations, timers, queued tasks and CPU dispatches each hold a count. stop()
+    // does not end the loop while work remains, it only keeps the waits from blocking.
+    while (workCount.load(std::memory_order_acquire) > 0)
     {
         process_pending_tasks();
 
-        if (stopRun.load(std::memory_order_relaxed) && workCount.load(std::memory_order_relaxed) == 0 && tasksQueue.empty())
+        if (workCount.load(std::memory_order_acquire) == 0)
             break;
        
         //int timeout = (stopRun.load(std::memory_order_relaxed) || workCount.load(std::memory_order_relaxed) == 0) ? 0 : -1;
@@ -258,7 +832,53 @@ void IOContext::run()
         int timeout = (stopRun.load(std::memory_order_relaxed) || workCount.load(std::memory_order_relaxed) == 0) ? 0 : -1;
         //int timeout = -1;
 
-        EpollStatus status = epollManager.wait(timeout, event_count);
+        // Without the wakeup pipe a task queued by a handler or task of the last round must not wait for an event.
+        if constexpr (!ThreadingPolicy::concurrent)
+        {
+            if (!tasksQueue.empty())
+                timeout = 0;
+        }
+
+        const auto budget = std::chrono::nanoseconds(busyPollNanoseconds.load(std::memory_order_relaxed));
+        const bool accounted = budget.count() > 0 && timeout != 0;
+        bool spinning = false;
+        clock_type::time_point waitStart;
+        if (accounted)
+        {
+            waitStart = clock_type::now();
+            if (idleSpin)
+                shard.add(IOCounter::SPIN_NANOSECONDS, std::chrono::duration_cast<std::chrono::nanoseconds>(waitStart - lastWaitEnd).count());
+            spinning = waitStart - lastActivity < budget;
+            if (spinning)
+                timeout = 0;
+        }
+
+        EpollStatus status;
+        {
+            ASYNC_CONNECT_TRACE_SPAN("io", "epoll_wait");
+            status = epollManager.wait(timeout, batch.data(), batch.size(), event_count);
+        }
+
+        if (accounted)
+        {
+            const auto waitEnd = clock_type::now();
+            const auto waited = std::chrono::duration_cast<std::chrono::nanoseconds>(waitEnd - waitStart).count();
+            if (spinning)
+            {
+                shard.add(IOCounter::BUSY_POLLS, 1);
+                shard.add(IOCounter::SPIN_NANOSECONDS, waited);
+                if (event_count > 0)
+                    shard.add(IOCounter::BUSY_POLL_HITS, 1);
+            }
+            else
+            {
+                shard.add(IOCounter::SLEEP_NANOSECONDS, waited);
+            }
+            if (event_count > 0)
+                lastActivity = waitEnd;
+            lastWaitEnd = waitEnd;
+        }
+        idleSpin = spinning && event_count == 0;
 
         if (status == EpollStatus::ES_FAILED)
         {
@@ -270,32 +890,87 @@ void IOContext::run()
             break;
         }
 
+        shard.add(IOCounter::WAITS, 1);
+        shard.add(IOCounter::EVENTS, event_count);
+        shard.eventsPerWait.record(event_count);
+
         for (int n = 0; n < event_count; ++n)
         {
-            if (epollManager[n].data.fd == pipefd[0])
+            if (batch[n].data.fd == pipefd[0])
             {
                 //handle_wakeup_event();
                 handle_pipe_event();
                 continue;
             }
-            handle_event(epollManager[n]);
+            if (batch[n].data.fd == timerfd)
+            {
+                handle_timer_event();
+                continue;
+            }
+            handle_event(batch[n]);
         }
+        batch.adapt(event_count);
+    }
+    process_pending_tasks();
+    runningThreads.fetch_sub(1, std::memory_order_relaxed);
+}
+
+template <typename ThreadingPolicy>
+std::vector<std::thread> BasicIOContext<ThreadingPolicy>::run_threads(std::size_t count, const ThreadPlacement &placement, std::error_code *placementError)
+    requires ThreadingPolicy::concurrent
+{
+    std::vector<std::vector<int>> cpus;
+    for (std::size_t idx = 0; idx < count; ++idx)
+    {
+        cpus.push_back(placement.cpus_for(idx));
+    }
+
+    const bool oneCpu = !cpus.empty() && cpus.front().size() == 1 && std::all_of(cpus.begin(), cpus.end(), [&cpus](const std::vector<int> &set)
+                                                                                 { return set == cpus.front(); });
+    pinnedCpu.store(oneCpu ? cpus.front().front() : -1, std::memory_order_relaxed);
+
+    // Shared with the threads: get() can return while set_value() is still touching the promise, so the promises must
+    // not go away with this frame.
+    const auto placed = std::make_shared<std::vector<std::promise<std::error_code>>>(count);
+    std::vector<std::future<std::error_code>> results;
+    for (auto &promise : *placed)
+    {
+        results.push_back(promise.get_future());
+    }
+
+    std::vector<std::thread> threads;
+    for (std::size_t idx = 0; idx < count; ++idx)
+    {
+        threads.emplace_back([this, set = std::move(cpus[idx]), localMemory = placement.localMemory, placed, idx]
+                             {
+            (*placed)[idx].set_value(placeCurrentThread(set, localMemory));
+            run(); });
+    }
+
+    for (auto &result : results)
+    {
+        const auto error = result.get();
+        if (error && placementError != nullptr && !*placementError)
+            *placementError = error;
     }
-    process_pending_tasks();    
-    stream << "RUN END thread ip = " << std::this_thread::get_id() << "\n";
-    std::cout << stream.str();
+    return threads;
 }
 
-void IOContext::stop()
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::stop()
 {
     stopRun.store(true, std::memory_order_relaxed);
     /*uint64_t one = 1;
     write(wakeupFD, &one, sizeof(one));*/
-    char byte = 'S';
-    write(pipefd[1], &byte, sizeof(byte));
+    if constexpr (ThreadingPolicy::concurrent)
+    {
+        char byte = 'S';
+        write(pipefd[1], &byte, sizeof(byte));
+    }
 }
 
-void IOContext::post(task_type task)
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::post(task_type task)
 {
     inc_work();
     {
@@ -303,33 +978,167 @@ void IOContext::post(task_type task)
         // tasksQueue.push(std::move(task));
         tasksQueue.push([t = std::move(task), this]()
                         {
-            t();
+            // A task that throws leaves run() but is done; its work must not keep a later run() going.
+            try
+            {
+                t();
+            }
+            catch (...)
+            {
+                this->dec_work();
+                throw;
+            }
             this->dec_work(); });
     }
     /*uint64_t one = 1;
     write(wakeupFD, &one, sizeof(one));*/
-    char byte = 'P';
-    write(pipefd[1], &byte, sizeof(byte));
+    if constexpr (ThreadingPolicy::concurrent)
+    {
+        char byte = 'P';
+        write(pipefd[1], &byte, sizeof(byte));
+    }
 }
 
-void IOContext::register_operations(int sockId, uint32_t eventMask, AsyncOperation operation)
+template <typename ThreadingPolicy>
+typename BasicIOContext<ThreadingPolicy>::timer_id_type BasicIOContext<ThreadingPolicy>::post_at(clock_type::time_point deadline, task_type task)
 {
     inc_work();
-    std::lock_guard lock(operationsMutex);
+    std::lock_guard lock(timersMutex);
 
-    EpollStatus status = epollManager.add(sockId, eventMask | EPOLLRDHUP | EPOLLERR);
-    //EpollStatus status = epollManager.add(sockId, eventMask | EPOLLIN);
+    const auto id = nextTimerId++;
+    const bool earliest = timersField.empty() || deadline < timersField.begin()->first.first;
+    timersField.emplace(timer_key_type(deadline, id), std::move(task));
+    timerDeadlines.emplace(id, deadline);
 
-    if (status != EpollStatus::ES_SUCCESS)
+    if (earliest)
+        arm_timer(deadline);
+    return id;
+}
+
+template <typename ThreadingPolicy>
+typename BasicIOContext<ThreadingPolicy>::timer_id_type BasicIOContext<ThreadingPolicy>::post_after(clock_type::duration delay, task_type task)
+{
+    return post_at(clock_type::now() + delay, std::move(task));
+}
+
+template <typename ThreadingPolicy>
+bool BasicIOContext<ThreadingPolicy>::cancel_timer(timer_id_type id)
+{
+    {
+        std::lock_guard lock(timersMutex);
+
+        const auto iter = timerDeadlines.find(id);
+        if (iter == timerDeadlines.end())
+            return false;
+
+        timersField.erase(timer_key_type(iter->second, id));
+        timerDeadlines.erase(iter);
+    }
+    dec_work();
+    return true;
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::dispatch_cpu(task_type task, task_type continuation)
+    requires ThreadingPolicy::concurrent
+{
+    auto pool = cpuPool.load(std::memory_order_acquire);
+    if (pool == nullptr)
+        pool = &WorkStealingPool::shared();
+
+    inc_work();
+    pool->submit([this, task = std::move(task), continuation = std::move(continuation)]
+                 {
+        task();
+        post(continuation);
+        dec_work(); });
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::set_cpu_pool(WorkStealingPool &pool) noexcept
+    requires ThreadingPolicy::concurrent
+{
+    cpuPool.store(&pool, std::memory_order_release);
+}
+
+template <typename ThreadingPolicy>
+operation_id_type BasicIOContext<ThreadingPolicy>::register_operations(int sockId, uint32_t eventMask, AsyncOperation operation)
+{
+    std::unique_lock lock(operationsMutex);
+
+    auto &operations = pendingOperations[sockId];
+    auto &slot = (eventMask & EPOLLOUT) ? operations.output : operations.input;
+
+    // Overwriting the pending operation of the direction would drop its handler and leak its work count.
+    if (slot.has_value())
+    {
+        lock.unlock();
+        post([operation = std::move(operation)]
+             { std::visit(OperationInvoker{std::make_error_code(std::errc::device_or_resource_busy), 0, operation.type}, operation.socket_handler); });
+        return INVALID_OPERATION_ID;
+    }
+
+    inc_work();
+    if (++operationGeneration == 0)
+        ++operationGeneration;
+    const auto id = (static_cast<operation_id_type>(operationGeneration) << 32) | static_cast<uint32_t>(sockId);
+    operation.id = id;
+    [[maybe_unused]] const auto type = operation.type;
+    slot = std::move(operation);
+
+    if (!arm_locked(sockId, operations))
     {
+        slot.reset();
+        if (!operations.input.has_value() && !operations.output.has_value())
+            pendingOperations.erase(sockId);
+        dec_work();
         throw std::runtime_error("Failed to add descriptor to Epoll");
     }
 
-    pendingOperations[sockId] = std::move(operation);
+    // Under operationsMutex, so the begin precedes whatever handle_event() records for this id.
+    ASYNC_CONNECT_TRACE_ASYNC_BEGIN("io", operationName(type), id);
+    return id;
+}
+
+template <typename ThreadingPolicy>
+bool BasicIOContext<ThreadingPolicy>::arm_locked(int sockId, DescriptorOperations &operations)
+{
+    uint32_t events = EPOLLONESHOT | EPOLLERR;
+    if (operations.input.has_value())
+        events |= EPOLLIN | EPOLLRDHUP;
+    if (operations.output.has_value())
+        events |= EPOLLOUT;
+
+    if (++operationGeneration == 0)
+        ++operationGeneration;
+    const auto tag = (static_cast<operation_id_type>(operationGeneration) << 32) | static_cast<uint32_t>(sockId);
+
+    // An armed descriptor is re-armed for both directions. EPOLLONESHOT only disarms a descriptor whose operations
+    // completed, it stays in the interest list until it is closed or cancelled, so the first operation after that
+    // re-arms it with EPOLL_CTL_MOD as well. Events fetched under the previous tag are dropped; the modification
+    // reports the descriptor again if it is still ready.
+    EpollStatus status;
+    if (operations.armedTag != INVALID_OPERATION_ID)
+    {
+        status = epollManager.mod_tagged(sockId, events, tag);
+    }
+    else
+    {
+        status = epollManager.add_tagged(sockId, events, tag);
+        if (status != EpollStatus::ES_SUCCESS && errno == EEXIST)
+            status = epollManager.mod_tagged(sockId, events, tag);
+    }
+
+    if (status != EpollStatus::ES_SUCCESS)
+        return false;
+    operations.armedTag = tag;
+    return true;
 }
 
-void IOContext::deregister_operation(int sockId)
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::deregister_operation(int sockId)
 {
+    std::size_t dropped = 0;
     {
         std::lock_guard lock(operationsMutex);
 
@@ -340,52 +1149,176 @@ void IOContext::deregister_operation(int sockId)
             std::cerr << "epollManager.remove failed for sockId " << sockId << std::endl;
         }
 
-        pendingOperations.erase(sockId);
+        const auto iter = pendingOperations.find(sockId);
+        if (iter == pendingOperations.end())
+            return;
+
+        for (const auto *slot : {&iter->second.input, &iter->second.output})
+        {
+            if (!slot->has_value())
+                continue;
+            ASYNC_CONNECT_TRACE_ASYNC_END("io", operationName((*slot)->type), (*slot)->id);
+            ++dropped;
+        }
+        pendingOperations.erase(iter);
     }
-    dec_work();
+    for (; dropped > 0; --dropped)
+    {
+        dec_work();
+    }
+}
+
+template <typename ThreadingPolicy>
+bool BasicIOContext<ThreadingPolicy>::cancel_operation(operation_id_type id)
+{
+    std::unique_lock lock(operationsMutex);
+
+    const auto iter = pendingOperations.find(operationDescriptor(id));
+    if (iter == pendingOperations.end())
+        return false;
+    const auto &operations = iter->second;
+    if ((!operations.input.has_value() || operations.input->id != id) && (!operations.output.has_value() || operations.output->id != id))
+        return false;
+    return cancel_locked(lock, iter, id);
+}
+
+template <typename ThreadingPolicy>
+bool BasicIOContext<ThreadingPolicy>::cancel_operations(int sockId)
+{
+    std::unique_lock lock(operationsMutex);
+
+    const auto iter = pendingOperations.find(sockId);
+    if (iter == pendingOperations.end())
+        return false;
+    return cancel_locked(lock, iter, INVALID_OPERATION_ID);
 }
 
-void IOContext::inc_work()
+template <typename ThreadingPolicy>
+bool BasicIOContext<ThreadingPolicy>::cancel_locked(std::unique_lock<mutex_type> &lock, std::unordered_map<int, DescriptorOperations>::iterator iter,
+                                                    operation_id_type id)
+{
+    std::vector<AsyncOperation> canceled;
+    auto &operations = iter->second;
+    for (auto *slot : {&operations.input, &operations.output})
+    {
+        if (slot->has_value() && (id == INVALID_OPERATION_ID || (*slot)->id == id))
+        {
+            canceled.push_back(std::move(**slot));
+            slot->reset();
+        }
+    }
+
+    // Removing the descriptor from the interest list, or re-arming it for the operation left under a new tag, keeps
+    // the cancelled registration from producing further events; an event already fetched by another thread is
+    // rejected by its stale tag.
+    if (!operations.input.has_value() && !operations.output.has_value())
+    {
+        epollManager.remove(iter->first, 0);
+        pendingOperations.erase(iter);
+    }
+    else if (!arm_locked(iter->first, operations))
+    {
+        std::cerr << "Failed to re-arm descriptor " << iter->first << " in Epoll" << std::endl;
+    }
+    lock.unlock();
+
+    auto &shard = local_shard();
+    for (auto &operation : canceled)
+    {
+        ASYNC_CONNECT_TRACE_ASYNC_INSTANT("io", "canceled", operation.id);
+        ASYNC_CONNECT_TRACE_ASYNC_END("io", operationName(operation.type), operation.id);
+
+        shard.add(IOCounter::CANCELLATIONS, 1);
+        post([operation = std::move(operation)]
+             { std::visit(OperationInvoker{std::make_error_code(std::errc::operation_canceled), 0, operation.type}, operation.socket_handler); });
+        dec_work();
+    }
+    return !canceled.empty();
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::inc_work()
 {
     workCount.fetch_add(1, std::memory_order_relaxed);
     //size_t count = workCount.fetch_add(1, std::memory_order_relaxed) + 1;
     //std::cout << "inc_work: New count = " << count << std::endl;
 }
 
-void IOContext::dec_work()
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::dec_work()
 {
     //workCount.fetch_sub(1, std::memory_order_relaxed);    
-    size_t count = workCount.fetch_sub(1, std::memory_order_relaxed) - 1;
-    std::cout << "dec_work: New count = " << count << std::endl;
+    workCount.fetch_sub(1, std::memory_order_acq_rel);
     /*uint64_t one = 1;
     write(wakeupFD, &one, sizeof(one));  */ 
-    char byte = 'D'; // Пишем 1 байт
-    write(pipefd[1], &byte, sizeof(byte));
+    if constexpr (ThreadingPolicy::concurrent)
+    {
+        char byte = 'D'; // Пишем 1 байт
+        write(pipefd[1], &byte, sizeof(byte));
+    }
 }
 
-void IOContext::handle_event(const epoll_event &event)
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::handle_event(const epoll_event &event)
 {
-    int sockId = event.data.fd;
-    AsyncOperation operation;
+    const operation_id_type tag = event.data.u64;
+    const int sockId = operationDescriptor(tag);
+    std::optional<AsyncOperation> input;
+    std::optional<AsyncOperation> output;
+    std::error_code inputError;
+    std::error_code outputError;
+    size_t inputBytes = 0;
+    size_t outputBytes = 0;
 
     {
         std::unique_lock lock(operationsMutex);
 
         auto it = pendingOperations.find(sockId);
-        if (it == pendingOperations.end())
+        if (it == pendingOperations.end() || it->second.armedTag != tag)
             return;
 
-        operation = std::move(it->second);
-
-        pendingOperations.erase(it);
+        // An error or hangup ends both directions, readiness only its own.
+        auto &operations = it->second;
+        const bool failed = event.events & (EPOLLERR | EPOLLHUP);
+        if (failed || (event.events & (EPOLLIN | EPOLLRDHUP)))
+            input.swap(operations.input);
+        if (failed || (event.events & EPOLLOUT))
+            output.swap(operations.output);
+
+        // cancel_operations() waits for the lock, so the descriptor cannot be closed and reused under the system call.
+        if (input.has_value())
+            transfer(*input, event.events, inputError, inputBytes);
+        if (output.has_value())
+            transfer(*output, event.events, outputError, outputBytes);
+
+        // EPOLLONESHOT disarmed the descriptor; an operation of the other direction still waits.
+        if (!operations.input.has_value() && !operations.output.has_value())
+        {
+            pendingOperations.erase(it);
+        }
+        else if (!arm_locked(sockId, operations))
+        {
+            throw std::runtime_error("Failed to re-arm descriptor in Epoll");
+        }
 
         lock.unlock();
     }
 
-    std::error_code errorCode;
-    size_t bytesTransfered = 0;
+    if (input.has_value())
+        complete_operation(*input, inputError, inputBytes);
+    if (output.has_value())
+        complete_operation(*output, outputError, outputBytes);
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::transfer(AsyncOperation &operation, uint32_t events, std::error_code &errorCode, size_t &bytesTransfered)
+{
+    const int sockId = operationDescriptor(operation.id);
+    ASYNC_CONNECT_TRACE_ASYNC_INSTANT("io", "ready", operation.id);
 
-    if (event.events & (EPOLLERR | EPOLLHUP))
+    // A chain read drains what arrived before the hangup, and both it and a queue flush get the error from the
+    // system call itself.
+    if (operation.type != OperationType::READ_CHAIN && operation.type != OperationType::WRITE_QUEUE && (events & (EPOLLERR | EPOLLHUP)))
     {
         int error = 0;
         socklen_t len = sizeof(error);
@@ -393,13 +1326,13 @@ void IOContext::handle_event(const epoll_event &event)
         {
             errorCode.assign(error, std::system_category());
         }
-        else if (event.events & EPOLLHUP)
+        else if (events & EPOLLHUP)
         {
             errorCode.assign(ECONNRESET, std::system_category());
         }
     }
 
-    if (!errorCode)
+    if (!errorCode && operation.type != OperationType::ACCEPT && operation.type != OperationType::READ_CHAIN && operation.type != OperationType::WRITE_QUEUE)
     {
         if (operation.type == OperationType::READ)
         {
@@ -470,9 +1403,26 @@ void IOContext::handle_event(const epoll_event &event)
             }
         }
     }
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::complete_operation(AsyncOperation &operation, const std::error_code &errorCode, size_t bytesTransfered)
+{
+    auto &shard = local_shard();
+    if (bytesTransfered > 0)
+    {
+        shard.add(operation.type == OperationType::READ ? IOCounter::BYTES_READ : IOCounter::BYTES_WRITTEN, bytesTransfered);
+        if (operation.transferCounter != nullptr)
+            addTransferred(*operation.transferCounter, bytesTransfered);
+    }
+    shard.add(IOCounter::COMPLETIONS, 1);
 
-    std::visit(OperationInvoker{errorCode, bytesTransfered, operation.type},
-               operation.socket_handler);
+    {
+        ASYNC_CONNECT_TRACE_SPAN_ID("io", "handler", operation.id);
+        runTimed(handlerTiming.load(std::memory_order_relaxed), shard.handlerTime, [&]
+                 { std::visit(OperationInvoker{errorCode, bytesTransfered, operation.type}, operation.socket_handler); });
+    }
+    ASYNC_CONNECT_TRACE_ASYNC_END("io", operationName(operation.type), operation.id);
 
     dec_work();
 }
@@ -489,13 +1439,71 @@ void IOContext::handle_event(const epoll_event &event)
     }
 }*/
 
-void IOContext::handle_pipe_event()
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::handle_pipe_event()
 {
+    local_shard().add(IOCounter::WAKEUPS, 1);
+
+    // The last dec_work() leaves its byte in the level-triggered pipe so that every thread blocked in epoll_wait wakes up and leaves run().
+    if (workCount.load(std::memory_order_acquire) == 0)
+        return;
+
     char buffer[128];   
     while (read(pipefd[0], buffer, sizeof(buffer)) > 0); 
 }
 
-void IOContext::process_pending_tasks()
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::handle_timer_event()
+{
+    uint64_t expirations = 0;
+    read(timerfd, &expirations, sizeof(expirations));
+
+    std::vector<task_type> expired;
+    {
+        std::lock_guard lock(timersMutex);
+
+        const auto now = clock_type::now();
+        while (!timersField.empty() && timersField.begin()->first.first <= now)
+        {
+            auto node = timersField.extract(timersField.begin());
+            timerDeadlines.erase(node.key().second);
+            expired.push_back(std::move(node.mapped()));
+        }
+
+        if (!timersField.empty())
+            arm_timer(timersField.begin()->first.first);
+    }
+
+    auto &shard = local_shard();
+    const bool timed = handlerTiming.load(std::memory_order_relaxed);
+    for (auto &task : expired)
+    {
+        if (task)
+        {
+            ASYNC_CONNECT_TRACE_SPAN("io", "timer");
+            runTimed(timed, shard.taskTime, task);
+        }
+        shard.add(IOCounter::TIMERS, 1);
+        dec_work();
+    }
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::arm_timer(clock_type::time_point deadline)
+{
+    const auto delay = std::chrono::duration_cast<std::chrono::nanoseconds>(deadline - clock_type::now());
+    // A zero it_value disarms the timer, an expired deadline has to fire as soon as possible instead.
+    const auto nanoseconds = std::max<int64_t>(delay.count(), 1);
+
+    struct itimerspec specification;
+    memset(&specification, 0, sizeof(specification));
+    specification.it_value.tv_sec = nanoseconds / 1'000'000'000;
+    specification.it_value.tv_nsec = nanoseconds % 1'000'000'000;
+    timerfd_settime(timerfd, 0, &specification, nullptr);
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::process_pending_tasks()
 {
     std::queue<task_type> localQueue;
 
@@ -510,6 +1518,8 @@ void IOContext::process_pending_tasks()
     }
 
     task_type task;
+    auto &shard = local_shard();
+    const bool timed = handlerTiming.load(std::memory_order_relaxed);
 
     while (!localQueue.empty())
     {
@@ -517,6 +1527,297 @@ void IOContext::process_pending_tasks()
         localQueue.pop();
 
         if (task)
-            task();
+        {
+            ASYNC_CONNECT_TRACE_SPAN("io", "task");
+            runTimed(timed, shard.taskTime, task);
+            shard.add(IOCounter::TASKS, 1);
+        }
+    }
+}
+
+template <typename ThreadingPolicy>
+IOMetrics::Shard &BasicIOContext<ThreadingPolicy>::local_shard() noexcept
+{
+    return currentShard.owner == this ? *currentShard.shard : metricsField.shared_shard();
+}
+
+template <typename ThreadingPolicy>
+IOMetricsSnapshot BasicIOContext<ThreadingPolicy>::metrics()
+{
+    IOMetricsSnapshot snapshot;
+    metricsField.collect(snapshot);
+
+    {
+        std::lock_guard lock(tasksMutex);
+        snapshot.queuedTasks = tasksQueue.size();
+    }
+    {
+        std::lock_guard lock(operationsMutex);
+        for (const auto &[descriptor, operations] : pendingOperations)
+        {
+            snapshot.pendingOperations += operations.input.has_value() + operations.output.has_value();
+        }
+    }
+    {
+        std::lock_guard lock(timersMutex);
+        snapshot.pendingTimers = timersField.size();
+    }
+    snapshot.outstandingWork = workCount.load(std::memory_order_relaxed);
+    snapshot.runningThreads = runningThreads.load(std::memory_order_relaxed);
+    snapshot.busyPollMicroseconds = busy_poll().count();
+    return snapshot;
+}
+
+template <typename ThreadingPolicy>
+bool BasicIOContext<ThreadingPolicy>::set_busy_poll(std::chrono::microseconds budget)
+{
+    const auto microseconds = std::max<int64_t>(budget.count(), 0);
+    busyPollNanoseconds.store(microseconds * 1000, std::memory_order_relaxed);
+    // The kernel default budget of 8 packets per poll; larger ones need CAP_NET_ADMIN.
+    return epollManager.set_busy_poll(static_cast<uint32_t>(microseconds), 8, false) == EpollStatus::ES_SUCCESS;
+}
+
+template <typename ThreadingPolicy>
+std::chrono::microseconds BasicIOContext<ThreadingPolicy>::busy_poll() const noexcept
+{
+    return std::chrono::microseconds(busyPollNanoseconds.load(std::memory_order_relaxed) / 1000);
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::set_handler_timing(bool enable) noexcept
+{
+    handlerTiming.store(enable, std::memory_order_relaxed);
+}
+
+template <typename ThreadingPolicy>
+void BasicIOContext<ThreadingPolicy>::add_transferred_bytes(OperationType type, size_t bytes) noexcept
+{
+    if (bytes > 0)
+        local_shard().add(type == OperationType::READ ? IOCounter::BYTES_READ : IOCounter::BYTES_WRITTEN, bytes);
+}
+
+template class BasicIOContext<MultiThreaded>;
+template class BasicIOContext<SingleThreaded>;
+template class BasicTCPAsyncSocket<MultiThreaded>;
+template class BasicTCPAsyncSocket<SingleThreaded>;
+
+TCPAsyncAcceptor::TCPAsyncAcceptor(TCPAsyncAcceptor::context_type &context_) : context(context_), acceptorField(-1), anchor(std::make_shared<Anchor>())
+{
+    anchor->acceptor = this;
+    acceptorField = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (acceptorField == -1)
+    {
+        throw std::system_error(errno, std::system_category(), "Failed to open acceptor socket");
+    }
+}
+
+TCPAsyncAcceptor::TCPAsyncAcceptor(TCPAsyncAcceptor::context_type &context_, EndpointIPv4 &endpoint, bool reusePort, int backlog) : TCPAsyncAcceptor(context_)
+{
+    std::error_code errorCode = set_reuse_address(true);
+    if (!errorCode && reusePort)
+        errorCode = set_reuse_port(true);
+    if (!errorCode)
+        errorCode = bind(endpoint);
+    if (!errorCode)
+        errorCode = listen(backlog);
+
+    if (errorCode)
+    {
+        ::close(acceptorField);
+        acceptorField = -1;
+        throw std::system_error(errorCode, "Failed to listen on " + endpoint.get_ip_str() + ":" + std::to_string(endpoint.get_port()));
+    }
+}
+
+TCPAsyncAcceptor::~TCPAsyncAcceptor()
+{
+    close();
+    std::lock_guard lock(anchor->mutex);
+    anchor->acceptor = nullptr;
+}
+
+std::error_code TCPAsyncAcceptor::set_reuse_address(bool enable)
+{
+    int value = enable ? 1 : 0;
+    if (setsockopt(acceptorField, SOL_SOCKET, SO_REUSEADDR, &value, sizeof(value)) == -1)
+        return std::error_code(errno, std::system_category());
+    return std::error_code();
+}
+
+std::error_code TCPAsyncAcceptor::set_reuse_port(bool enable)
+{
+    int value = enable ? 1 : 0;
+    if (setsockopt(acceptorField, SOL_SOCKET, SO_REUSEPORT, &value, sizeof(value)) == -1)
+        return std::error_code(errno, std::system_category());
+    return std::error_code();
+}
+
+std::error_code TCPAsyncAcceptor::set_incoming_cpu(int cpu)
+{
+    if (setsockopt(acceptorField, SOL_SOCKET, SO_INCOMING_CPU, &cpu, sizeof(cpu)) == -1)
+        return std::error_code(errno, std::system_category());
+    return std::error_code();
+}
+
+std::error_code TCPAsyncAcceptor::bind(EndpointIPv4 &endpoint)
+{
+    if (::bind(acceptorField, endpoint.get_sockaddr(), endpoint.get_socklen()) == -1)
+        return std::error_code(errno, std::system_category());
+    return std::error_code();
+}
+
+std::error_code TCPAsyncAcceptor::listen(int backlog)
+{
+    if (::listen(acceptorField, backlog) == -1)
+        return std::error_code(errno, std::system_category());
+    return std::error_code();
+}
+
+int TCPAsyncAcceptor::local_port() const
+{
+    struct sockaddr_in address;
+    socklen_t length = sizeof(address);
+    if (getsockname(acceptorField, reinterpret_cast<struct sockaddr *>(&address), &length) == -1)
+        return -1;
+    return ntohs(address.sin_port);
+}
+
+void TCPAsyncAcceptor::async_accept(accept_handler_type handler)
+{
+    std::unique_lock lock(anchor->mutex);
+
+    if (!is_open())
+    {
+        lock.unlock();
+        handler(std::make_error_code(std::errc::bad_file_descriptor), nullptr);
+        return;
+    }
+
+    waitersField.push_back(std::move(handler));
+
+    if (acceptedField.empty() && !armed)
+    {
+        const auto errorCode = drain();
+        if (errorCode)
+        {
+            auto failed = std::move(waitersField.back());
+            waitersField.pop_back();
+            lock.unlock();
+            failed(errorCode, nullptr);
+            return;
+        }
+    }
+
+    dispatch(lock);
+}
+
+void TCPAsyncAcceptor::close()
+{
+    std::unique_lock lock(anchor->mutex);
+
+    if (armed)
+    {
+        context.deregister_operation(acceptorField);
+        armed = false;
+    }
+
+    for (const auto &descriptor : acceptedField)
+    {
+        ::close(descriptor);
+    }
+    acceptedField.clear();
+
+    if (acceptorField != -1)
+    {
+        ::close(acceptorField);
+        acceptorField = -1;
+    }
+
+    auto waiters = std::move(waitersField);
+    waitersField.clear();
+    lock.unlock();
+
+    for (auto &waiter : waiters)
+    {
+        waiter(std::make_error_code(std::errc::operation_canceled), nullptr);
+    }
+}
+
+std::error_code TCPAsyncAcceptor::drain()
+{
+    for (std::size_t count = 0; count < ACCEPT_BATCH_SIZE; ++count)
+    {
+        const int client = accept4(acceptorField, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (client >= 0)
+        {
+            acceptedField.push_back(client);
+            continue;
+        }
+
+        if (errno == EINTR || errno == ECONNABORTED || errno == EPROTO)
+            continue;
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return std::error_code();
+
+        // EMFILE and similar are reported only when there is nothing to hand out, queued connections still get served.
+        if (acceptedField.empty())
+            return std::error_code(errno, std::system_category());
+        return std::error_code();
+    }
+    return std::error_code();
+}
+
+void TCPAsyncAcceptor::on_readable(std::unique_lock<std::mutex> &lock, const std::error_code &errorCode)
+{
+    armed = false;
+
+    if (!is_open())
+        return;
+
+    const auto drainError = errorCode ? errorCode : drain();
+    if (drainError && acceptedField.empty() && !waitersField.empty())
+    {
+        auto failed = std::move(waitersField.front());
+        waitersField.pop_front();
+        dispatch(lock);
+        failed(drainError, nullptr);
+        return;
+    }
+
+    dispatch(lock);
+}
+
+void TCPAsyncAcceptor::dispatch(std::unique_lock<std::mutex> &lock)
+{
+    std::vector<std::pair<accept_handler_type, socket_type>> ready;
+    while (!waitersField.empty() && !acceptedField.empty())
+    {
+        ready.emplace_back(std::move(waitersField.front()), acceptedField.front());
+        waitersField.pop_front();
+        acceptedField.pop_front();
+    }
+
+    if (!waitersField.empty() && !armed && is_open())
+    {
+        AsyncOperation operation;
+        operation.type = OperationType::ACCEPT;
+        operation.socket_handler = connection_handler_type([anchor = anchor](const std::error_code &errorCode)
+                                                           {
+            std::unique_lock lock(anchor->mutex);
+            if (anchor->acceptor != nullptr)
+                anchor->acceptor->on_readable(lock, errorCode); });
+        operation.bufferArray = nullptr;
+
+        armed = true;
+        context.register_operations(acceptorField, EPOLLIN | EPOLLONESHOT, std::move(operation));
+    }
+
+    // A handler may destroy the acceptor, so nothing of it is used once the lock is released.
+    auto &ioContext = context;
+    lock.unlock();
+
+    for (auto &[handler, descriptor] : ready)
+    {
+        handler(std::error_code(), std::make_shared<TCPAsyncSocket>(ioContext, descriptor));
     }
 }
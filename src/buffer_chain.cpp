@@ -0,0 +1,179 @@
+#include "buffer_chain.hpp"
+
+#include <algorithm>
+#include <bit>
+
+BufferPool::~BufferPool()
+{
+    for (auto &blocks : freeBlocks)
+    {
+        for (auto *block : blocks)
+        {
+            delete[] block;
+        }
+    }
+}
+
+BufferPool &BufferPool::shared()
+{
+    static BufferPool pool;
+    return pool;
+}
+
+std::size_t BufferPool::block_size(std::size_t size) noexcept
+{
+    return std::bit_ceil(std::clamp(size, MIN_BLOCK_SIZE, MAX_BLOCK_SIZE));
+}
+
+std::size_t BufferPool::class_of(std::size_t capacity) noexcept
+{
+    return std::countr_zero(capacity) - std::countr_zero(MIN_BLOCK_SIZE);
+}
+
+char *BufferPool::acquire(std::size_t size)
+{
+    const auto capacity = block_size(size);
+    {
+        std::lock_guard lock(poolMutex);
+        auto &blocks = freeBlocks[class_of(capacity)];
+        if (!blocks.empty())
+        {
+            auto *block = blocks.back();
+            blocks.pop_back();
+            return block;
+        }
+    }
+    return new char[capacity];
+}
+
+void BufferPool::release(char *block, std::size_t capacity) noexcept
+{
+    {
+        std::lock_guard lock(poolMutex);
+        auto &blocks = freeBlocks[class_of(capacity)];
+        if (blocks.size() < MAX_CACHED_BLOCKS)
+        {
+            blocks.push_back(block);
+            return;
+        }
+    }
+    delete[] block;
+}
+
+std::size_t BufferPool::cached() const
+{
+    std::lock_guard lock(poolMutex);
+    std::size_t count = 0;
+    for (const auto &blocks : freeBlocks)
+    {
+        count += blocks.size();
+    }
+    return count;
+}
+
+BufferChain::BufferChain(BufferPool &pool_) noexcept : pool(&pool_)
+{
+}
+
+BufferChain::BufferChain(BufferChain &&other) noexcept : pool(other.pool),
+                                                         blocksField(std::move(other.blocksField)),
+                                                         sizeField(other.sizeField)
+{
+    other.blocksField.clear();
+    other.sizeField = 0;
+}
+
+BufferChain &BufferChain::operator=(BufferChain &&other) noexcept
+{
+    if (this != &other)
+    {
+        clear();
+        pool = other.pool;
+        blocksField = std::move(other.blocksField);
+        sizeField = other.sizeField;
+        other.blocksField.clear();
+        other.sizeField = 0;
+    }
+    return *this;
+}
+
+BufferChain::~BufferChain()
+{
+    clear();
+}
+
+BufferChain::Block &BufferChain::add_block(std::size_t capacity)
+{
+    const auto size = BufferPool::block_size(capacity);
+    auto *data = pool->acquire(size);
+    try
+    {
+        return blocksField.emplace_back(Block{data, 0, size});
+    }
+    catch (...)
+    {
+        pool->release(data, size);
+        throw;
+    }
+}
+
+void BufferChain::commit(std::size_t bytes) noexcept
+{
+    blocksField.back().size += bytes;
+    sizeField += bytes;
+}
+
+void BufferChain::pop_block() noexcept
+{
+    const auto block = blocksField.back();
+    blocksField.pop_back();
+    sizeField -= block.size;
+    pool->release(block.data, block.capacity);
+}
+
+std::string BufferChain::to_string() const
+{
+    std::string text;
+    text.reserve(sizeField);
+    for (const auto &block : blocksField)
+    {
+        text.append(block.data, block.size);
+    }
+    return text;
+}
+
+void BufferChain::clear() noexcept
+{
+    for (const auto &block : blocksField)
+    {
+        pool->release(block.data, block.capacity);
+    }
+    blocksField.clear();
+    sizeField = 0;
+}
+
+std::size_t ReadSizer::next_block(std::size_t previous) noexcept
+{
+    return std::min(previous * 2, BufferPool::MAX_BLOCK_SIZE);
+}
+
+void ReadSizer::record(std::size_t bytes) noexcept
+{
+    if (bytes > estimate)
+    {
+        estimate = BufferPool::block_size(bytes);
+        smallReads = 0;
+    }
+    else if (bytes <= estimate / 4 && estimate > BufferPool::MIN_BLOCK_SIZE)
+    {
+        if (++smallReads >= SHRINK_AFTER_READS)
+        {
+            estimate /= 2;
+            smallReads = 0;
+        }
+    }
+    else
+    {
+        smallReads = 0;
+    }
+}
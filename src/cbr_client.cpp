@@ -0,0 +1,177 @@
+#include "cbr_client.hpp"
+
+#include <optional>
+
+#include "rates_parser.hpp"
+#include "tracing.hpp"
+
+CbrClient::CbrClient(IOContext &context_, std::string ipAddress, int port, std::string host) : context(context_),
+                                                                                              httpClient(context_, std::move(ipAddress), port, std::move(host))
+{
+}
+
+std::string CbrClient::daily_target(const day_type &day)
+{
+    return std::string(DAILY_PATH) + "?date_req=" + formatCbrDate(day);
+}
+
+std::string CbrClient::dynamic_target(const std::string &valuteId, const day_type &from, const day_type &to)
+{
+    return std::string(DYNAMIC_PATH) + "?date_req1=" + formatCbrDate(from) + "&date_req2=" + formatCbrDate(to) + "&VAL_NM_RQ=" + valuteId;
+}
+
+void CbrClient::get_daily_rates(const day_type &day, rates_handler_type handler)
+{
+    DocumentRequest request;
+    request.target = daily_target(day);
+    request.immutable = day < currentCbrDay();
+
+    request.build = [](HttpResponse &&response, CachedResponse &entry) -> std::error_code
+    {
+        ASYNC_CONNECT_TRACE_SPAN("cbr", "parse daily rates");
+        try
+        {
+            entry.rates = std::make_shared<const rates_table_type>(parseDailyRates(std::move(response.body)));
+        }
+        catch (const std::runtime_error &)
+        {
+            return make_error_code(ClientError::CE_BAD_DOCUMENT);
+        }
+        return std::error_code();
+    };
+
+    request.complete = [handler = std::move(handler)](const std::error_code &error, const CachedResponse *entry)
+    {
+        handler(error, entry != nullptr ? entry->rates : nullptr);
+    };
+
+    fetch(std::move(request));
+}
+
+void CbrClient::get_dynamic_rates(const std::string &valuteId, const day_type &from, const day_type &to, history_handler_type handler)
+{
+    auto history = std::make_shared<rates_history_type>();
+    auto parser = std::make_shared<DynamicRatesParser>([history](DatedValute &&record)
+                                                       { history->push_back(std::move(record)); });
+
+    DocumentRequest request;
+    request.target = dynamic_target(valuteId, from, to);
+    request.immutable = to < currentCbrDay();
+
+    request.bodyHandler = [parser](const char *data, std::size_t size)
+    {
+        parser->feed(data, size);
+    };
+
+    request.build = [parser, history](HttpResponse &&, CachedResponse &entry) -> std::error_code
+    {
+        ASYNC_CONNECT_TRACE_SPAN("cbr", "finish dynamic rates");
+        if (!parser->finish())
+            return make_error_code(ClientError::CE_BAD_DOCUMENT);
+
+        entry.history = history;
+        return std::error_code();
+    };
+
+    request.complete = [handler = std::move(handler)](const std::error_code &error, const CachedResponse *entry)
+    {
+        handler(error, entry != nullptr ? entry->history : nullptr);
+    };
+
+    fetch(std::move(request));
+}
+
+void CbrClient::fetch(DocumentRequest request)
+{
+    auto cached = cacheField.find(request.target);
+
+    if (cached.has_value() && cached->immutable)
+    {
+        cacheField.record_hit(cached.value());
+        context.post([complete = std::move(request.complete), cached = std::move(cached)]
+                     { complete(std::error_code(), &cached.value()); });
+        return;
+    }
+
+    // Counted whatever the download then brings, failures included; a revalidation is counted once it is answered.
+    if (!cached.has_value())
+        cacheField.record_miss();
+
+    if (!inFlight.join(request.target, std::move(request.complete)))
+        return;
+
+    request.complete = [this, target = request.target](const std::error_code &error, const CachedResponse *entry)
+    {
+        inFlight.complete(target, error, entry);
+    };
+
+    http_headers_type headers{{"Accept-Language", "ru, en"}};
+    if (cached.has_value())
+    {
+        if (!cached->etag.empty())
+            headers.emplace_back("If-None-Match", cached->etag);
+        if (!cached->lastModified.empty())
+            headers.emplace_back("If-Modified-Since", cached->lastModified);
+    }
+
+    const auto target = request.target;
+    auto bodyHandler = std::move(request.bodyHandler);
+
+    httpClient.async_get(target, headers, [this, request = std::move(request), cached = std::move(cached)](const std::error_code &error, HttpResponse &&response, std::size_t bodyBytes) mutable
+                         {
+        if (cached.has_value() && (error || response.statusCode != 304))
+            cacheField.record_miss();
+
+        if (error)
+        {
+            request.complete(error, nullptr);
+            return;
+        }
+
+        if (response.statusCode == 304 && cached.has_value())
+        {
+            cacheField.record_not_modified(cached.value());
+
+            const auto etag = response.header("etag");
+            const auto lastModified = response.header("last-modified");
+            if (etag.has_value() || lastModified.has_value())
+            {
+                if (etag.has_value())
+                    cached->etag = etag.value();
+                if (lastModified.has_value())
+                    cached->lastModified = lastModified.value();
+                cacheField.store(request.target, cached.value());
+            }
+
+            request.complete(std::error_code(), &cached.value());
+            return;
+        }
+
+        if (response.statusCode != 200)
+        {
+            request.complete(make_error_code(ClientError::CE_UNEXPECTED_STATUS), nullptr);
+            return;
+        }
+
+        auto job = std::make_shared<BuildJob>();
+        job->entry.etag = response.header("etag").value_or(std::string());
+        job->entry.lastModified = response.header("last-modified").value_or(std::string());
+        job->entry.bodySize = bodyBytes;
+        job->entry.immutable = request.immutable;
+        job->request = std::move(request);
+        job->response = std::move(response);
+
+        // Parsing and building the tables is CPU work, keep it off the reactor thread.
+        context.dispatch_cpu([job]
+                             { job->error = job->request.build(std::move(job->response), job->entry); },
+                             [this, job]
+                             {
+            if (job->error)
+            {
+                job->request.complete(job->error, nullptr);
+                return;
+            }
+
+            cacheField.store(job->request.target, job->entry);
+            job->request.complete(std::error_code(), &job->entry); }); }, std::move(bodyHandler));
+}
@@ -0,0 +1,164 @@
+#include "content_decoder.hpp"
+
+#include <array>
+
+#include <zlib.h>
+
+#include "http_message.hpp"
+
+struct ContentDecoder::Stream
+{
+    z_stream zstream{};
+    bool initialized = false;
+    std::array<char, ContentDecoder::OUTPUT_CHUNK_SIZE> output;
+
+    ~Stream()
+    {
+        if (initialized)
+            inflateEnd(&zstream);
+    }
+};
+
+std::optional<ContentEncoding> parseContentEncoding(const std::string &value)
+{
+    const auto encoding = toLower(value);
+
+    if (encoding.empty() || encoding == "identity")
+        return ContentEncoding::IDENTITY;
+    if (encoding == "gzip" || encoding == "x-gzip")
+        return ContentEncoding::GZIP;
+    if (encoding == "deflate")
+        return ContentEncoding::DEFLATE;
+
+    return std::nullopt;
+}
+
+ContentDecoder::ContentDecoder(ContentEncoding encoding_, sink_type sink_, std::size_t maxDecodedSize_) : encodingField(encoding_), sink(std::move(sink_)), maxDecodedSizeField(maxDecodedSize_)
+{
+}
+
+ContentDecoder::ContentDecoder(ContentDecoder &&other) noexcept = default;
+
+ContentDecoder &ContentDecoder::operator=(ContentDecoder &&other) noexcept = default;
+
+ContentDecoder::~ContentDecoder() = default;
+
+bool ContentDecoder::write(const char *data, std::size_t size)
+{
+    if (failed)
+        return false;
+
+    if (encodingField == ContentEncoding::IDENTITY)
+    {
+        if (size > maxDecodedSizeField - decodedBytesField)
+        {
+            failed = true;
+            return false;
+        }
+        decodedBytesField += size;
+        if (size > 0)
+            sink(data, size);
+        return true;
+    }
+
+    if (size == 0)
+        return true;
+
+    if (!stream)
+    {
+        // "deflate" is meant to be zlib-wrapped, but some servers send a raw deflate stream, so the first two bytes
+        // decide: a zlib header has compression method 8, a window of at most 32K and a check value divisible by 31.
+        if (encodingField == ContentEncoding::DEFLATE && !firstByte.has_value() && size == 1)
+        {
+            firstByte = data[0];
+            return true;
+        }
+
+        const auto cmf = static_cast<unsigned char>(firstByte.value_or(data[0]));
+        const auto flg = static_cast<unsigned char>(firstByte.has_value() ? data[0] : data[1]);
+        const bool zlibWrapped = (cmf & 0x0F) == 8 && (cmf >> 4) <= 7 && ((cmf << 8) | flg) % 31 == 0;
+        const int windowBits = encodingField == ContentEncoding::GZIP ? 15 + 16 : (zlibWrapped ? 15 : -15);
+        if (!initialize(windowBits))
+        {
+            failed = true;
+            return false;
+        }
+
+        if (firstByte.has_value())
+        {
+            const char header = *firstByte;
+            firstByte.reset();
+            if (!inflate_input(&header, 1))
+                return false;
+        }
+    }
+
+    return inflate_input(data, size);
+}
+
+bool ContentDecoder::inflate_input(const char *data, std::size_t size)
+{
+    if (streamEnded)
+        return true;
+
+    auto &zstream = stream->zstream;
+    zstream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    zstream.avail_in = static_cast<uInt>(size);
+
+    do
+    {
+        zstream.next_out = reinterpret_cast<Bytef *>(stream->output.data());
+        zstream.avail_out = static_cast<uInt>(stream->output.size());
+
+        const int result = inflate(&zstream, Z_NO_FLUSH);
+        if (result != Z_OK && result != Z_STREAM_END && result != Z_BUF_ERROR)
+        {
+            failed = true;
+            return false;
+        }
+
+        const auto produced = stream->output.size() - zstream.avail_out;
+        if (produced > maxDecodedSizeField - decodedBytesField)
+        {
+            failed = true;
+            return false;
+        }
+        if (produced > 0)
+        {
+            decodedBytesField += produced;
+            sink(stream->output.data(), produced);
+        }
+
+        if (result == Z_STREAM_END)
+        {
+            streamEnded = true;
+            break;
+        }
+
+        if (result == Z_BUF_ERROR && produced == 0)
+            break;
+    } while (zstream.avail_in > 0 || zstream.avail_out == 0);
+
+    return true;
+}
+
+bool ContentDecoder::finish()
+{
+    if (failed)
+        return false;
+    if (encodingField == ContentEncoding::IDENTITY)
+        return true;
+    return streamEnded || (!stream && !firstByte.has_value());
+}
+
+bool ContentDecoder::initialize(int windowBits)
+{
+    stream = std::make_unique<Stream>();
+    if (inflateInit2(&stream->zstream, windowBits) != Z_OK)
+    {
+        stream.reset();
+        return false;
+    }
+    stream->initialized = true;
+    return true;
+}
@@ -0,0 +1,93 @@
+#include "coroutine.hpp"
+
+#include <new>
+
+namespace
+{
+    constexpr std::size_t SIZE_CLASSES = FrameAllocator::MAX_CACHED_SIZE / FrameAllocator::GRANULARITY;
+
+    struct FreeFrame
+    {
+        FreeFrame *next;
+    };
+
+    struct FrameCache
+    {
+        std::array<FreeFrame *, SIZE_CLASSES> heads{};
+        std::array<std::size_t, SIZE_CLASSES> counts{};
+        std::size_t heapAllocations = 0;
+
+        ~FrameCache()
+        {
+            for (auto head : heads)
+            {
+                while (head != nullptr)
+                {
+                    auto next = head->next;
+                    ::operator delete(head);
+                    head = next;
+                }
+            }
+        }
+    };
+
+    FrameCache &frameCache()
+    {
+        thread_local FrameCache cache;
+        return cache;
+    }
+
+    std::size_t sizeClass(std::size_t size) noexcept
+    {
+        return (size + FrameAllocator::GRANULARITY - 1) / FrameAllocator::GRANULARITY - 1;
+    }
+}
+
+void *FrameAllocator::allocate(std::size_t size)
+{
+    auto &cache = frameCache();
+    if (size == 0 || size > MAX_CACHED_SIZE)
+    {
+        ++cache.heapAllocations;
+        return ::operator new(size);
+    }
+
+    const auto index = sizeClass(size);
+    if (auto frame = cache.heads[index]; frame != nullptr)
+    {
+        cache.heads[index] = frame->next;
+        --cache.counts[index];
+        return frame;
+    }
+
+    ++cache.heapAllocations;
+    return ::operator new((index + 1) * GRANULARITY);
+}
+
+void FrameAllocator::deallocate(void *frame, std::size_t size) noexcept
+{
+    if (size == 0 || size > MAX_CACHED_SIZE)
+    {
+        ::operator delete(frame);
+        return;
+    }
+
+    // Frames released on another thread than the one that allocated them simply move to this thread's list.
+    auto &cache = frameCache();
+    const auto index = sizeClass(size);
+    if (cache.counts[index] >= MAX_CACHED_FRAMES)
+    {
+        ::operator delete(frame);
+        return;
+    }
+
+    auto freeFrame = static_cast<FreeFrame *>(frame);
+    freeFrame->next = cache.heads[index];
+    cache.heads[index] = freeFrame;
+    ++cache.counts[index];
+}
+
+std::size_t FrameAllocator::heap_allocations() noexcept
+{
+    return frameCache().heapAllocations;
+}
@@ -0,0 +1,186 @@
+#include "cross_rates.hpp"
+
+#include <algorithm>
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    constexpr std::size_t LANE_PADDING = 4;
+
+    void multiplyRow(const double *inverseRates, double unit, double *output, std::size_t count)
+    {
+        std::size_t idx = 0;
+#if defined(__AVX__)
+        const __m256d scalar = _mm256_set1_pd(unit);
+        for (; idx + 4 <= count; idx += 4)
+        {
+            _mm256_storeu_pd(output + idx, _mm256_mul_pd(scalar, _mm256_loadu_pd(inverseRates + idx)));
+        }
+#elif defined(__SSE2__)
+        const __m128d scalar = _mm_set1_pd(unit);
+        for (; idx + 2 <= count; idx += 2)
+        {
+            _mm_storeu_pd(output + idx, _mm_mul_pd(scalar, _mm_loadu_pd(inverseRates + idx)));
+        }
+#endif
+        for (; idx < count; ++idx)
+        {
+            output[idx] = unit * inverseRates[idx];
+        }
+    }
+}
+
+CrossRateMatrix::rate_type unitRate(const Valute &valute)
+{
+    if (valute.Nominal <= 0 || !(valute.Value > 0.0f))
+    {
+        throw std::invalid_argument("Invalid Value or Nominal for currency " + valute.CharCode);
+    }
+    return static_cast<CrossRateMatrix::rate_type>(valute.Value) / valute.Nominal;
+}
+
+CrossRateMatrix::CrossRateMatrix(const rates_table_type &table)
+{
+    rebuild(table);
+}
+
+void CrossRateMatrix::rebuild(const rates_table_type &table)
+{
+    // Built aside and swapped in, so an invalid currency or a failed allocation leaves the previous matrix intact.
+    std::vector<std::string> codes;
+    codes.reserve(table.size() + 1);
+    codes.emplace_back(BASE_CURRENCY);
+    for (const auto &[code, valute] : table)
+    {
+        if (code != BASE_CURRENCY)
+            codes.push_back(code);
+    }
+    std::sort(codes.begin(), codes.end());
+
+    const auto count = codes.size();
+    const auto stride = (count + LANE_PADDING - 1) / LANE_PADDING * LANE_PADDING;
+
+    std::unordered_map<std::string, index_type> index;
+    index.reserve(count);
+    std::vector<rate_type> unitRates(count, 1.0);
+    std::vector<rate_type> inverseRates(stride, 0.0);
+    std::vector<rate_type> matrix(count * stride, 0.0);
+
+    for (index_type idx = 0; idx < count; ++idx)
+    {
+        index.emplace(codes[idx], idx);
+
+        const auto iter = table.find(codes[idx]);
+        if (iter != table.end())
+            unitRates[idx] = unitRate(iter->second);
+
+        inverseRates[idx] = 1.0 / unitRates[idx];
+    }
+
+    codesField.swap(codes);
+    indexField.swap(index);
+    unitRatesField.swap(unitRates);
+    inverseRatesField.swap(inverseRates);
+    matrixField.swap(matrix);
+    strideField = stride;
+
+    for (index_type from = 0; from < count; ++from)
+    {
+        recompute_row(from);
+    }
+}
+
+std::size_t CrossRateMatrix::update(const rates_table_type &table)
+{
+    const auto hasBase = table.find(BASE_CURRENCY) != table.end();
+    if (empty() || table.size() + (hasBase ? 0 : 1) != size())
+    {
+        rebuild(table);
+        return size();
+    }
+
+    std::vector<index_type> changed;
+    std::vector<rate_type> newUnitRates;
+
+    for (const auto &[code, valute] : table)
+    {
+        if (code == BASE_CURRENCY)
+            continue;
+
+        const auto iter = indexField.find(code);
+        if (iter == indexField.end())
+        {
+            rebuild(table);
+            return size();
+        }
+
+        const auto unit = unitRate(valute);
+        if (unit != unitRatesField[iter->second])
+        {
+            changed.push_back(iter->second);
+            newUnitRates.push_back(unit);
+        }
+    }
+
+    for (std::size_t idx = 0; idx < changed.size(); ++idx)
+    {
+        unitRatesField[changed[idx]] = newUnitRates[idx];
+        inverseRatesField[changed[idx]] = 1.0 / newUnitRates[idx];
+    }
+
+    if (changed.size() * LANE_PADDING >= size())
+    {
+        for (index_type from = 0; from < size(); ++from)
+        {
+            recompute_row(from);
+        }
+        return changed.size();
+    }
+
+    for (const auto &column : changed)
+    {
+        const auto inverse = inverseRatesField[column];
+        for (index_type from = 0; from < size(); ++from)
+        {
+            matrixField[from * strideField + column] = unitRatesField[from] * inverse;
+        }
+    }
+
+    for (const auto &from : changed)
+    {
+        recompute_row(from);
+    }
+
+    return changed.size();
+}
+
+CrossRateMatrix::rate_type CrossRateMatrix::rate(const std::string &from, const std::string &to) const
+{
+    const auto fromIndex = index_of(from);
+    const auto toIndex = index_of(to);
+
+    if (!fromIndex.has_value() || !toIndex.has_value())
+    {
+        throw std::invalid_argument("Unknown currency pair " + from + "/" + to);
+    }
+
+    return rate(fromIndex.value(), toIndex.value());
+}
+
+std::optional<CrossRateMatrix::index_type> CrossRateMatrix::index_of(const std::string &code) const noexcept
+{
+    const auto iter = indexField.find(code);
+    if (iter == indexField.end())
+        return std::nullopt;
+    return iter->second;
+}
+
+void CrossRateMatrix::recompute_row(const index_type &from)
+{
+    multiplyRow(inverseRatesField.data(), unitRatesField[from], matrixField.data() + from * strideField, strideField);
+}
@@ -1,5 +1,21 @@
 #include "epoll.hpp"
 
+#include <sys/ioctl.h>
+#include <cstdint>
+
+// Not in the uapi headers before Linux 6.9.
+#ifndef EPIOCSPARAMS
+struct epoll_params
+{
+    uint32_t busy_poll_usecs;
+    uint16_t busy_poll_budget;
+    uint8_t prefer_busy_poll;
+    uint8_t __pad;
+};
+
+#define EPIOCSPARAMS _IOW(0x8A, 0x01, struct epoll_params)
+#endif
+
 Epoll::~Epoll()
 {
     close(epollField);
@@ -53,9 +69,36 @@ EpollStatus Epoll::remove(const descriptor_type &descriptor, const Epoll::event_
     return remove(epollEvent);
 }
 
+EpollStatus Epoll::add_tagged(const descriptor_type &descriptor, const Epoll::event_type &event, const uint64_t &tag)
+{
+    struct epoll_event epollEvent;
+    epollEvent.data.u64 = tag;
+    epollEvent.events = event;
+
+    const auto result = epoll_ctl(epollField, EPOLL_CTL_ADD, descriptor, &epollEvent);
+    if(result == 0) return EpollStatus::ES_SUCCESS;
+    return EpollStatus::ES_FAILED;
+}
+
+EpollStatus Epoll::mod_tagged(const descriptor_type &descriptor, const Epoll::event_type &event, const uint64_t &tag)
+{
+    struct epoll_event epollEvent;
+    epollEvent.data.u64 = tag;
+    epollEvent.events = event;
+
+    const auto result = epoll_ctl(epollField, EPOLL_CTL_MOD, descriptor, &epollEvent);
+    if(result == 0) return EpollStatus::ES_SUCCESS;
+    return EpollStatus::ES_FAILED;
+}
+
 EpollStatus Epoll::wait(const int &timeout, int &count)
 {
-    count = epoll_wait(epollField, eventsField.data(), maxEpollEvents, timeout);
+    return wait(timeout, eventsField.data(), maxEpollEvents, count);
+}
+
+EpollStatus Epoll::wait(const int &timeout, epoll_event_type *events, const int &maxEvents, int &count)
+{
+    count = epoll_wait(epollField, events, maxEvents, timeout);
     if(count > 0)
     {
         return EpollStatus::ES_SUCCESS;
@@ -68,6 +111,18 @@ EpollStatus Epoll::wait(const int &timeout, int &count)
     }
 }
 
+EpollStatus Epoll::set_busy_poll(const uint32_t &microseconds, const uint16_t &budget, const bool &prefer)
+{
+    struct epoll_params params;
+    params.busy_poll_usecs = microseconds;
+    params.busy_poll_budget = budget;
+    params.prefer_busy_poll = prefer ? 1 : 0;
+    params.__pad = 0;
+
+    if(ioctl(epollField, EPIOCSPARAMS, &params) == 0) return EpollStatus::ES_SUCCESS;
+    return EpollStatus::ES_FAILED;
+}
+
 std::ostream &operator << (std::ostream &stream, EpollStatus epollStatus)
 {
     stream << epollStatusToString(epollStatus);
@@ -0,0 +1,73 @@
+#include "exchange_rates.hpp"
+
+#include <array>
+#include <cstdio>
+#include <ctime>
+
+day_type dayFromCivil(int year, unsigned month, unsigned day) noexcept
+{
+    year -= month <= 2;
+    const int era = (year >= 0 ? year : year - 399) / 400;
+    const unsigned yearOfEra = static_cast<unsigned>(year - era * 400);
+    const unsigned dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    const unsigned dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return static_cast<day_type>(era * 146097 + static_cast<int>(dayOfEra) - 719468);
+}
+
+std::optional<day_type> parseCbrDate(const std::string &text) noexcept
+{
+    if (text.size() != 10 || (text[2] != '/' && text[2] != '.') || text[5] != text[2])
+        return std::nullopt;
+
+    auto digits = [&text](std::size_t position, std::size_t count) -> int
+    {
+        int value = 0;
+        for (std::size_t idx = position; idx < position + count; ++idx)
+        {
+            if (text[idx] < '0' || text[idx] > '9')
+                return -1;
+            value = value * 10 + (text[idx] - '0');
+        }
+        return value;
+    };
+
+    const int day = digits(0, 2);
+    const int month = digits(3, 2);
+    const int year = digits(6, 4);
+
+    if (month < 1 || month > 12 || year < 0)
+        return std::nullopt;
+
+    static constexpr std::array<int, 12> DAYS_IN_MONTH = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    const bool leapYear = year % 4 == 0 && (year % 100 != 0 || year % 400 == 0);
+    const int monthLength = DAYS_IN_MONTH[month - 1] + (month == 2 && leapYear);
+    if (day < 1 || day > monthLength)
+        return std::nullopt;
+
+    return dayFromCivil(year, static_cast<unsigned>(month), static_cast<unsigned>(day));
+}
+
+std::string formatCbrDate(const day_type &day)
+{
+    const int shifted = day + 719468;
+    const int era = (shifted >= 0 ? shifted : shifted - 146096) / 146097;
+    const unsigned dayOfEra = static_cast<unsigned>(shifted - era * 146097);
+    const unsigned yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    const unsigned dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    const unsigned monthPrime = (5 * dayOfYear + 2) / 153;
+    const unsigned dayOfMonth = dayOfYear - (153 * monthPrime + 2) / 5 + 1;
+    const unsigned month = monthPrime < 10 ? monthPrime + 3 : monthPrime - 9;
+    const int year = static_cast<int>(yearOfEra) + era * 400 + (month <= 2);
+
+    // Room for any int year, not only four digits.
+    std::array<char, 24> buffer;
+    std::snprintf(buffer.data(), buffer.size(), "%02u/%02u/%04d", dayOfMonth, month, year);
+    return std::string(buffer.data());
+}
+
+day_type currentCbrDay() noexcept
+{
+    constexpr std::time_t MOSCOW_OFFSET = 3 * 60 * 60;
+    constexpr std::time_t SECONDS_PER_DAY = 24 * 60 * 60;
+    return static_cast<day_type>((std::time(nullptr) + MOSCOW_OFFSET) / SECONDS_PER_DAY);
+}
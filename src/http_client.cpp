@@ -0,0 +1,184 @@
+#include "http_client.hpp"
+
+#include <algorithm>
+
+#include "tracing.hpp"
+
+namespace
+{
+    class ClientErrorCategory : public std::error_category
+    {
+    public:
+        const char *name() const noexcept override
+        {
+            return "AsyncConnect.client";
+        }
+
+        std::string message(int value) const override
+        {
+            switch (static_cast<ClientError>(value))
+            {
+            case ClientError::CE_BAD_RESPONSE: return std::string("Malformed HTTP response");
+
+            case ClientError::CE_UNEXPECTED_STATUS: return std::string("Unexpected HTTP status");
+
+            case ClientError::CE_BAD_DOCUMENT: return std::string("Malformed rates document");
+
+            default: return std::string("Unknown client error");
+            }
+        }
+    };
+
+    struct HttpExchange : public std::enable_shared_from_this<HttpExchange>
+    {
+        HttpExchange(IOContext &context, const std::string &ipAddress, int port) : socket(context), endpoint(ipAddress, port)
+        {
+        }
+
+        TCPAsyncSocket socket;
+        EndpointIPv4 endpoint;
+        std::vector<char> writeBuffer;
+        HttpResponseParser parser;
+        http_response_handler_type handler;
+        static constexpr const char *READ_PHASE = "read";
+
+        // Phase traced as a nested async span of the request: connect, write, first byte, read.
+        const char *tracePhase = nullptr;
+
+        void trace_phase([[maybe_unused]] const char *next)
+        {
+#if ASYNC_CONNECT_TRACING
+            const auto id = reinterpret_cast<uint64_t>(this);
+            if (tracePhase != nullptr)
+                Tracer::global().async_end("http", tracePhase, id);
+            if (next != nullptr)
+                Tracer::global().async_begin("http", next, id);
+#endif
+            tracePhase = next;
+        }
+
+        void start()
+        {
+            ASYNC_CONNECT_TRACE_ASYNC_BEGIN("http", "request", reinterpret_cast<uint64_t>(this));
+            trace_phase("connect");
+
+            auto self = shared_from_this();
+            socket.async_connect(endpoint, [self](const std::error_code &error)
+                                 {
+                if (error)
+                {
+                    self->complete(error);
+                    return;
+                }
+                self->trace_phase("write");
+                self->write_request(); });
+        }
+
+        void write_request()
+        {
+            auto self = shared_from_this();
+            socket.async_write(writeBuffer, [self](const std::error_code &error, size_t bytesWritten)
+                               {
+                if (error)
+                {
+                    self->complete(error);
+                    return;
+                }
+
+                self->writeBuffer.erase(self->writeBuffer.begin(), self->writeBuffer.begin() + bytesWritten);
+                if (self->writeBuffer.empty())
+                {
+                    self->trace_phase("first byte");
+                    self->read_response();
+                }
+                else
+                    self->write_request(); });
+        }
+
+        void read_response()
+        {
+            auto self = shared_from_this();
+            socket.async_read_chain([self](const std::error_code &error, BufferChain chain)
+                                    {
+                HttpParseStatus status = HttpParseStatus::HP_NEED_MORE;
+
+                if (error == std::errc::connection_reset)
+                {
+                    status = self->parser.finish();
+                }
+                else if (error)
+                {
+                    self->complete(error);
+                    return;
+                }
+                else
+                {
+                    if (self->tracePhase != self->READ_PHASE)
+                        self->trace_phase(self->READ_PHASE);
+                    ASYNC_CONNECT_TRACE_SPAN("http", "parse");
+                    for (const auto &block : chain.blocks())
+                    {
+                        status = self->parser.feed(block.data, block.size);
+                        if (status != HttpParseStatus::HP_NEED_MORE)
+                            break;
+                    }
+                }
+
+                if (status == HttpParseStatus::HP_COMPLETE)
+                    self->complete(std::error_code());
+                else if (status == HttpParseStatus::HP_FAILED)
+                    self->complete(error ? error : make_error_code(ClientError::CE_BAD_RESPONSE));
+                else
+                    self->read_response(); });
+        }
+
+        void complete(const std::error_code &error)
+        {
+            trace_phase(nullptr);
+            ASYNC_CONNECT_TRACE_ASYNC_END("http", "request", reinterpret_cast<uint64_t>(this));
+
+            auto completion = std::move(handler);
+            handler = nullptr;
+            if (completion)
+                completion(error, std::move(parser.response()), parser.body_bytes());
+        }
+    };
+}
+
+const std::error_category &clientErrorCategory() noexcept
+{
+    static ClientErrorCategory category;
+    return category;
+}
+
+std::error_code make_error_code(ClientError error) noexcept
+{
+    return std::error_code(static_cast<int>(error), clientErrorCategory());
+}
+
+HttpClient::HttpClient(IOContext &context_, std::string ipAddress_, int port_, std::string host_) : context(context_),
+                                                                                                   ipAddress(std::move(ipAddress_)),
+                                                                                                   port(port_),
+                                                                                                   hostField(std::move(host_))
+{
+}
+
+void HttpClient::async_request(const std::string &method, const std::string &target, const http_headers_type &headers, http_response_handler_type handler,
+                               HttpResponseParser::body_handler_type bodyHandler)
+{
+    auto exchange = std::make_shared<HttpExchange>(context, ipAddress, port);
+
+    http_headers_type requestHeaders(headers);
+    const auto hasAcceptEncoding = std::any_of(requestHeaders.cbegin(), requestHeaders.cend(), [](const auto &header)
+                                               { return toLower(header.first) == "accept-encoding"; });
+    if (!hasAcceptEncoding)
+        requestHeaders.emplace_back("Accept-Encoding", "gzip, deflate");
+    requestHeaders.emplace_back("Connection", "close");
+    const auto request = buildHttpRequest(method, target, hostField, requestHeaders);
+
+    exchange->writeBuffer.assign(request.cbegin(), request.cend());
+    exchange->handler = std::move(handler);
+    if (bodyHandler)
+        exchange->parser.set_body_handler(std::move(bodyHandler));
+    exchange->start();
+}
@@ -0,0 +1,372 @@
+#include "http_message.hpp"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdlib>
+
+std::optional<std::string> HttpResponse::header(const std::string &name) const
+{
+    const auto lowerName = toLower(name);
+    for (const auto &[key, value] : headers)
+    {
+        if (key == lowerName)
+            return value;
+    }
+    return std::nullopt;
+}
+
+std::optional<std::string> HttpRequest::header(const std::string &name) const
+{
+    const auto lowerName = toLower(name);
+    for (const auto &[key, value] : headers)
+    {
+        if (key == lowerName)
+            return value;
+    }
+    return std::nullopt;
+}
+
+bool HttpRequest::keep_alive() const
+{
+    const auto connection = header("connection");
+    if (connection.has_value())
+    {
+        const auto value = toLower(connection.value());
+        if (value.find("close") != std::string::npos)
+            return false;
+        if (value.find("keep-alive") != std::string::npos)
+            return true;
+    }
+    return versionMinor >= 1;
+}
+
+bool parseHttpRequestHead(const char *begin, const char *end, HttpRequest &request)
+{
+    const char *lineEnd = std::find(begin, end, '\n');
+    std::string line(begin, lineEnd);
+    if (!line.empty() && line.back() == '\r')
+        line.pop_back();
+
+    const auto firstSpace = line.find(' ');
+    const auto secondSpace = line.find(' ', firstSpace + 1);
+    if (firstSpace == std::string::npos || secondSpace == std::string::npos)
+        return false;
+
+    request.method = line.substr(0, firstSpace);
+    request.target = line.substr(firstSpace + 1, secondSpace - firstSpace - 1);
+
+    const auto version = line.substr(secondSpace + 1);
+    if (version.size() != 8 || version.compare(0, 7, "HTTP/1.") != 0)
+        return false;
+    request.versionMinor = version[7] - '0';
+
+    request.headers.clear();
+    while (lineEnd != end)
+    {
+        begin = lineEnd + 1;
+        lineEnd = std::find(begin, end, '\n');
+        line.assign(begin, lineEnd);
+        if (!line.empty() && line.back() == '\r')
+            line.pop_back();
+        if (line.empty())
+            continue;
+
+        const auto colon = line.find(':');
+        if (colon == std::string::npos || colon == 0)
+            return false;
+
+        const auto valueBegin = line.find_first_not_of(" \t", colon + 1);
+        const auto valueEnd = line.find_last_not_of(" \t");
+        request.headers.emplace_back(toLower(line.substr(0, colon)),
+                                     valueBegin == std::string::npos ? std::string() : line.substr(valueBegin, valueEnd - valueBegin + 1));
+    }
+    return true;
+}
+
+std::string httpParseStatusToString(const HttpParseStatus &status)
+{
+    switch (status)
+    {
+    case HttpParseStatus::HP_NEED_MORE: return std::string("HP_NEED_MORE");
+
+    case HttpParseStatus::HP_COMPLETE: return std::string("HP_COMPLETE");
+
+    case HttpParseStatus::HP_FAILED: return std::string("HP_FAILED");
+
+    default: return std::string("UNKNOWN");
+    }
+}
+
+std::string toLower(std::string text)
+{
+    std::transform(text.begin(), text.end(), text.begin(), [](unsigned char symbol)
+                   { return static_cast<char>(std::tolower(symbol)); });
+    return text;
+}
+
+std::string buildHttpRequest(const std::string &method, const std::string &target, const std::string &host, const http_headers_type &headers)
+{
+    std::string request;
+    request.reserve(256);
+    request += method + " " + target + " HTTP/1.1\r\n";
+    request += "Host: " + host + "\r\n";
+    for (const auto &[name, value] : headers)
+    {
+        request += name + ": " + value + "\r\n";
+    }
+    request += "\r\n";
+    return request;
+}
+
+HttpParseStatus HttpResponseParser::feed(const char *data, std::size_t size)
+{
+    const char *end = data + size;
+
+    while (data < end && statusField == HttpParseStatus::HP_NEED_MORE)
+    {
+        switch (state)
+        {
+        case State::STATUS_LINE:
+        case State::HEADERS:
+        case State::CHUNK_SIZE:
+        case State::CHUNK_DATA_END:
+        case State::TRAILERS:
+        {
+            const char *newLine = std::find(data, end, '\n');
+            lineBuffer.append(data, newLine);
+            if (newLine == end)
+            {
+                if (lineBuffer.size() > 64 * 1024)
+                    return fail();
+                return statusField;
+            }
+            data = newLine + 1;
+
+            if (!lineBuffer.empty() && lineBuffer.back() == '\r')
+                lineBuffer.pop_back();
+
+            const std::string line = std::move(lineBuffer);
+            lineBuffer.clear();
+
+            if (!parse_line(line))
+                return fail();
+            break;
+        }
+
+        case State::BODY_LENGTH:
+        case State::CHUNK_DATA:
+        {
+            const auto count = std::min<std::size_t>(remaining, end - data);
+            if (!append_body(data, count))
+                return fail();
+            data += count;
+            remaining -= count;
+
+            if (remaining == 0)
+            {
+                if (state == State::BODY_LENGTH)
+                    return complete();
+                state = State::CHUNK_DATA_END;
+            }
+            break;
+        }
+
+        case State::BODY_UNTIL_CLOSE:
+            if (!append_body(data, end - data))
+                return fail();
+            data = end;
+            break;
+
+        case State::DONE:
+            data = end;
+            break;
+        }
+    }
+
+    return statusField;
+}
+
+HttpParseStatus HttpResponseParser::finish()
+{
+    if (statusField != HttpParseStatus::HP_NEED_MORE)
+        return statusField;
+
+    if (state == State::BODY_UNTIL_CLOSE)
+        return complete();
+
+    return fail();
+}
+
+bool HttpResponseParser::parse_line(const std::string &line)
+{
+    switch (state)
+    {
+    case State::STATUS_LINE:
+    {
+        if (line.compare(0, 5, "HTTP/") != 0)
+            return false;
+
+        const auto firstSpace = line.find(' ');
+        if (firstSpace == std::string::npos || line.size() < firstSpace + 4)
+            return false;
+
+        responseField.statusCode = std::atoi(line.c_str() + firstSpace + 1);
+        if (responseField.statusCode < 100 || responseField.statusCode > 999)
+            return false;
+
+        const auto secondSpace = line.find(' ', firstSpace + 1);
+        if (secondSpace != std::string::npos)
+            responseField.reason = line.substr(secondSpace + 1);
+
+        state = State::HEADERS;
+        return true;
+    }
+
+    case State::HEADERS:
+    {
+        if (line.empty())
+            return start_body();
+
+        const auto colon = line.find(':');
+        if (colon == std::string::npos || colon == 0)
+            return false;
+
+        auto valueBegin = line.find_first_not_of(" \t", colon + 1);
+        auto valueEnd = line.find_last_not_of(" \t");
+        std::string value = valueBegin == std::string::npos ? std::string() : line.substr(valueBegin, valueEnd - valueBegin + 1);
+
+        responseField.headers.emplace_back(toLower(line.substr(0, colon)), std::move(value));
+        return true;
+    }
+
+    case State::CHUNK_SIZE:
+    {
+        char *parsedEnd = nullptr;
+        const auto size = std::strtoull(line.c_str(), &parsedEnd, 16);
+        if (parsedEnd == line.c_str())
+            return false;
+
+        if (size == 0)
+        {
+            state = State::TRAILERS;
+        }
+        else
+        {
+            remaining = static_cast<std::size_t>(size);
+            state = State::CHUNK_DATA;
+        }
+        return true;
+    }
+
+    case State::CHUNK_DATA_END:
+        if (!line.empty())
+            return false;
+        state = State::CHUNK_SIZE;
+        return true;
+
+    case State::TRAILERS:
+        if (line.empty())
+            return complete() == HttpParseStatus::HP_COMPLETE;
+        return true;
+
+    default:
+        return false;
+    }
+}
+
+bool HttpResponseParser::start_body()
+{
+    const auto code = responseField.statusCode;
+
+    if (code < 200)
+    {
+        responseField = HttpResponse();
+        state = State::STATUS_LINE;
+        return true;
+    }
+
+    if (code == 204 || code == 304)
+    {
+        state = State::DONE;
+        statusField = HttpParseStatus::HP_COMPLETE;
+        return true;
+    }
+
+    const auto contentEncoding = responseField.header("content-encoding");
+    if (decodeContent && contentEncoding.has_value())
+    {
+        const auto encoding = parseContentEncoding(contentEncoding.value());
+        if (!encoding.has_value())
+            return false;
+
+        if (encoding.value() != ContentEncoding::IDENTITY)
+        {
+            decoder = std::make_unique<ContentDecoder>(encoding.value(), [this](const char *data, std::size_t size)
+                                                       { deliver_body(data, size); }, bodyHandler ? ContentDecoder::UNLIMITED : maxDecodedBodySize);
+        }
+    }
+
+    const auto transferEncoding = responseField.header("transfer-encoding");
+    if (transferEncoding.has_value() && toLower(transferEncoding.value()).find("chunked") != std::string::npos)
+    {
+        state = State::CHUNK_SIZE;
+        return true;
+    }
+
+    const auto contentLength = responseField.header("content-length");
+    if (contentLength.has_value())
+    {
+        char *parsedEnd = nullptr;
+        const auto length = std::strtoull(contentLength->c_str(), &parsedEnd, 10);
+        if (parsedEnd == contentLength->c_str())
+            return false;
+
+        remaining = static_cast<std::size_t>(length);
+        if (!decoder && !bodyHandler)
+            responseField.body.reserve(std::min(remaining, MAX_BODY_RESERVE));
+        state = State::BODY_LENGTH;
+
+        if (remaining == 0)
+            return complete() == HttpParseStatus::HP_COMPLETE;
+        return true;
+    }
+
+    state = State::BODY_UNTIL_CLOSE;
+    return true;
+}
+
+bool HttpResponseParser::append_body(const char *data, std::size_t size)
+{
+    bodyBytesField += size;
+
+    if (decoder)
+        return decoder->write(data, size);
+
+    deliver_body(data, size);
+    return true;
+}
+
+void HttpResponseParser::deliver_body(const char *data, std::size_t size)
+{
+    if (bodyHandler)
+        bodyHandler(data, size);
+    else
+        responseField.body.append(data, size);
+}
+
+HttpParseStatus HttpResponseParser::complete()
+{
+    if (decoder && !decoder->finish())
+        return fail();
+
+    state = State::DONE;
+    statusField = HttpParseStatus::HP_COMPLETE;
+    return statusField;
+}
+
+HttpParseStatus HttpResponseParser::fail()
+{
+    state = State::DONE;
+    statusField = HttpParseStatus::HP_FAILED;
+    return statusField;
+}
@@ -0,0 +1,78 @@
+#include "io_metrics.hpp"
+
+AtomicHistogram::AtomicHistogram(uint64_t maxValue_) : maxValue(maxValue_),
+                                                       buckets(new std::atomic<uint64_t>[LatencyHistogram::bucket_index(maxValue_) + 1]),
+                                                       bucketsCount(LatencyHistogram::bucket_index(maxValue_) + 1)
+{
+    for (std::size_t idx = 0; idx < bucketsCount; ++idx)
+    {
+        buckets[idx].store(0, std::memory_order_relaxed);
+    }
+}
+
+void AtomicHistogram::add_to(LatencyHistogram &histogram) const noexcept
+{
+    for (std::size_t idx = 0; idx < bucketsCount; ++idx)
+    {
+        const auto count = buckets[idx].load(std::memory_order_relaxed);
+        if (count != 0)
+            histogram.record(LatencyHistogram::highest_equivalent_value(idx), count);
+    }
+}
+
+IOMetrics::Shard::Shard(bool owned_) : owned(owned_),
+                                       eventsPerWait(MAX_RECORDED_EVENTS),
+                                       taskTime(MAX_RECORDED_DURATION),
+                                       handlerTime(MAX_RECORDED_DURATION)
+{
+}
+
+IOMetrics::IOMetrics() : sharedShard(std::make_unique<Shard>(false))
+{
+}
+
+IOMetrics::Shard &IOMetrics::thread_shard()
+{
+    std::lock_guard lock(shardsMutex);
+
+    auto &shard = shardsField[std::this_thread::get_id()];
+    if (!shard)
+        shard = std::make_unique<Shard>(true);
+    return *shard;
+}
+
+void IOMetrics::collect(IOMetricsSnapshot &snapshot) const
+{
+    auto addShard = [&snapshot](const Shard &shard)
+    {
+        const auto value = [&shard](IOCounter counter)
+        {
+            return shard.counters[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+        };
+
+        snapshot.waits += value(IOCounter::WAITS);
+        snapshot.events += value(IOCounter::EVENTS);
+        snapshot.wakeups += value(IOCounter::WAKEUPS);
+        snapshot.tasksExecuted += value(IOCounter::TASKS);
+        snapshot.timersFired += value(IOCounter::TIMERS);
+        snapshot.operationsCompleted += value(IOCounter::COMPLETIONS);
+        snapshot.operationsCanceled += value(IOCounter::CANCELLATIONS);
+        snapshot.bytesRead += value(IOCounter::BYTES_READ);
+        snapshot.bytesWritten += value(IOCounter::BYTES_WRITTEN);
+        snapshot.busyPolls += value(IOCounter::BUSY_POLLS);
+        snapshot.busyPollHits += value(IOCounter::BUSY_POLL_HITS);
+        snapshot.spinNanoseconds += value(IOCounter::SPIN_NANOSECONDS);
+        snapshot.sleepNanoseconds += value(IOCounter::SLEEP_NANOSECONDS);
+
+        shard.eventsPerWait.add_to(snapshot.eventsPerWait);
+        shard.taskTime.add_to(snapshot.taskTime);
+        shard.handlerTime.add_to(snapshot.handlerTime);
+    };
+
+    std::lock_guard lock(shardsMutex);
+    for (const auto &[thread, shard] : shardsField)
+    {
+        addShard(*shard);
+    }
+    addShard(*sharedShard);
+}
@@ -0,0 +1,106 @@
+#include "latency_histogram.hpp"
+
+#include <algorithm>
+#include <cmath>
+
+namespace
+{
+    constexpr uint64_t EXACT_LIMIT = uint64_t(1) << LatencyHistogram::SUB_BUCKET_BITS;
+    constexpr uint64_t HALF_SUB_BUCKETS = EXACT_LIMIT / 2;
+}
+
+LatencyHistogram::LatencyHistogram(uint64_t maxValue_) : maxValue(std::max<uint64_t>(maxValue_, 1)),
+                                                         counts(bucket_index(maxValue) + 1, 0)
+{
+}
+
+std::size_t LatencyHistogram::bucket_index(uint64_t value) noexcept
+{
+    if (value < EXACT_LIMIT)
+        return static_cast<std::size_t>(value);
+
+    // The top SUB_BUCKET_BITS bits of the value select the sub-bucket inside its power-of-two group.
+    const unsigned shift = 63 - __builtin_clzll(value) - (SUB_BUCKET_BITS - 1);
+    const auto subBucket = (value >> shift) - HALF_SUB_BUCKETS;
+    return static_cast<std::size_t>(EXACT_LIMIT + (shift - 1) * HALF_SUB_BUCKETS + subBucket);
+}
+
+uint64_t LatencyHistogram::highest_equivalent_value(std::size_t index) noexcept
+{
+    if (index < EXACT_LIMIT)
+        return index;
+
+    const auto shift = (index - EXACT_LIMIT) / HALF_SUB_BUCKETS + 1;
+    const auto subBucket = (index - EXACT_LIMIT) % HALF_SUB_BUCKETS + HALF_SUB_BUCKETS;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+void LatencyHistogram::record(uint64_t value) noexcept
+{
+    record(value, 1);
+}
+
+void LatencyHistogram::record(uint64_t value, uint64_t count) noexcept
+{
+    value = std::min(value, maxValue);
+    counts[bucket_index(value)] += count;
+    countField += count;
+    minField = std::min(minField, value);
+    maxField = std::max(maxField, value);
+}
+
+void LatencyHistogram::merge(const LatencyHistogram &other) noexcept
+{
+    const auto size = std::min(counts.size(), other.counts.size());
+    for (std::size_t idx = 0; idx < size; ++idx)
+    {
+        counts[idx] += other.counts[idx];
+    }
+    countField += other.countField;
+    minField = std::min(minField, other.minField);
+    maxField = std::max(maxField, other.maxField);
+}
+
+void LatencyHistogram::reset() noexcept
+{
+    std::fill(counts.begin(), counts.end(), 0);
+    countField = 0;
+    minField = UINT64_MAX;
+    maxField = 0;
+}
+
+uint64_t LatencyHistogram::value_at_percentile(double percentile) const noexcept
+{
+    if (countField == 0)
+        return 0;
+
+    percentile = std::clamp(percentile, 0.0, 100.0);
+    const auto target = std::max<uint64_t>(1, static_cast<uint64_t>(std::ceil(percentile / 100.0 * countField)));
+
+    uint64_t seen = 0;
+    for (std::size_t idx = 0; idx < counts.size(); ++idx)
+    {
+        seen += counts[idx];
+        if (seen >= target)
+            return std::min(highest_equivalent_value(idx), maxField);
+    }
+    return maxField;
+}
+
+double LatencyHistogram::mean() const noexcept
+{
+    if (countField == 0)
+        return 0.0;
+
+    // Midpoint of every bucket, as HdrHistogram does.
+    double total = 0.0;
+    for (std::size_t idx = 0; idx < counts.size(); ++idx)
+    {
+        if (counts[idx] == 0)
+            continue;
+        const auto high = highest_equivalent_value(idx);
+        const auto low = idx == 0 ? 0 : highest_equivalent_value(idx - 1) + 1;
+        total += counts[idx] * (static_cast<double>(low) + high) / 2.0;
+    }
+    return total / countField;
+}
@@ -0,0 +1,387 @@
+#include "rate_server.hpp"
+
+#include <algorithm>
+#include <array>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <netinet/tcp.h>
+
+#include "cross_rates.hpp"
+
+namespace
+{
+    std::string formatNumber(double value)
+    {
+        std::array<char, 32> buffer;
+        const auto size = std::snprintf(buffer.data(), buffer.size(), "%.10g", value);
+        return std::string(buffer.data(), size);
+    }
+
+    std::string makeResponse(int statusCode, const std::string &reason, const std::string &body)
+    {
+        std::string response;
+        response.reserve(body.size() + 128);
+        response += "HTTP/1.1 " + std::to_string(statusCode) + " " + reason + "\r\n";
+        response += "Content-Type: application/json\r\n";
+        response += "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n";
+        response += body;
+        return response;
+    }
+
+    std::string valuteJson(const Valute &valute)
+    {
+        return "{\"code\":\"" + valute.CharCode + "\",\"id\":\"" + valute.ID + "\",\"numCode\":" + std::to_string(valute.NumCode) +
+               ",\"nominal\":" + std::to_string(valute.Nominal) + ",\"value\":" + formatNumber(valute.Value) +
+               ",\"unitRate\":" + formatNumber(unitRate(valute)) + "}";
+    }
+
+    const std::string &notFoundResponse()
+    {
+        static const std::string response = makeResponse(404, "Not Found", "{\"error\":\"not found\"}");
+        return response;
+    }
+
+    const std::string &methodNotAllowedResponse()
+    {
+        static const std::string response = makeResponse(405, "Method Not Allowed", "{\"error\":\"method not allowed\"}");
+        return response;
+    }
+
+    // A decimal number without sign or trailing characters that fits the request limit; anything else, including a
+    // value that would overflow the offset arithmetic, is rejected.
+    bool parseContentLength(const std::string &text, std::size_t limit, std::size_t &value)
+    {
+        if (text.empty() || !std::all_of(text.cbegin(), text.cend(), ::isdigit))
+            return false;
+
+        errno = 0;
+        char *end = nullptr;
+        const auto parsed = std::strtoull(text.c_str(), &end, 10);
+        if (errno == ERANGE || *end != '\0' || parsed > limit)
+            return false;
+
+        value = static_cast<std::size_t>(parsed);
+        return true;
+    }
+
+    const std::string &badRequestResponse()
+    {
+        static const std::string response = makeResponse(400, "Bad Request", "{\"error\":\"bad request\"}");
+        return response;
+    }
+}
+
+RateSnapshot::RateSnapshot(const rates_table_type &table, const day_type &day) : dayField(day)
+{
+    const auto date = formatCbrDate(day);
+
+    std::string all = "{\"date\":\"" + date + "\",\"base\":\"" + CrossRateMatrix::BASE_CURRENCY + "\",\"rates\":[";
+    bool first = true;
+    for (const auto &[code, valute] : table)
+    {
+        const auto json = valuteJson(valute);
+        all += (first ? "" : ",") + json;
+        first = false;
+        responsesField.emplace("/rates/" + code, makeResponse(200, "OK", "{\"date\":\"" + date + "\",\"rate\":" + json + "}"));
+    }
+    all += "]}";
+    responsesField.emplace("/rates", makeResponse(200, "OK", all));
+
+    const CrossRateMatrix matrix(table);
+    const auto &codes = matrix.codes();
+    responsesField.reserve(responsesField.size() + codes.size() * codes.size());
+
+    for (CrossRateMatrix::index_type from = 0; from < codes.size(); ++from)
+    {
+        for (CrossRateMatrix::index_type to = 0; to < codes.size(); ++to)
+        {
+            responsesField.emplace("/cross/" + codes[from] + "/" + codes[to],
+                                   makeResponse(200, "OK", "{\"date\":\"" + date + "\",\"from\":\"" + codes[from] + "\",\"to\":\"" + codes[to] +
+                                                               "\",\"rate\":" + formatNumber(matrix.rate(from, to)) + "}"));
+        }
+    }
+}
+
+const std::string *RateSnapshot::find(const std::string &target) const noexcept
+{
+    const auto iter = responsesField.find(target);
+    return iter == responsesField.end() ? nullptr : &iter->second;
+}
+
+// What connections use of the server. Shared with them, so that handlers still queued in the context when the server
+// is destroyed find it alive.
+struct RateServer::State
+{
+    explicit State(IOContext &context_) : context(context_)
+    {
+    }
+
+    IOContext &context;
+    snapshot_pointer snapshotField;
+    std::atomic<std::size_t> requestsServed{0};
+
+    std::mutex connectionsMutex;
+    std::unordered_map<Connection *, std::weak_ptr<Connection>> connectionsField;
+    // Under connectionsMutex: a connection accepted while stop() runs is either shut down by it or dropped.
+    bool stopped = false;
+
+    snapshot_pointer snapshot() const noexcept
+    {
+        return std::atomic_load_explicit(&snapshotField, std::memory_order_acquire);
+    }
+
+    void release(Connection *connection)
+    {
+        std::lock_guard lock(connectionsMutex);
+        connectionsField.erase(connection);
+    }
+};
+
+class RateServer::Connection : public std::enable_shared_from_this<RateServer::Connection>
+{
+public:
+    static constexpr int MAX_INLINE_DEPTH = 32;
+
+    Connection(std::shared_ptr<State> server_, TCPAsyncAcceptor::socket_pointer socket_) : server(std::move(server_)), socket(std::move(socket_)), readBuffer(READ_BUFFER_SIZE)
+    {
+    }
+
+    void start()
+    {
+        read();
+    }
+
+    void shutdown_socket()
+    {
+        ::shutdown(socket->get_socket(), SHUT_RDWR);
+    }
+
+private:
+    std::shared_ptr<State> server;
+    TCPAsyncAcceptor::socket_pointer socket;
+    std::vector<char> readBuffer;
+    std::string pending;
+    std::vector<char> writeBuffer;
+    bool closeAfterWrite = false;
+
+    void read()
+    {
+        // Reads and writes complete inline while the socket is ready, bound the recursion of a busy connection.
+        static thread_local int inlineDepth = 0;
+        if (inlineDepth >= MAX_INLINE_DEPTH)
+        {
+            server->context.post([self = shared_from_this()]()
+                                { self->read(); });
+            return;
+        }
+
+        ++inlineDepth;
+        auto self = shared_from_this();
+        socket->async_read(readBuffer, [self](const std::error_code &error, size_t bytesRead)
+                           {
+            if (error || bytesRead == 0)
+            {
+                self->server->release(self.get());
+                return;
+            }
+
+            self->pending.append(self->readBuffer.data(), bytesRead);
+            self->process(); });
+        --inlineDepth;
+    }
+
+    void process()
+    {
+        const auto snapshot = server->snapshot();
+        std::size_t offset = 0;
+        std::size_t served = 0;
+
+        while (!closeAfterWrite)
+        {
+            const auto headEnd = pending.find("\r\n\r\n", offset);
+            if (headEnd == std::string::npos)
+                break;
+
+            HttpRequest request;
+            if (!parseHttpRequestHead(pending.data() + offset, pending.data() + headEnd, request))
+            {
+                append(badRequestResponse());
+                closeAfterWrite = true;
+                offset = pending.size();
+                break;
+            }
+
+            std::size_t bodySize = 0;
+            const auto contentLength = request.header("content-length");
+            // The body limit is what MAX_REQUEST_SIZE leaves after this request's head.
+            const auto headSize = headEnd + 4 - offset;
+            const auto bodyLimit = headSize < MAX_REQUEST_SIZE ? MAX_REQUEST_SIZE - headSize : 0;
+            if (contentLength.has_value() && !parseContentLength(*contentLength, bodyLimit, bodySize))
+            {
+                append(badRequestResponse());
+                closeAfterWrite = true;
+                offset = pending.size();
+                break;
+            }
+            if (headEnd + 4 + bodySize > pending.size())
+                break;
+            offset = headEnd + 4 + bodySize;
+
+            const std::string *response = nullptr;
+            if (request.method != "GET")
+                response = &methodNotAllowedResponse();
+            else if (snapshot)
+                response = snapshot->find(request.target);
+
+            append(response != nullptr ? *response : notFoundResponse());
+            ++served;
+
+            if (!request.keep_alive())
+                closeAfterWrite = true;
+        }
+
+        pending.erase(0, offset);
+        server->requestsServed.fetch_add(served, std::memory_order_relaxed);
+
+        if (pending.size() > MAX_REQUEST_SIZE && !closeAfterWrite)
+        {
+            append(badRequestResponse());
+            closeAfterWrite = true;
+        }
+
+        if (writeBuffer.empty())
+        {
+            if (closeAfterWrite)
+                server->release(this);
+            else
+                read();
+            return;
+        }
+
+        write();
+    }
+
+    void append(const std::string &response)
+    {
+        writeBuffer.insert(writeBuffer.end(), response.cbegin(), response.cend());
+    }
+
+    void write()
+    {
+        auto self = shared_from_this();
+        socket->async_write(writeBuffer, [self](const std::error_code &error, size_t bytesWritten)
+                            {
+            if (error)
+            {
+                self->server->release(self.get());
+                return;
+            }
+
+            self->writeBuffer.erase(self->writeBuffer.begin(), self->writeBuffer.begin() + bytesWritten);
+            if (!self->writeBuffer.empty())
+            {
+                self->write();
+            }
+            else if (self->closeAfterWrite)
+            {
+                self->server->release(self.get());
+            }
+            else if (self->pending.find("\r\n\r\n") != std::string::npos)
+            {
+                self->process();
+            }
+            else
+            {
+                self->read();
+            } });
+    }
+};
+
+RateServer::RateServer(IOContext &context_, EndpointIPv4 &endpoint, bool reusePort) : state(std::make_shared<State>(context_)),
+                                                                                      acceptor(std::make_shared<TCPAsyncAcceptor>(context_, endpoint, reusePort))
+{
+}
+
+RateServer::~RateServer()
+{
+    stop();
+}
+
+void RateServer::start()
+{
+    {
+        std::lock_guard lock(state->connectionsMutex);
+        state->stopped = false;
+    }
+    accept_next(state, acceptor);
+}
+
+void RateServer::stop()
+{
+    {
+        std::lock_guard lock(state->connectionsMutex);
+        state->stopped = true;
+    }
+    acceptor->close();
+
+    std::vector<std::shared_ptr<Connection>> connections;
+    {
+        std::lock_guard lock(state->connectionsMutex);
+        for (const auto &[pointer, weak] : state->connectionsField)
+        {
+            if (auto connection = weak.lock())
+                connections.push_back(std::move(connection));
+        }
+    }
+
+    for (const auto &connection : connections)
+    {
+        connection->shutdown_socket();
+    }
+}
+
+void RateServer::update(const rates_table_type &table, const day_type &day)
+{
+    snapshot_pointer snapshot = std::make_shared<const RateSnapshot>(table, day);
+    std::atomic_store_explicit(&state->snapshotField, std::move(snapshot), std::memory_order_release);
+}
+
+RateServer::snapshot_pointer RateServer::snapshot() const noexcept
+{
+    return state->snapshot();
+}
+
+std::size_t RateServer::requests_served() const noexcept
+{
+    return state->requestsServed.load(std::memory_order_relaxed);
+}
+
+std::size_t RateServer::connections_count() const
+{
+    std::lock_guard lock(state->connectionsMutex);
+    return state->connectionsField.size();
+}
+
+void RateServer::accept_next(const std::shared_ptr<State> &state, const std::shared_ptr<TCPAsyncAcceptor> &acceptor)
+{
+    acceptor->async_accept([state, weakAcceptor = std::weak_ptr<TCPAsyncAcceptor>(acceptor)](const std::error_code &error, TCPAsyncAcceptor::socket_pointer socket)
+                           {
+        if (error)
+            return;
+
+        int enable = 1;
+        setsockopt(socket->get_socket(), IPPROTO_TCP, TCP_NODELAY, &enable, sizeof(enable));
+
+        auto connection = std::make_shared<Connection>(state, std::move(socket));
+        {
+            std::lock_guard lock(state->connectionsMutex);
+            if (state->stopped)
+                return;
+            state->connectionsField.emplace(connection.get(), connection);
+        }
+        connection->start();
+
+        if (const auto acceptor = weakAcceptor.lock())
+            accept_next(state, acceptor); });
+}
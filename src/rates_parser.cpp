@@ -0,0 +1,338 @@
+#include "rates_parser.hpp"
+
+#include <array>
+#include <algorithm>
+#include <optional>
+#include <cctype>
+#include <cstdlib>
+#include <cstring>
+
+#include <boost/property_tree/detail/rapidxml.hpp>
+
+namespace
+{
+    using namespace boost::property_tree::detail::rapidxml;
+    using node_pointer = xml_node<> *;
+
+    node_pointer requireNode(node_pointer parent, const char *name)
+    {
+        node_pointer node = parent->first_node(name);
+        if (node == nullptr)
+        {
+            throw std::runtime_error(std::string("Missing <") + name + "> element");
+        }
+        return node;
+    }
+
+    int parseInteger(node_pointer node)
+    {
+        const std::string text(node->value(), node->value_size());
+        char *end = nullptr;
+        const long value = std::strtol(text.c_str(), &end, 10);
+        if (end == text.c_str())
+        {
+            throw std::runtime_error("Invalid integer in <" + std::string(node->name(), node->name_size()) + ">");
+        }
+        return static_cast<int>(value);
+    }
+}
+
+float parseCbrDecimal(const char *text, std::size_t size)
+{
+    std::array<char, 64> buffer;
+    if (size == 0 || size >= buffer.size())
+    {
+        throw std::runtime_error("Invalid decimal value");
+    }
+
+    std::memcpy(buffer.data(), text, size);
+    buffer[size] = '\0';
+    for (std::size_t idx = 0; idx < size; ++idx)
+    {
+        if (buffer[idx] == ',')
+            buffer[idx] = '.';
+    }
+
+    char *end = nullptr;
+    const float value = std::strtof(buffer.data(), &end);
+    if (end == buffer.data())
+    {
+        throw std::runtime_error("Invalid decimal value");
+    }
+    return value;
+}
+
+rates_table_type parseDailyRates(std::string document)
+{
+    rates_table_type table;
+
+    try
+    {
+        xml_document<> doc;
+        doc.parse<0>(&document[0]);
+
+        node_pointer rootNode = doc.first_node("ValCurs");
+        if (rootNode == nullptr)
+        {
+            throw std::runtime_error("Missing <ValCurs> element");
+        }
+
+        for (node_pointer valuteNode = rootNode->first_node("Valute"); valuteNode; valuteNode = valuteNode->next_sibling("Valute"))
+        {
+            Valute valute;
+
+            const auto idAttribute = valuteNode->first_attribute("ID");
+            if (idAttribute != nullptr)
+                valute.ID = std::string(idAttribute->value(), idAttribute->value_size());
+
+            valute.NumCode = parseInteger(requireNode(valuteNode, "NumCode"));
+
+            node_pointer charNode = requireNode(valuteNode, "CharCode");
+            valute.CharCode = std::string(charNode->value(), charNode->value_size());
+
+            valute.Nominal = parseInteger(requireNode(valuteNode, "Nominal"));
+
+            node_pointer nameNode = requireNode(valuteNode, "Name");
+            valute.Name = std::string(nameNode->value(), nameNode->value_size());
+
+            node_pointer valueNode = requireNode(valuteNode, "Value");
+            valute.Value = parseCbrDecimal(valueNode->value(), valueNode->value_size());
+
+            node_pointer vunitRateNode = valuteNode->first_node("VunitRate");
+            valute.VunitRate = vunitRateNode != nullptr ? parseCbrDecimal(vunitRateNode->value(), vunitRateNode->value_size())
+                                                        : valute.Value / valute.Nominal;
+
+            table.insert_or_assign(valute.CharCode, std::move(valute));
+        }
+    }
+    catch (const parse_error &error)
+    {
+        throw std::runtime_error(std::string("XML parse error: ") + error.what());
+    }
+
+    return table;
+}
+
+namespace
+{
+    std::optional<std::string> findAttribute(const std::string &attributes, const std::string &name)
+    {
+        std::size_t position = 0;
+        while ((position = attributes.find(name, position)) != std::string::npos)
+        {
+            const bool boundary = position == 0 || std::isspace(static_cast<unsigned char>(attributes[position - 1]));
+            auto cursor = position + name.size();
+            while (cursor < attributes.size() && std::isspace(static_cast<unsigned char>(attributes[cursor])))
+                ++cursor;
+
+            if (boundary && cursor < attributes.size() && attributes[cursor] == '=')
+            {
+                ++cursor;
+                while (cursor < attributes.size() && std::isspace(static_cast<unsigned char>(attributes[cursor])))
+                    ++cursor;
+                if (cursor >= attributes.size() || (attributes[cursor] != '"' && attributes[cursor] != '\''))
+                    return std::nullopt;
+
+                const auto quote = attributes[cursor];
+                const auto close = attributes.find(quote, cursor + 1);
+                if (close == std::string::npos)
+                    return std::nullopt;
+                return attributes.substr(cursor + 1, close - cursor - 1);
+            }
+            position += name.size();
+        }
+        return std::nullopt;
+    }
+
+    std::string trim(const std::string &text)
+    {
+        const auto begin = text.find_first_not_of(" \t\r\n");
+        if (begin == std::string::npos)
+            return std::string();
+        const auto end = text.find_last_not_of(" \t\r\n");
+        return text.substr(begin, end - begin + 1);
+    }
+}
+
+DynamicRatesParser::DynamicRatesParser(record_handler_type handler_) : handler(std::move(handler_))
+{
+}
+
+bool DynamicRatesParser::feed(const char *data, std::size_t size)
+{
+    if (failed)
+        return false;
+
+    pending.append(data, size);
+
+    const char *cursor = pending.data();
+    const char *end = pending.data() + pending.size();
+
+    while (cursor < end)
+    {
+        const char *tagBegin = std::find(cursor, end, '<');
+        if (insideRecord && !element.empty())
+            text.append(cursor, tagBegin);
+
+        cursor = tagBegin;
+        if (cursor == end)
+            break;
+
+        const char *tagEnd = std::find(cursor, end, '>');
+        if (tagEnd == end)
+            break;
+
+        if (!handle_tag(cursor + 1, tagEnd))
+        {
+            failed = true;
+            pending.clear();
+            return false;
+        }
+        cursor = tagEnd + 1;
+    }
+
+    pending.erase(0, cursor - pending.data());
+
+    if (pending.size() > MAX_PENDING_SIZE)
+    {
+        failed = true;
+        pending.clear();
+        return false;
+    }
+    return true;
+}
+
+bool DynamicRatesParser::finish() const noexcept
+{
+    return !failed && rootClosed && !insideRecord;
+}
+
+bool DynamicRatesParser::handle_tag(const char *begin, const char *end)
+{
+    if (begin == end)
+        return false;
+
+    if (*begin == '?' || *begin == '!')
+        return true;
+
+    if (*begin == '/')
+        return end_element(trim(std::string(begin + 1, end)));
+
+    const bool selfClosing = *(end - 1) == '/';
+    if (selfClosing)
+        --end;
+
+    const char *nameEnd = begin;
+    while (nameEnd < end && !std::isspace(static_cast<unsigned char>(*nameEnd)))
+        ++nameEnd;
+
+    const std::string name(begin, nameEnd);
+    const std::string attributes(nameEnd, end);
+
+    if (!insideRoot)
+    {
+        if (name != "ValCurs" || rootClosed)
+            return false;
+        insideRoot = true;
+        if (selfClosing)
+        {
+            insideRoot = false;
+            rootClosed = true;
+        }
+        return true;
+    }
+
+    if (name == "Record")
+    {
+        if (insideRecord || !start_record(attributes))
+            return false;
+        return selfClosing ? end_element(name) : true;
+    }
+
+    if (insideRecord)
+    {
+        element = name;
+        text.clear();
+        if (selfClosing)
+            return end_element(name);
+    }
+    return true;
+}
+
+bool DynamicRatesParser::start_record(const std::string &attributes)
+{
+    const auto date = findAttribute(attributes, "Date");
+    if (!date.has_value())
+        return false;
+
+    const auto day = parseCbrDate(date.value());
+    if (!day.has_value())
+        return false;
+
+    record = DatedValute{};
+    record.day = day.value();
+    record.valute.ID = findAttribute(attributes, "Id").value_or(std::string());
+    record.valute.NumCode = 0;
+    record.valute.Nominal = 1;
+    record.valute.Value = 0.0f;
+    record.valute.VunitRate = 0.0f;
+    insideRecord = true;
+    hasValue = false;
+    element.clear();
+    return true;
+}
+
+bool DynamicRatesParser::end_element(const std::string &name)
+{
+    if (name == "ValCurs")
+    {
+        if (!insideRoot || insideRecord)
+            return false;
+        insideRoot = false;
+        rootClosed = true;
+        return true;
+    }
+
+    if (name == "Record")
+    {
+        if (!insideRecord || !hasValue || record.valute.Nominal <= 0)
+            return false;
+
+        if (!(record.valute.VunitRate > 0.0f))
+            record.valute.VunitRate = record.valute.Value / record.valute.Nominal;
+
+        insideRecord = false;
+        ++recordsCount;
+        handler(std::move(record));
+        return true;
+    }
+
+    if (!insideRecord || name != element)
+        return true;
+
+    const auto value = trim(text);
+    element.clear();
+    text.clear();
+
+    try
+    {
+        if (name == "Nominal")
+        {
+            record.valute.Nominal = std::stoi(value);
+        }
+        else if (name == "Value")
+        {
+            record.valute.Value = parseCbrDecimal(value.data(), value.size());
+            hasValue = true;
+        }
+        else if (name == "VunitRate")
+        {
+            record.valute.VunitRate = parseCbrDecimal(value.data(), value.size());
+        }
+    }
+    catch (const std::exception &)
+    {
+        return false;
+    }
+    return true;
+}
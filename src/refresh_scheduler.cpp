@@ -0,0 +1,134 @@
+#include "refresh_scheduler.hpp"
+
+#include <ctime>
+
+namespace
+{
+    RefreshPolicy::duration_type moscowTimeOfDay()
+    {
+        constexpr std::time_t MOSCOW_OFFSET = 3 * 60 * 60;
+        constexpr std::time_t SECONDS_PER_DAY = 24 * 60 * 60;
+        return std::chrono::seconds((std::time(nullptr) + MOSCOW_OFFSET) % SECONDS_PER_DAY);
+    }
+}
+
+RefreshPolicy::duration_type refreshDelay(const RefreshPolicy &policy, RefreshPolicy::duration_type timeOfDay)
+{
+    const auto windowBegin = policy.publicationTime - policy.publicationWindow;
+    const auto windowEnd = policy.publicationTime + policy.publicationWindow;
+
+    if (timeOfDay >= windowBegin && timeOfDay < windowEnd)
+        return std::min(policy.publicationInterval, policy.interval);
+
+    if (timeOfDay < windowBegin && timeOfDay + policy.interval > windowBegin)
+        return windowBegin - timeOfDay;
+
+    return policy.interval;
+}
+
+RefreshScheduler::RefreshScheduler(IOContext &context_, CbrClient &client_, RefreshPolicy policy_) : context(context_), client(client_), policy(std::move(policy_))
+{
+}
+
+RefreshScheduler::~RefreshScheduler()
+{
+    stop();
+}
+
+RefreshScheduler::query_type RefreshScheduler::add_daily(int dayOffset)
+{
+    auto query = std::make_unique<Query>();
+    query->index = queries.size();
+    query->dayOffset = dayOffset;
+    queries.push_back(std::move(query));
+    return queries.size() - 1;
+}
+
+void RefreshScheduler::set_update_handler(update_handler_type handler)
+{
+    updateHandler = std::move(handler);
+}
+
+void RefreshScheduler::start()
+{
+    running.store(true, std::memory_order_release);
+    for (auto &query : queries)
+    {
+        schedule(*query, RefreshPolicy::duration_type::zero());
+    }
+}
+
+void RefreshScheduler::stop()
+{
+    running.store(false, std::memory_order_release);
+
+    std::lock_guard lock(scheduleMutex);
+    for (auto &query : queries)
+    {
+        if (query->timer != 0)
+            context.cancel_timer(query->timer);
+        query->timer = 0;
+    }
+}
+
+rates_pointer RefreshScheduler::rates(query_type query) const noexcept
+{
+    if (query >= queries.size())
+        return nullptr;
+    return std::atomic_load_explicit(&queries[query]->rates, std::memory_order_acquire);
+}
+
+void RefreshScheduler::refresh(Query &query)
+{
+    if (!running.load(std::memory_order_acquire))
+        return;
+
+    const auto day = currentCbrDay() + query.dayOffset;
+
+    client.get_daily_rates(day, [this, &query, day](const std::error_code &error, rates_pointer rates)
+                           {
+        if (error || !rates)
+        {
+            failuresField.fetch_add(1, std::memory_order_relaxed);
+            schedule(query, policy.retryInterval);
+            return;
+        }
+
+        refreshesField.fetch_add(1, std::memory_order_relaxed);
+
+        // A 304 revalidation returns the cached table itself, readers only see a swap when the data changed.
+        const auto previous = std::atomic_load_explicit(&query.rates, std::memory_order_acquire);
+        if (previous != rates)
+        {
+            std::atomic_store_explicit(&query.rates, rates, std::memory_order_release);
+            if (updateHandler)
+                updateHandler(query.index, day, rates);
+        }
+
+        schedule(query, refreshDelay(policy, moscowTimeOfDay())); });
+}
+
+void RefreshScheduler::schedule(Query &query, RefreshPolicy::duration_type delay)
+{
+    if (!running.load(std::memory_order_acquire))
+        return;
+
+    if (delay > RefreshPolicy::duration_type::zero() && policy.jitter > 0.0)
+    {
+        std::lock_guard lock(scheduleMutex);
+        std::uniform_real_distribution<double> spread(-policy.jitter, policy.jitter);
+        delay += std::chrono::duration_cast<RefreshPolicy::duration_type>(delay * spread(generator));
+    }
+
+    std::lock_guard lock(scheduleMutex);
+    if (!running.load(std::memory_order_acquire))
+        return;
+
+    query.timer = context.post_after(delay, [this, &query]
+                                     {
+        {
+            std::lock_guard lock(scheduleMutex);
+            query.timer = 0;
+        }
+        refresh(query); });
+}
@@ -0,0 +1,61 @@
+#include "response_cache.hpp"
+
+std::optional<CachedResponse> ResponseCache::find(const std::string &uri) const
+{
+    std::lock_guard lock(entriesMutex);
+    const auto iter = entriesField.find(uri);
+    if (iter == entriesField.end())
+        return std::nullopt;
+    return iter->second;
+}
+
+void ResponseCache::store(const std::string &uri, CachedResponse response)
+{
+    std::lock_guard lock(entriesMutex);
+    entriesField.insert_or_assign(uri, std::move(response));
+}
+
+void ResponseCache::erase(const std::string &uri)
+{
+    std::lock_guard lock(entriesMutex);
+    entriesField.erase(uri);
+}
+
+void ResponseCache::clear()
+{
+    std::lock_guard lock(entriesMutex);
+    entriesField.clear();
+}
+
+std::size_t ResponseCache::size() const
+{
+    std::lock_guard lock(entriesMutex);
+    return entriesField.size();
+}
+
+void ResponseCache::record_hit(const CachedResponse &response) noexcept
+{
+    hitsField.fetch_add(1, std::memory_order_relaxed);
+    bytesSavedField.fetch_add(response.bodySize, std::memory_order_relaxed);
+}
+
+void ResponseCache::record_not_modified(const CachedResponse &response) noexcept
+{
+    notModifiedField.fetch_add(1, std::memory_order_relaxed);
+    bytesSavedField.fetch_add(response.bodySize, std::memory_order_relaxed);
+}
+
+void ResponseCache::record_miss() noexcept
+{
+    missesField.fetch_add(1, std::memory_order_relaxed);
+}
+
+CacheStatistics ResponseCache::statistics() const noexcept
+{
+    CacheStatistics statistics;
+    statistics.hits = hitsField.load(std::memory_order_relaxed);
+    statistics.notModified = notModifiedField.load(std::memory_order_relaxed);
+    statistics.misses = missesField.load(std::memory_order_relaxed);
+    statistics.bytesSaved = bytesSavedField.load(std::memory_order_relaxed);
+    return statistics;
+}
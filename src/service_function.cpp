@@ -1,5 +1,7 @@
 #include "service_function.hpp"
 
+#include <iconv.h>
+
 std::optional<std::string> getUserName() noexcept
 {
     const auto UID = getuid();
@@ -68,18 +70,19 @@ std::string logLevelToString(const LogLevel &logLevel)
     }
 }
 
-ConsoleLogger &ConsoleLogger::getLogger()
-{
-    static ConsoleLogger logger;
-    return logger;
-}
-
-void ConsoleLogger::loggingMessage(const LogLevel &logLevel, const std::string &message)
-{
-    const auto userName = getUserName();
-    std::stringstream stream;
-
-    if(userName.has_value()) stream << userName.value() << " ";
-    stream << getDateAsText() << " " << logLevelToString(logLevel) << " MESSAGE: " << message << "\n";
-    std::cout << stream.str();
+std::string win1251_to_utf8_impl(const std::string& input) {
+    iconv_t cd = iconv_open("UTF-8", "CP1251");
+    if (cd == (iconv_t)-1) return input;
+    
+    char* in_ptr = const_cast<char*>(input.data());
+    size_t in_bytes = input.size();
+    
+    std::string output(input.size() * 2, '\0');
+    char* out_ptr = &output[0];
+    size_t out_bytes = output.size();
+    
+    iconv(cd, &in_ptr, &in_bytes, &out_ptr, &out_bytes);
+    output.resize(output.size() - out_bytes);
+    iconv_close(cd);
+    return output;
 }
@@ -0,0 +1,160 @@
+#include "strand.hpp"
+
+#include <thread>
+
+struct Strand::State : std::enable_shared_from_this<Strand::State>
+{
+    struct Node
+    {
+        std::atomic<Node *> next{nullptr};
+        task_type task;
+    };
+
+    explicit State(IOContext &context_) : context(context_), head(&stub), tail(&stub)
+    {
+    }
+
+    ~State()
+    {
+        while (Node *node = pop())
+        {
+            delete node;
+        }
+    }
+
+    IOContext &context;
+
+    // Vyukov MPSC queue with one heap node per task: producers exchange head, the single consumer owning the strand
+    // walks from tail.
+    Node stub;
+    std::atomic<Node *> head;
+    Node *tail;
+    std::atomic<std::size_t> pending{0};
+
+    static const State *&current() noexcept
+    {
+        thread_local const State *value = nullptr;
+        return value;
+    }
+
+    void push(Node *node) noexcept
+    {
+        node->next.store(nullptr, std::memory_order_relaxed);
+        Node *previous = head.exchange(node, std::memory_order_acq_rel);
+        previous->next.store(node, std::memory_order_release);
+    }
+
+    // Returns nullptr when the queue is empty or a producer has not linked its node yet.
+    Node *pop() noexcept
+    {
+        Node *first = tail;
+        Node *next = first->next.load(std::memory_order_acquire);
+
+        if (first == &stub)
+        {
+            if (next == nullptr)
+                return nullptr;
+            tail = next;
+            first = next;
+            next = next->next.load(std::memory_order_acquire);
+        }
+
+        if (next != nullptr)
+        {
+            tail = next;
+            return first;
+        }
+
+        if (first != head.load(std::memory_order_acquire))
+            return nullptr;
+
+        push(&stub);
+        next = first->next.load(std::memory_order_acquire);
+        if (next != nullptr)
+        {
+            tail = next;
+            return first;
+        }
+        return nullptr;
+    }
+
+    void enqueue(task_type task)
+    {
+        push(new Node{nullptr, std::move(task)});
+
+        if (pending.fetch_add(1, std::memory_order_acq_rel) == 0)
+            schedule();
+    }
+
+    void schedule()
+    {
+        context.post([self = shared_from_this()]
+                     { self->drain(); });
+    }
+
+    void drain()
+    {
+        const State *outer = current();
+        current() = this;
+
+        for (std::size_t executed = 0; executed < MAX_BATCH_SIZE; ++executed)
+        {
+            Node *node = pop();
+            while (node == nullptr)
+            {
+                // The counter says a task is queued but its producer is between exchange and link.
+                std::this_thread::yield();
+                node = pop();
+            }
+
+            std::unique_ptr<Node> owned(node);
+            try
+            {
+                owned->task();
+            }
+            catch (...)
+            {
+                // The task still counts as run: without this the counter never reaches zero again and no later post
+                // schedules a drain.
+                current() = outer;
+                if (pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+                    schedule();
+                throw;
+            }
+
+            if (pending.fetch_sub(1, std::memory_order_acq_rel) == 1)
+            {
+                current() = outer;
+                return;
+            }
+        }
+
+        current() = outer;
+        // The strand still owns the remaining tasks; continue in a fresh drain so other handlers get the thread.
+        schedule();
+    }
+};
+
+Strand::Strand(IOContext &context_) : state(std::make_shared<State>(context_))
+{
+}
+
+void Strand::post(task_type task) const
+{
+    state->enqueue(std::move(task));
+}
+
+void Strand::dispatch(task_type task) const
+{
+    if (running_in_this_thread())
+    {
+        task();
+        return;
+    }
+    post(std::move(task));
+}
+
+bool Strand::running_in_this_thread() const noexcept
+{
+    return State::current() == state.get();
+}
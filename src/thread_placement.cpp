@@ -0,0 +1,206 @@
+#include "thread_placement.hpp"
+
+#include <algorithm>
+#include <array>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <cerrno>
+#include <cstdlib>
+#include <linux/mempolicy.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+namespace
+{
+    std::vector<int> allowedCpus()
+    {
+        std::vector<int> cpus;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        if (sched_getaffinity(0, sizeof(set), &set) != 0)
+            return cpus;
+
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu)
+        {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+        return cpus;
+    }
+
+    std::vector<NumaNode> readNodes(const std::vector<int> &allowed)
+    {
+        std::vector<NumaNode> nodes;
+        std::error_code error;
+        for (const auto &entry : std::filesystem::directory_iterator("/sys/devices/system/node", error))
+        {
+            const auto name = entry.path().filename().string();
+            if (name.rfind("node", 0) != 0 || name.size() == 4 || !std::all_of(name.begin() + 4, name.end(), ::isdigit))
+                continue;
+
+            std::ifstream stream(entry.path() / "cpulist");
+            std::string list;
+            std::getline(stream, list);
+
+            NumaNode node{std::atoi(name.c_str() + 4), {}};
+            for (const auto cpu : parseCpuList(list))
+            {
+                if (std::binary_search(allowed.begin(), allowed.end(), cpu))
+                    node.cpus.push_back(cpu);
+            }
+            if (!node.cpus.empty())
+                nodes.push_back(std::move(node));
+        }
+
+        std::sort(nodes.begin(), nodes.end(), [](const NumaNode &left, const NumaNode &right)
+                  { return left.id < right.id; });
+        if (nodes.empty() && !allowed.empty())
+            nodes.push_back(NumaNode{0, allowed});
+        return nodes;
+    }
+}
+
+std::vector<int> parseCpuList(const std::string &text)
+{
+    std::vector<int> cpus;
+    std::stringstream stream(text);
+    std::string range;
+    while (std::getline(stream, range, ','))
+    {
+        char *end = nullptr;
+        const auto first = std::strtol(range.c_str(), &end, 10);
+        if (end == range.c_str() || first < 0)
+            continue;
+
+        auto last = first;
+        if (*end == '-')
+        {
+            const char *start = end + 1;
+            last = std::strtol(start, &end, 10);
+            if (end == start || last < first)
+                continue;
+        }
+        for (auto cpu = first; cpu <= last; ++cpu)
+        {
+            cpus.push_back(static_cast<int>(cpu));
+        }
+    }
+    std::sort(cpus.begin(), cpus.end());
+    cpus.erase(std::unique(cpus.begin(), cpus.end()), cpus.end());
+    return cpus;
+}
+
+CpuTopology::CpuTopology(std::vector<NumaNode> nodes_) : nodesField(std::move(nodes_))
+{
+}
+
+const CpuTopology &CpuTopology::system()
+{
+    static const CpuTopology topology(readNodes(allowedCpus()));
+    return topology;
+}
+
+int CpuTopology::node_of(int cpu) const noexcept
+{
+    for (const auto &node : nodesField)
+    {
+        if (std::find(node.cpus.begin(), node.cpus.end(), cpu) != node.cpus.end())
+            return node.id;
+    }
+    return -1;
+}
+
+ThreadPlacement ThreadPlacement::compact()
+{
+    ThreadPlacement placement;
+    placement.policy = PlacementPolicy::COMPACT;
+    return placement;
+}
+
+ThreadPlacement ThreadPlacement::spread()
+{
+    ThreadPlacement placement;
+    placement.policy = PlacementPolicy::SPREAD;
+    return placement;
+}
+
+ThreadPlacement ThreadPlacement::cpus(std::vector<std::vector<int>> cpuSets_)
+{
+    ThreadPlacement placement;
+    placement.cpuSets = std::move(cpuSets_);
+    return placement;
+}
+
+std::vector<int> ThreadPlacement::cpus_for(std::size_t index, const CpuTopology &topology) const
+{
+    if (!cpuSets.empty())
+        return cpuSets[index % cpuSets.size()];
+
+    const auto &nodes = topology.nodes();
+    if (policy == PlacementPolicy::NONE || nodes.empty())
+        return {};
+
+    if (policy == PlacementPolicy::SPREAD)
+    {
+        const auto &node = nodes[index % nodes.size()];
+        return {node.cpus[(index / nodes.size()) % node.cpus.size()]};
+    }
+
+    std::size_t total = 0;
+    for (const auto &node : nodes)
+    {
+        total += node.cpus.size();
+    }
+    auto position = index % total;
+    for (const auto &node : nodes)
+    {
+        if (position < node.cpus.size())
+            return {node.cpus[position]};
+        position -= node.cpus.size();
+    }
+    return {};
+}
+
+std::error_code placeCurrentThread(const std::vector<int> &cpus, bool localMemory, const CpuTopology &topology)
+{
+    if (cpus.empty())
+        return std::error_code();
+
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (const auto cpu : cpus)
+    {
+        if (cpu < 0 || cpu >= CPU_SETSIZE)
+            return std::make_error_code(std::errc::invalid_argument);
+        CPU_SET(cpu, &set);
+    }
+
+    // pthread functions return the error instead of setting errno.
+    const auto result = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (result != 0)
+        return std::error_code(result, std::system_category());
+
+    if (!localMemory || topology.nodes().size() < 2)
+        return std::error_code();
+
+    const auto node = topology.node_of(cpus.front());
+    const bool singleNode = node >= 0 && std::all_of(cpus.begin(), cpus.end(), [&topology, node](int cpu)
+                                                     { return topology.node_of(cpu) == node; });
+    if (!singleNode)
+        return std::error_code();
+
+    // MPOL_PREFERRED rather than MPOL_BIND: a full node falls back to the others instead of failing the allocation.
+    constexpr std::size_t MASK_BITS = 1024;
+    std::array<unsigned long, MASK_BITS / (8 * sizeof(unsigned long))> mask{};
+    if (static_cast<std::size_t>(node) >= MASK_BITS)
+        return std::make_error_code(std::errc::invalid_argument);
+    mask[node / (8 * sizeof(unsigned long))] |= 1UL << (node % (8 * sizeof(unsigned long)));
+
+    // The kernel reads maxnode - 1 bits.
+    if (syscall(SYS_set_mempolicy, MPOL_PREFERRED, mask.data(), MASK_BITS + 1) != 0)
+        return std::error_code(errno, std::system_category());
+    return std::error_code();
+}
@@ -0,0 +1,227 @@
+#include "time_series.hpp"
+
+#include <algorithm>
+#include <limits>
+
+#include "cross_rates.hpp"
+
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace
+{
+    struct KernelResult
+    {
+        double min;
+        double max;
+        double sum;
+    };
+
+    KernelResult aggregateKernel(const double *values, std::size_t count)
+    {
+        KernelResult result{std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), 0.0};
+        std::size_t idx = 0;
+
+#if defined(__AVX__)
+        if (count >= 4)
+        {
+            __m256d minimum = _mm256_loadu_pd(values);
+            __m256d maximum = minimum;
+            __m256d sum = _mm256_setzero_pd();
+            for (; idx + 4 <= count; idx += 4)
+            {
+                const __m256d lanes = _mm256_loadu_pd(values + idx);
+                minimum = _mm256_min_pd(minimum, lanes);
+                maximum = _mm256_max_pd(maximum, lanes);
+                sum = _mm256_add_pd(sum, lanes);
+            }
+            alignas(32) double minimums[4], maximums[4], sums[4];
+            _mm256_store_pd(minimums, minimum);
+            _mm256_store_pd(maximums, maximum);
+            _mm256_store_pd(sums, sum);
+            for (int lane = 0; lane < 4; ++lane)
+            {
+                result.min = std::min(result.min, minimums[lane]);
+                result.max = std::max(result.max, maximums[lane]);
+                result.sum += sums[lane];
+            }
+        }
+#elif defined(__SSE2__)
+        if (count >= 2)
+        {
+            __m128d minimum = _mm_loadu_pd(values);
+            __m128d maximum = minimum;
+            __m128d sum = _mm_setzero_pd();
+            for (; idx + 2 <= count; idx += 2)
+            {
+                const __m128d lanes = _mm_loadu_pd(values + idx);
+                minimum = _mm_min_pd(minimum, lanes);
+                maximum = _mm_max_pd(maximum, lanes);
+                sum = _mm_add_pd(sum, lanes);
+            }
+            alignas(16) double minimums[2], maximums[2], sums[2];
+            _mm_store_pd(minimums, minimum);
+            _mm_store_pd(maximums, maximum);
+            _mm_store_pd(sums, sum);
+            for (int lane = 0; lane < 2; ++lane)
+            {
+                result.min = std::min(result.min, minimums[lane]);
+                result.max = std::max(result.max, maximums[lane]);
+                result.sum += sums[lane];
+            }
+        }
+#endif
+        for (; idx < count; ++idx)
+        {
+            result.min = std::min(result.min, values[idx]);
+            result.max = std::max(result.max, values[idx]);
+            result.sum += values[idx];
+        }
+        return result;
+    }
+}
+
+void RateTimeSeries::append(const day_type &day, const rates_table_type &table)
+{
+    const bool replaceLast = !daysField.empty() && daysField.back() == day;
+
+    if (!daysField.empty() && day < daysField.back())
+    {
+        throw std::invalid_argument("RateTimeSeries::append: day " + formatCbrDate(day) + " precedes " + formatCbrDate(daysField.back()));
+    }
+
+    // Every unit rate first: an invalid currency throws before the axis or any column has changed.
+    std::vector<value_type> units;
+    units.reserve(table.size());
+    for (const auto &[code, valute] : table)
+    {
+        units.push_back(unitRate(valute));
+    }
+
+    if (!replaceLast)
+        daysField.push_back(day);
+
+    const auto axisIndex = daysField.size() - 1;
+
+    auto nextUnit = units.cbegin();
+    for (const auto &[code, valute] : table)
+    {
+        auto &column = columnsField[code];
+        const auto unit = *nextUnit++;
+
+        if (column.values.empty())
+        {
+            column.firstIndex = axisIndex;
+            column.values.push_back(unit);
+        }
+        else if (column.firstIndex + column.values.size() > axisIndex)
+        {
+            column.values.back() = unit;
+            if (column.values.size() % BLOCK_SIZE == 0)
+            {
+                column.blocks.pop_back();
+                seal_block(column);
+            }
+            continue;
+        }
+        else
+        {
+            column.values.resize(axisIndex - column.firstIndex + 1, column.values.back());
+            column.values.back() = unit;
+        }
+
+        while (column.blocks.size() < column.values.size() / BLOCK_SIZE)
+        {
+            seal_block(column);
+        }
+    }
+
+    if (replaceLast)
+        return;
+
+    for (auto &[code, column] : columnsField)
+    {
+        if (column.firstIndex + column.values.size() <= axisIndex)
+        {
+            column.values.resize(axisIndex - column.firstIndex + 1, column.values.back());
+            while (column.blocks.size() < column.values.size() / BLOCK_SIZE)
+            {
+                seal_block(column);
+            }
+        }
+    }
+}
+
+std::optional<RangeAggregate> RateTimeSeries::aggregate(const std::string &code, const day_type &from, const day_type &to) const
+{
+    const auto iter = columnsField.find(code);
+    if (iter == columnsField.end() || from > to)
+        return std::nullopt;
+
+    const auto &column = iter->second;
+
+    const auto axisBegin = static_cast<std::size_t>(std::lower_bound(daysField.cbegin(), daysField.cend(), from) - daysField.cbegin());
+    const auto axisEnd = static_cast<std::size_t>(std::upper_bound(daysField.cbegin(), daysField.cend(), to) - daysField.cbegin());
+
+    const auto begin = std::max(axisBegin, column.firstIndex) - column.firstIndex;
+    const auto end = std::min(axisEnd, column.firstIndex + column.values.size());
+
+    if (end <= column.firstIndex || begin >= end - column.firstIndex)
+        return std::nullopt;
+
+    const auto last = end - column.firstIndex;
+    const auto *values = column.values.data();
+
+    KernelResult total{std::numeric_limits<double>::infinity(), -std::numeric_limits<double>::infinity(), 0.0};
+    auto merge = [&total](const KernelResult &part)
+    {
+        total.min = std::min(total.min, part.min);
+        total.max = std::max(total.max, part.max);
+        total.sum += part.sum;
+    };
+
+    const auto firstBlock = (begin + BLOCK_SIZE - 1) / BLOCK_SIZE;
+    const auto lastBlock = last / BLOCK_SIZE;
+
+    if (firstBlock >= lastBlock)
+    {
+        merge(aggregateKernel(values + begin, last - begin));
+    }
+    else
+    {
+        merge(aggregateKernel(values + begin, firstBlock * BLOCK_SIZE - begin));
+        for (auto block = firstBlock; block < lastBlock; ++block)
+        {
+            const auto &summary = column.blocks[block];
+            merge(KernelResult{summary.min, summary.max, summary.sum});
+        }
+        merge(aggregateKernel(values + lastBlock * BLOCK_SIZE, last - lastBlock * BLOCK_SIZE));
+    }
+
+    RangeAggregate result;
+    result.count = last - begin;
+    result.min = total.min;
+    result.max = total.max;
+    result.mean = total.sum / static_cast<double>(result.count);
+    result.first = values[begin];
+    result.last = values[last - 1];
+    return result;
+}
+
+std::optional<RateTimeSeries::value_type> RateTimeSeries::last(const std::string &code) const noexcept
+{
+    const auto iter = columnsField.find(code);
+    if (iter == columnsField.end() || iter->second.values.empty())
+        return std::nullopt;
+    return iter->second.values.back();
+}
+
+void RateTimeSeries::seal_block(Column &column)
+{
+    const auto block = column.blocks.size();
+    const auto summary = aggregateKernel(column.values.data() + block * BLOCK_SIZE, BLOCK_SIZE);
+    column.blocks.push_back(BlockSummary{summary.min, summary.max, summary.sum});
+}
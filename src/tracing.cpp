@@ -0,0 +1,168 @@
+#include "tracing.hpp"
+
+#include <fstream>
+#include <thread>
+#include <cinttypes>
+#include <cstdio>
+#include <unistd.h>
+
+namespace
+{
+    std::atomic<uint64_t> nextTracerId{1};
+
+    void writeString(std::ostream &stream, const char *text)
+    {
+        stream << '"';
+        for (; *text != '\0'; ++text)
+        {
+            if (*text == '"' || *text == '\\')
+                stream << '\\';
+            stream << *text;
+        }
+        stream << '"';
+    }
+
+    // Chrome expects microseconds; three decimals keep the nanoseconds.
+    void writeMicroseconds(std::ostream &stream, int64_t nanoseconds)
+    {
+        char buffer[32];
+        std::snprintf(buffer, sizeof(buffer), "%" PRId64 ".%03" PRId64, nanoseconds / 1000, nanoseconds % 1000);
+        stream << buffer;
+    }
+
+    void writeId(std::ostream &stream, uint64_t id)
+    {
+        char buffer[24];
+        std::snprintf(buffer, sizeof(buffer), "\"0x%" PRIx64 "\"", id);
+        stream << buffer;
+    }
+}
+
+TraceBuffer::TraceBuffer(int threadId_) : threadId(threadId_)
+{
+}
+
+TraceBuffer::~TraceBuffer()
+{
+    for (auto &chunk : chunks)
+    {
+        delete[] chunk.load(std::memory_order_relaxed);
+    }
+}
+
+TraceEvent *TraceBuffer::add_chunk(std::size_t index) noexcept
+{
+    if (index >= MAX_CHUNKS)
+        return nullptr;
+
+    auto *chunk = new (std::nothrow) TraceEvent[CHUNK_SIZE];
+    // Published together with the first event through sizeField.
+    chunks[index].store(chunk, std::memory_order_relaxed);
+    return chunk;
+}
+
+Tracer::Tracer() : tracerId(nextTracerId.fetch_add(1, std::memory_order_relaxed)), epoch(now()), epochTime(clock_type::now())
+{
+}
+
+Tracer &Tracer::global()
+{
+    static Tracer tracer;
+    return tracer;
+}
+
+TraceBuffer *Tracer::register_thread() noexcept
+{
+    try
+    {
+        auto buffer = std::make_shared<TraceBuffer>(static_cast<int>(::gettid()));
+        {
+            std::lock_guard lock(buffersMutex);
+            buffersField.push_back(buffer);
+        }
+        bufferCache = BufferCache{tracerId, buffer.get()};
+        return buffer.get();
+    }
+    catch (...)
+    {
+        return nullptr;
+    }
+}
+
+void Tracer::write_json(std::ostream &stream) const
+{
+    std::vector<std::shared_ptr<TraceBuffer>> buffers;
+    {
+        std::lock_guard lock(buffersMutex);
+        buffers = buffersField;
+    }
+
+    const auto elapsed = clock_type::now() - epochTime;
+    if (elapsed < CALIBRATION_TIME)
+        std::this_thread::sleep_for(CALIBRATION_TIME - elapsed);
+    const auto calibrationTicks = now() - epoch;
+    const auto calibrationTime = std::chrono::duration<double, std::nano>(clock_type::now() - epochTime).count();
+    const double nanosecondsPerTick = calibrationTicks > 0 ? calibrationTime / calibrationTicks : 1.0;
+    const auto toNanoseconds = [nanosecondsPerTick](int64_t ticks)
+    {
+        return static_cast<int64_t>(ticks * nanosecondsPerTick);
+    };
+
+    const auto processId = static_cast<int>(::getpid());
+    bool first = true;
+
+    stream << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    for (const auto &buffer : buffers)
+    {
+        const auto size = buffer->size();
+        for (std::size_t idx = 0; idx < size; ++idx)
+        {
+            const auto &event = buffer->at(idx);
+
+            stream << (first ? "\n" : ",\n") << "{\"name\":";
+            first = false;
+            writeString(stream, event.name);
+            stream << ",\"cat\":";
+            writeString(stream, event.category);
+            stream << ",\"ph\":\"" << event.phase << "\",\"ts\":";
+            writeMicroseconds(stream, toNanoseconds(event.timestamp - epoch));
+            stream << ",\"pid\":" << processId << ",\"tid\":" << buffer->thread_id();
+
+            if (event.phase == 'X')
+            {
+                stream << ",\"dur\":";
+                writeMicroseconds(stream, toNanoseconds(event.duration));
+                if (event.id != 0)
+                {
+                    stream << ",\"args\":{\"id\":";
+                    writeId(stream, event.id);
+                    stream << '}';
+                }
+            }
+            else
+            {
+                stream << ",\"id\":";
+                writeId(stream, event.id);
+            }
+            stream << '}';
+        }
+    }
+    stream << "\n],\"otherData\":{\"dropped\":" << dropped() << "}}\n";
+}
+
+bool Tracer::write_json(const std::string &path) const
+{
+    std::ofstream stream(path);
+    write_json(stream);
+    return static_cast<bool>(stream);
+}
+
+void Tracer::clear()
+{
+    std::lock_guard lock(buffersMutex);
+    for (const auto &buffer : buffersField)
+    {
+        buffer->reset();
+    }
+    droppedField.store(0, std::memory_order_relaxed);
+}
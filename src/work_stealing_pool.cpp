@@ -0,0 +1,144 @@
+#include "work_stealing_pool.hpp"
+
+#include <algorithm>
+
+namespace
+{
+    struct CurrentWorker
+    {
+        const void *pool = nullptr;
+        std::size_t index = 0;
+    };
+
+    CurrentWorker &currentWorker() noexcept
+    {
+        thread_local CurrentWorker worker;
+        return worker;
+    }
+}
+
+WorkStealingPool::WorkStealingPool(std::size_t threads)
+{
+    start(threads, ThreadPlacement());
+}
+
+WorkStealingPool::WorkStealingPool(std::size_t threads, const ThreadPlacement &placement)
+{
+    start(threads, placement);
+}
+
+void WorkStealingPool::start(std::size_t threads, const ThreadPlacement &placement)
+{
+    threads = std::max<std::size_t>(threads, 1);
+    for (std::size_t idx = 0; idx < threads; ++idx)
+    {
+        workers.push_back(std::make_unique<Worker>());
+    }
+    for (std::size_t idx = 0; idx < threads; ++idx)
+    {
+        workers[idx]->thread = std::thread([this, idx, cpus = placement.cpus_for(idx), localMemory = placement.localMemory]
+                                           { work(idx, cpus, localMemory); });
+    }
+}
+
+WorkStealingPool::~WorkStealingPool()
+{
+    {
+        std::lock_guard lock(sleepMutex);
+        stopping.store(true, std::memory_order_seq_cst);
+    }
+    sleepCondition.notify_all();
+
+    for (auto &worker : workers)
+    {
+        worker->thread.join();
+    }
+}
+
+WorkStealingPool &WorkStealingPool::shared()
+{
+    static WorkStealingPool pool;
+    return pool;
+}
+
+void WorkStealingPool::submit(task_type task)
+{
+    auto job = new Job{std::move(task)};
+
+    const auto &worker = currentWorker();
+    if (worker.pool == this)
+    {
+        workers[worker.index]->deque.push(job);
+    }
+    else
+    {
+        std::lock_guard lock(injectionMutex);
+        injectionQueue.push_back(job);
+    }
+
+    queuedJobs.fetch_add(1, std::memory_order_seq_cst);
+    wake_worker();
+}
+
+void WorkStealingPool::wake_worker()
+{
+    if (sleepingWorkers.load(std::memory_order_seq_cst) == 0)
+        return;
+
+    std::lock_guard lock(sleepMutex);
+    sleepCondition.notify_one();
+}
+
+WorkStealingPool::Job *WorkStealingPool::find_job(std::size_t index)
+{
+    if (auto job = workers[index]->deque.take())
+        return job;
+
+    {
+        std::lock_guard lock(injectionMutex);
+        if (!injectionQueue.empty())
+        {
+            auto job = injectionQueue.front();
+            injectionQueue.pop_front();
+            return job;
+        }
+    }
+
+    for (std::size_t offset = 1; offset < workers.size(); ++offset)
+    {
+        if (auto job = workers[(index + offset) % workers.size()]->deque.steal())
+        {
+            stealsField.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+void WorkStealingPool::work(std::size_t index, const std::vector<int> &cpus, bool localMemory)
+{
+    currentWorker() = CurrentWorker{this, index};
+    // Best effort: a worker that cannot be pinned still runs jobs.
+    placeCurrentThread(cpus, localMemory);
+
+    while (true)
+    {
+        if (auto job = find_job(index))
+        {
+            queuedJobs.fetch_sub(1, std::memory_order_seq_cst);
+            std::unique_ptr<Job> owned(job);
+            owned->task();
+            continue;
+        }
+
+        std::unique_lock lock(sleepMutex);
+        sleepingWorkers.fetch_add(1, std::memory_order_seq_cst);
+        // queuedJobs is incremented before the sleeper count is read in submit(), so a job is never left unnoticed.
+        sleepCondition.wait(lock, [this]
+                            { return stopping.load(std::memory_order_seq_cst) || queuedJobs.load(std::memory_order_seq_cst) > 0; });
+        sleepingWorkers.fetch_sub(1, std::memory_order_seq_cst);
+
+        if (stopping.load(std::memory_order_seq_cst) && queuedJobs.load(std::memory_order_seq_cst) == 0)
+            return;
+    }
+}
@@ -1,5 +1,835 @@
 #define BOOST_TEST_MODULE AsyncConnectIntegrationTests
 #include <boost/test/included/unit_test.hpp>
 
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <unistd.h>
+#include <string>
+#include <array>
+#include <vector>
+#include <thread>
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+#include <sstream>
+#include <zlib.h>
 
+#include "async_operations.hpp"
+#include "cbr_client.hpp"
+#include "rate_server.hpp"
+#include "refresh_scheduler.hpp"
+#include "coroutine.hpp"
+#include "rates_parser.hpp"
 
+static int openLoopbackListener(int &port)
+{
+    int listener = socket(AF_INET, SOCK_STREAM, 0);
+    int enable = 1;
+    setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &enable, sizeof(enable));
+
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    address.sin_port = 0;
+
+    if (bind(listener, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0 || listen(listener, 16) != 0)
+    {
+        throw std::runtime_error("Failed to open loopback listener");
+    }
+
+    socklen_t length = sizeof(address);
+    getsockname(listener, reinterpret_cast<struct sockaddr *>(&address), &length);
+    port = ntohs(address.sin_port);
+    return listener;
+}
+
+// Blocking loopback HTTP server: one request per connection, the reply is produced by the responder.
+class StubHttpServer
+{
+public:
+    using responder_type = std::function<std::string(const std::string &request)>;
+
+    explicit StubHttpServer(responder_type responder_) : responder(std::move(responder_))
+    {
+        listener = openLoopbackListener(portField);
+        serverThread = std::thread([this]
+                                   { serve(); });
+    }
+
+    ~StubHttpServer()
+    {
+        shutdown(listener, SHUT_RDWR);
+        serverThread.join();
+        close(listener);
+    }
+
+    [[nodiscard]] int port() const noexcept
+    {
+        return portField;
+    }
+
+    [[nodiscard]] int connections() const noexcept
+    {
+        return connectionsCount.load();
+    }
+
+    [[nodiscard]] std::vector<std::string> requests()
+    {
+        std::lock_guard lock(requestsMutex);
+        return requestsField;
+    }
+
+private:
+    responder_type responder;
+    int listener = -1;
+    int portField = 0;
+    std::thread serverThread;
+    std::atomic<int> connectionsCount{0};
+    std::mutex requestsMutex;
+    std::vector<std::string> requestsField;
+
+    void serve()
+    {
+        while (true)
+        {
+            const int client = accept(listener, nullptr, nullptr);
+            if (client < 0)
+                return;
+            ++connectionsCount;
+
+            std::string request;
+            std::array<char, 4096> buffer;
+            while (request.find("\r\n\r\n") == std::string::npos)
+            {
+                const auto count = read(client, buffer.data(), buffer.size());
+                if (count <= 0)
+                    break;
+                request.append(buffer.data(), count);
+            }
+
+            {
+                std::lock_guard lock(requestsMutex);
+                requestsField.push_back(request);
+            }
+
+            const auto reply = responder(request);
+            std::size_t offset = 0;
+            while (offset < reply.size())
+            {
+                const auto count = write(client, reply.data() + offset, reply.size() - offset);
+                if (count <= 0)
+                    break;
+                offset += count;
+            }
+            close(client);
+        }
+    }
+};
+
+static const std::string DAILY_FIXTURE =
+    "<?xml version=\"1.0\" encoding=\"windows-1251\"?>"
+    "<ValCurs Date=\"10.01.2020\" name=\"Foreign Currency Market\">"
+    "<Valute ID=\"R01235\"><NumCode>840</NumCode><CharCode>USD</CharCode><Nominal>1</Nominal><Name>USD</Name><Value>61,9057</Value><VunitRate>61,9057</VunitRate></Valute>"
+    "<Valute ID=\"R01239\"><NumCode>978</NumCode><CharCode>EUR</CharCode><Nominal>1</Nominal><Name>EUR</Name><Value>68,6347</Value><VunitRate>68,6347</VunitRate></Valute>"
+    "<Valute ID=\"R01375\"><NumCode>156</NumCode><CharCode>CNY</CharCode><Nominal>10</Nominal><Name>CNY</Name><Value>89,3741</Value><VunitRate>8,93741</VunitRate></Valute>"
+    "</ValCurs>";
+
+static std::string okResponse(const std::string &body, const std::string &extraHeaders)
+{
+    return "HTTP/1.1 200 OK\r\nContent-Type: application/xml; charset=windows-1251\r\n" + extraHeaders +
+           "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" + body;
+}
+
+static rates_pointer fetchDaily(CbrClient &client, IOContext &context, const day_type &day, std::error_code &error)
+{
+    rates_pointer result;
+    client.get_daily_rates(day, [&](const std::error_code &errorCode, rates_pointer rates)
+                           {
+        error = errorCode;
+        result = std::move(rates); });
+    context.run();
+    return result;
+}
+
+BOOST_AUTO_TEST_CASE(test_socket_round_trip_over_loopback)
+{
+    int port = 0;
+    const int listener = openLoopbackListener(port);
+
+    std::thread server([listener]
+                       {
+        const int client = accept(listener, nullptr, nullptr);
+        std::array<char, 64> request{};
+        const auto count = read(client, request.data(), request.size());
+        std::string reply = "echo:" + std::string(request.data(), count > 0 ? count : 0);
+        write(client, reply.data(), reply.size());
+        close(client); });
+
+    IOContext context;
+    TCPAsyncSocket socket(context);
+    EndpointIPv4 endpoint("127.0.0.1", port);
+
+    std::vector<char> writeBuffer{'p', 'i', 'n', 'g'};
+    std::vector<char> readBuffer(64);
+    std::error_code lastError;
+    std::string received;
+
+    socket.async_connect(endpoint, [&](const std::error_code &error)
+                         {
+        lastError = error;
+        if (error)
+            return;
+        socket.async_write(writeBuffer, [&](const std::error_code &error, size_t)
+                           {
+            lastError = error;
+            if (error)
+                return;
+            socket.async_read(readBuffer, [&](const std::error_code &error, size_t bytesRead)
+                              {
+                lastError = error;
+                received.assign(readBuffer.data(), bytesRead); }); }); });
+
+    context.run();
+    server.join();
+    close(listener);
+
+    BOOST_CHECK(!lastError);
+    BOOST_CHECK_EQUAL(received, "echo:ping");
+}
+
+BOOST_AUTO_TEST_CASE(test_cbr_client_serves_past_dates_from_cache)
+{
+    StubHttpServer server([](const std::string &)
+                          { return okResponse(DAILY_FIXTURE, "ETag: \"d-2020-01-10\"\r\n"); });
+
+    IOContext context;
+    CbrClient client(context, "127.0.0.1", server.port());
+    const auto day = dayFromCivil(2020, 1, 10);
+
+    std::error_code error;
+    const auto first = fetchDaily(client, context, day, error);
+    BOOST_REQUIRE(!error);
+    BOOST_REQUIRE(first);
+    BOOST_CHECK_EQUAL(first->size(), 3u);
+    BOOST_CHECK_CLOSE(first->at("USD").Value, 61.9057f, 1e-4);
+    BOOST_CHECK_EQUAL(first->at("CNY").Nominal, 10);
+
+    const auto second = fetchDaily(client, context, day, error);
+    BOOST_REQUIRE(!error);
+    BOOST_CHECK(second == first);
+    BOOST_CHECK_EQUAL(server.connections(), 1);
+
+    const auto statistics = client.cache_statistics();
+    BOOST_CHECK_EQUAL(statistics.misses, 1u);
+    BOOST_CHECK_EQUAL(statistics.hits, 1u);
+    BOOST_CHECK_EQUAL(statistics.bytesSaved, DAILY_FIXTURE.size());
+    BOOST_CHECK_CLOSE(statistics.hit_ratio(), 50.0 / 100.0, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_cbr_client_counts_failed_downloads_as_misses)
+{
+    StubHttpServer server([](const std::string &)
+                          { return std::string("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n"); });
+
+    IOContext context;
+    CbrClient client(context, "127.0.0.1", server.port());
+
+    std::error_code error;
+    const auto rates = fetchDaily(client, context, dayFromCivil(2020, 1, 10), error);
+    BOOST_CHECK(error);
+    BOOST_CHECK(!rates);
+
+    // Used to be counted only once a response had been parsed and stored.
+    const auto statistics = client.cache_statistics();
+    BOOST_CHECK_EQUAL(statistics.misses, 1u);
+    BOOST_CHECK_EQUAL(statistics.hit_ratio(), 0.0);
+}
+
+BOOST_AUTO_TEST_CASE(test_cbr_client_revalidates_current_dates)
+{
+    StubHttpServer server([](const std::string &request)
+                          {
+        if (request.find("If-None-Match: \"v1\"\r\n") != std::string::npos)
+            return std::string("HTTP/1.1 304 Not Modified\r\nETag: \"v1\"\r\n\r\n");
+        return okResponse(DAILY_FIXTURE, "ETag: \"v1\"\r\nLast-Modified: Fri, 10 Jan 2020 12:00:00 GMT\r\n"); });
+
+    IOContext context;
+    CbrClient client(context, "127.0.0.1", server.port());
+    const auto day = currentCbrDay() + 30;
+
+    std::error_code error;
+    const auto first = fetchDaily(client, context, day, error);
+    BOOST_REQUIRE(!error);
+
+    const auto second = fetchDaily(client, context, day, error);
+    BOOST_REQUIRE(!error);
+    BOOST_CHECK(second == first);
+    BOOST_CHECK_EQUAL(server.connections(), 2);
+
+    const auto requests = server.requests();
+    BOOST_REQUIRE_EQUAL(requests.size(), 2u);
+    BOOST_CHECK(requests[0].find("If-None-Match") == std::string::npos);
+    BOOST_CHECK(requests[1].find("If-Modified-Since: Fri, 10 Jan 2020 12:00:00 GMT\r\n") != std::string::npos);
+
+    const auto statistics = client.cache_statistics();
+    BOOST_CHECK_EQUAL(statistics.misses, 1u);
+    BOOST_CHECK_EQUAL(statistics.notModified, 1u);
+    BOOST_CHECK_EQUAL(statistics.bytesSaved, DAILY_FIXTURE.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_cbr_client_coalesces_concurrent_requests)
+{
+    StubHttpServer server([](const std::string &)
+                          { return okResponse(DAILY_FIXTURE, ""); });
+
+    IOContext context;
+    CbrClient client(context, "127.0.0.1", server.port());
+    const auto day = currentCbrDay();
+
+    constexpr int CALLERS = 10;
+    std::vector<rates_pointer> results;
+    for (int idx = 0; idx < CALLERS; ++idx)
+    {
+        client.get_daily_rates(day, [&](const std::error_code &error, rates_pointer rates)
+                               {
+            BOOST_CHECK(!error);
+            results.push_back(std::move(rates)); });
+    }
+    context.run();
+
+    BOOST_REQUIRE_EQUAL(results.size(), static_cast<std::size_t>(CALLERS));
+    BOOST_REQUIRE(results.front());
+    for (const auto &rates : results)
+    {
+        BOOST_CHECK(rates == results.front());
+    }
+    BOOST_CHECK_EQUAL(server.connections(), 1);
+    BOOST_CHECK_EQUAL(client.coalesced_requests(), static_cast<uint64_t>(CALLERS - 1));
+
+    std::error_code error;
+    const auto refreshed = fetchDaily(client, context, day, error);
+    BOOST_CHECK(!error);
+    BOOST_CHECK(refreshed);
+    BOOST_CHECK_EQUAL(server.connections(), 2);
+}
+
+BOOST_AUTO_TEST_CASE(test_refresh_scheduler_swaps_tables_in_background)
+{
+    std::atomic<int> responses{0};
+    StubHttpServer server([&](const std::string &)
+                          {
+        if (responses++ == 0)
+            return std::string("HTTP/1.1 503 Service Unavailable\r\nContent-Length: 0\r\n\r\n");
+        return okResponse(DAILY_FIXTURE, ""); });
+
+    IOContext context;
+    CbrClient client(context, "127.0.0.1", server.port());
+
+    RefreshPolicy policy;
+    policy.interval = std::chrono::milliseconds(20);
+    policy.retryInterval = std::chrono::milliseconds(5);
+    policy.publicationWindow = std::chrono::milliseconds(0);
+    RefreshScheduler scheduler(context, client, policy);
+    const auto today = scheduler.add_daily();
+
+    std::vector<rates_pointer> published;
+    scheduler.set_update_handler([&](RefreshScheduler::query_type query, const day_type &day, rates_pointer rates)
+                                 {
+        BOOST_CHECK_EQUAL(query, today);
+        BOOST_CHECK_EQUAL(day, currentCbrDay());
+        published.push_back(rates);
+        BOOST_CHECK(scheduler.rates(today) == rates);
+        if (published.size() == 3)
+            scheduler.stop(); });
+
+    BOOST_CHECK(!scheduler.rates(today));
+    scheduler.start();
+    context.run();
+
+    BOOST_REQUIRE_EQUAL(published.size(), 3u);
+    BOOST_CHECK(published[0] != published[1]);
+    BOOST_CHECK_EQUAL(scheduler.failures(), 1u);
+    BOOST_CHECK_EQUAL(scheduler.refreshes(), 3u);
+    BOOST_CHECK(scheduler.rates(today) == published.back());
+    BOOST_CHECK_CLOSE(scheduler.rates(today)->at("EUR").Value, 68.6347f, 1e-4);
+}
+
+BOOST_AUTO_TEST_CASE(test_completion_tokens_future_and_sync)
+{
+    StubHttpServer server([](const std::string &)
+                          { return okResponse(DAILY_FIXTURE, ""); });
+
+    IOContext context;
+    CbrClient client(context, "127.0.0.1", server.port());
+
+    auto future = client.get_daily_rates(dayFromCivil(2020, 1, 10), use_future);
+    context.run();
+    const auto fromFuture = future.get();
+    BOOST_REQUIRE(fromFuture);
+    BOOST_CHECK_EQUAL(fromFuture->size(), 3u);
+
+    context.inc_work();
+    std::thread reactor([&]
+                        { context.run(); });
+
+    const auto fromSync = client.get_daily_rates(dayFromCivil(2020, 1, 11), use_sync);
+    BOOST_REQUIRE(fromSync);
+    BOOST_CHECK_CLOSE(fromSync->at("USD").Value, 61.9057f, 1e-4);
+
+    int closedPort = 0;
+    close(openLoopbackListener(closedPort));
+    TCPAsyncSocket socket(context);
+    EndpointIPv4 closed("127.0.0.1", closedPort);
+    BOOST_CHECK_THROW(socket.async_connect(closed, use_sync), std::system_error);
+
+    std::atomic<bool> rejected{false};
+    context.post([&]
+                 {
+        try
+        {
+            static_cast<void>(client.get_daily_rates(dayFromCivil(2020, 1, 10), use_sync));
+        }
+        catch (const std::logic_error &)
+        {
+            rejected = true;
+        } });
+
+    context.dec_work();
+    reactor.join();
+    BOOST_CHECK(rejected.load());
+}
+
+static std::string gzipText(const std::string &text)
+{
+    z_stream stream{};
+    deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+    std::string output(deflateBound(&stream, text.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+    stream.avail_in = static_cast<uInt>(text.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+
+BOOST_AUTO_TEST_CASE(test_cbr_client_accepts_gzip_responses)
+{
+    const auto compressed = gzipText(DAILY_FIXTURE);
+
+    StubHttpServer server([&compressed](const std::string &request)
+                          {
+        if (request.find("Accept-Encoding: gzip, deflate\r\n") == std::string::npos)
+            return okResponse(DAILY_FIXTURE, "");
+
+        std::stringstream chunkSize;
+        chunkSize << std::hex << compressed.size();
+        return "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n" + chunkSize.str() + "\r\n" +
+               compressed + "\r\n0\r\n\r\n"; });
+
+    IOContext context;
+    CbrClient client(context, "127.0.0.1", server.port());
+
+    std::error_code error;
+    const auto rates = fetchDaily(client, context, dayFromCivil(2020, 1, 10), error);
+    BOOST_REQUIRE(!error);
+    BOOST_REQUIRE(rates);
+    BOOST_CHECK_EQUAL(rates->size(), 3u);
+    BOOST_CHECK_CLOSE(rates->at("EUR").Value, 68.6347f, 1e-4);
+
+    const auto statistics = client.cache_statistics();
+    BOOST_CHECK_EQUAL(statistics.misses, 1u);
+    BOOST_CHECK_EQUAL(client.cache().find(CbrClient::daily_target(dayFromCivil(2020, 1, 10)))->bodySize, compressed.size());
+}
+
+BOOST_AUTO_TEST_CASE(test_cbr_client_dynamic_range_in_one_request)
+{
+    std::string document = "<?xml version=\"1.0\" encoding=\"windows-1251\"?><ValCurs ID=\"R01235\" DateRange1=\"01.01.2015\" DateRange2=\"31.12.2024\" name=\"Foreign Currency Market Dynamic\">";
+    const auto from = dayFromCivil(2015, 1, 1);
+    const auto to = dayFromCivil(2024, 12, 31);
+    std::size_t expected = 0;
+    for (auto day = from; day <= to; ++day)
+    {
+        if ((day + 3) % 7 >= 5)
+            continue;
+        auto date = formatCbrDate(day);
+        std::replace(date.begin(), date.end(), '/', '.');
+        document += "<Record Date=\"" + date + "\" Id=\"R01235\"><Nominal>1</Nominal><Value>" +
+                    std::to_string(50 + expected % 40) + ",5000</Value></Record>";
+        ++expected;
+    }
+    document += "</ValCurs>";
+
+    const auto compressed = gzipText(document);
+    StubHttpServer server([&compressed](const std::string &)
+                          { return "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: " + std::to_string(compressed.size()) + "\r\n\r\n" + compressed; });
+
+    IOContext context;
+    CbrClient client(context, "127.0.0.1", server.port());
+
+    std::error_code lastError;
+    history_pointer history;
+    for (int attempt = 0; attempt < 2; ++attempt)
+    {
+        client.get_dynamic_rates("R01235", from, to, [&](const std::error_code &error, history_pointer result)
+                                 {
+            lastError = error;
+            history = std::move(result); });
+        context.run();
+    }
+
+    BOOST_REQUIRE(!lastError);
+    BOOST_REQUIRE(history);
+    BOOST_CHECK_EQUAL(history->size(), expected);
+    BOOST_CHECK_EQUAL(history->front().day, dayFromCivil(2015, 1, 1));
+    BOOST_CHECK_CLOSE(history->back().valute.Value, 50.5f + (expected - 1) % 40, 1e-4);
+    BOOST_CHECK_EQUAL(server.connections(), 1);
+
+    const auto requests = server.requests();
+    BOOST_REQUIRE_EQUAL(requests.size(), 1u);
+    BOOST_CHECK(requests[0].find("GET /scripts/XML_dynamic.asp?date_req1=01/01/2015&date_req2=31/12/2024&VAL_NM_RQ=R01235 HTTP/1.1\r\n") == 0);
+}
+
+BOOST_AUTO_TEST_CASE(test_acceptor_drains_connection_bursts)
+{
+    IOContext context;
+    EndpointIPv4 endpoint("127.0.0.1", 0);
+    TCPAsyncAcceptor acceptor(context, endpoint);
+    const int port = acceptor.local_port();
+    BOOST_REQUIRE_GT(port, 0);
+
+    constexpr int CLIENTS = 200;
+    std::thread clients([port]
+                        {
+        std::vector<int> descriptors;
+        for (int idx = 0; idx < CLIENTS; ++idx)
+        {
+            const int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+            struct sockaddr_in address;
+            memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_port = htons(port);
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            connect(descriptor, reinterpret_cast<struct sockaddr *>(&address), sizeof(address));
+            write(descriptor, "x", 1);
+            descriptors.push_back(descriptor);
+        }
+        for (const auto &descriptor : descriptors)
+            close(descriptor); });
+
+    int accepted = 0;
+    std::error_code lastError;
+    std::function<void(const std::error_code &, TCPAsyncAcceptor::socket_pointer)> onAccept;
+    onAccept = [&](const std::error_code &error, TCPAsyncAcceptor::socket_pointer socket)
+    {
+        if (error)
+        {
+            lastError = error;
+            return;
+        }
+
+        BOOST_CHECK(socket->is_open());
+        BOOST_CHECK(fcntl(socket->get_socket(), F_GETFL) & O_NONBLOCK);
+        BOOST_CHECK(fcntl(socket->get_socket(), F_GETFD) & FD_CLOEXEC);
+
+        if (++accepted < CLIENTS)
+            acceptor.async_accept(onAccept);
+    };
+
+    acceptor.async_accept(onAccept);
+    context.run();
+    clients.join();
+
+    BOOST_CHECK(!lastError);
+    BOOST_CHECK_EQUAL(accepted, CLIENTS);
+}
+
+BOOST_AUTO_TEST_CASE(test_acceptor_close_cancels_pending_accept)
+{
+    IOContext context;
+    EndpointIPv4 endpoint("127.0.0.1", 0);
+    TCPAsyncAcceptor acceptor(context, endpoint);
+
+    std::error_code lastError;
+    acceptor.async_accept([&](const std::error_code &error, TCPAsyncAcceptor::socket_pointer socket)
+                          {
+        lastError = error;
+        BOOST_CHECK(!socket); });
+
+    context.post([&]
+                 { acceptor.close(); });
+    context.run();
+
+    BOOST_CHECK(lastError == std::errc::operation_canceled);
+    BOOST_CHECK(!acceptor.is_open());
+}
+
+BOOST_AUTO_TEST_CASE(test_acceptors_share_port_with_reuse_port)
+{
+    IOContext first;
+    IOContext second;
+    EndpointIPv4 endpoint("127.0.0.1", 0);
+    TCPAsyncAcceptor firstAcceptor(first, endpoint, true);
+
+    EndpointIPv4 samePort("127.0.0.1", firstAcceptor.local_port());
+    TCPAsyncAcceptor secondAcceptor(second, samePort, true);
+    BOOST_CHECK_EQUAL(secondAcceptor.local_port(), firstAcceptor.local_port());
+
+    EndpointIPv4 withoutReuse("127.0.0.1", firstAcceptor.local_port());
+    BOOST_CHECK_THROW(TCPAsyncAcceptor(first, withoutReuse, false), std::system_error);
+}
+
+static int connectLoopback(int port)
+{
+    const int descriptor = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in address;
+    memset(&address, 0, sizeof(address));
+    address.sin_family = AF_INET;
+    address.sin_port = htons(port);
+    address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (connect(descriptor, reinterpret_cast<struct sockaddr *>(&address), sizeof(address)) != 0)
+    {
+        close(descriptor);
+        return -1;
+    }
+    return descriptor;
+}
+
+static std::string readUntilClosed(int descriptor)
+{
+    std::string received;
+    std::array<char, 4096> buffer;
+    ssize_t count = 0;
+    while ((count = read(descriptor, buffer.data(), buffer.size())) > 0)
+    {
+        received.append(buffer.data(), count);
+    }
+    return received;
+}
+
+// Used to run the readiness completion on an acceptor that another thread had destroyed after the event was taken.
+BOOST_AUTO_TEST_CASE(test_acceptor_destroyed_while_a_connection_arrives)
+{
+    for (int round = 0; round < 100; ++round)
+    {
+        IOContext context;
+        EndpointIPv4 endpoint("127.0.0.1", 0);
+        auto acceptor = std::make_unique<TCPAsyncAcceptor>(context, endpoint);
+        const int port = acceptor->local_port();
+
+        std::atomic<int> completions{0};
+        acceptor->async_accept([&completions](const std::error_code &error, TCPAsyncAcceptor::socket_pointer socket)
+                               {
+            BOOST_CHECK(error ? !socket : static_cast<bool>(socket));
+            completions.fetch_add(1); });
+
+        std::thread runner([&context]
+                           { context.run(); });
+        const int client = connectLoopback(port);
+        acceptor.reset();
+        runner.join();
+        close(client);
+
+        BOOST_REQUIRE_EQUAL(completions.load(), 1);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_rate_server_answers_pipelined_requests)
+{
+    IOContext context;
+    EndpointIPv4 endpoint("127.0.0.1", 0);
+    RateServer server(context, endpoint);
+    server.update(parseDailyRates(DAILY_FIXTURE), *parseCbrDate("10.01.2020"));
+    server.start();
+    const int port = server.local_port();
+
+    std::string pipelined;
+    std::string notFound;
+    std::thread client([&]
+                       {
+        const int first = connectLoopback(port);
+        const std::string requests = "GET /rates/USD HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                                     "GET /cross/EUR/USD HTTP/1.1\r\nHost: localhost\r\n\r\n"
+                                     "GET /rates HTTP/1.1\r\nHost: localhost\r\nConnection: close\r\n\r\n";
+        write(first, requests.data(), requests.size());
+        pipelined = readUntilClosed(first);
+        close(first);
+
+        const int second = connectLoopback(port);
+        const std::string missing = "GET /cross/USD/XXX HTTP/1.0\r\n\r\n";
+        write(second, missing.data(), missing.size());
+        notFound = readUntilClosed(second);
+        close(second);
+
+        context.post([&]
+                     { server.stop(); }); });
+
+    context.run();
+    client.join();
+
+    const auto usd = pipelined.find("\"code\":\"USD\"");
+    const auto cross = pipelined.find("\"from\":\"EUR\",\"to\":\"USD\",\"rate\":1.108");
+    const auto all = pipelined.find("\"base\":\"RUB\"");
+    BOOST_CHECK(usd != std::string::npos);
+    BOOST_CHECK(cross != std::string::npos);
+    BOOST_CHECK(all != std::string::npos);
+    BOOST_CHECK(usd < cross && cross < all);
+    BOOST_CHECK(notFound.rfind("HTTP/1.1 404", 0) == 0);
+    BOOST_CHECK_EQUAL(server.requests_served(), 4u);
+    BOOST_CHECK_EQUAL(server.connections_count(), 0u);
+    BOOST_CHECK(server.snapshot()->find("/cross/CNY/RUB")->find("\"rate\":8.9374") != std::string::npos);
+}
+
+BOOST_AUTO_TEST_CASE(test_rate_server_rejects_bad_content_length)
+{
+    IOContext context;
+    EndpointIPv4 endpoint("127.0.0.1", 0);
+    RateServer server(context, endpoint);
+    server.update(parseDailyRates(DAILY_FIXTURE), *parseCbrDate("10.01.2020"));
+    server.start();
+    const int port = server.local_port();
+
+    std::vector<std::string> replies;
+    std::thread client([&]
+                       {
+        // Used to wrap the offset arithmetic and loop forever.
+        for (const std::string length : {"18446744073709551615", "99999999999999999999999", "12abc", "-1", "1000000"})
+        {
+            const int descriptor = connectLoopback(port);
+            const std::string request = "GET /rates HTTP/1.1\r\nHost: localhost\r\nContent-Length: " + length + "\r\n\r\nGET /rates HTTP/1.1\r\n\r\n";
+            write(descriptor, request.data(), request.size());
+            replies.push_back(readUntilClosed(descriptor));
+            close(descriptor);
+        }
+
+        context.post([&]
+                     { server.stop(); }); });
+
+    context.run();
+    client.join();
+
+    BOOST_REQUIRE_EQUAL(replies.size(), 5u);
+    for (const auto &reply : replies)
+    {
+        BOOST_CHECK(reply.rfind("HTTP/1.1 400", 0) == 0);
+        BOOST_CHECK_EQUAL(reply.find("HTTP/1.1", 1), std::string::npos);
+    }
+    BOOST_CHECK_EQUAL(server.requests_served(), 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_rate_server_destroyed_with_open_connection)
+{
+    IOContext context;
+    EndpointIPv4 endpoint("127.0.0.1", 0);
+    auto server = std::make_unique<RateServer>(context, endpoint);
+    server->start();
+    const int port = server->local_port();
+
+    std::string received;
+    std::thread client([&]
+                       {
+        const int descriptor = connectLoopback(port);
+        const std::string partial = "GET /rates HTTP/1.1\r\n";
+        write(descriptor, partial.data(), partial.size());
+        while (server->connections_count() == 0)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        // The connection's read is still pending in the context when the server goes away.
+        context.post([&]
+                     { server.reset(); });
+        received = readUntilClosed(descriptor);
+        close(descriptor); });
+
+    context.run();
+    client.join();
+
+    BOOST_CHECK(server == nullptr);
+    BOOST_CHECK(received.empty());
+}
+
+// Used to run the accept handler on a server that another thread had destroyed after the connection was taken.
+BOOST_AUTO_TEST_CASE(test_rate_server_destroyed_while_accepting)
+{
+    for (int round = 0; round < 100; ++round)
+    {
+        IOContext context;
+        EndpointIPv4 endpoint("127.0.0.1", 0);
+        auto server = std::make_unique<RateServer>(context, endpoint);
+        server->start();
+        const int port = server->local_port();
+
+        std::thread runner([&context]
+                           { context.run(); });
+        const int descriptor = connectLoopback(port);
+        server.reset();
+        runner.join();
+
+        // Whether or not the connection was accepted first, it is closed without an answer.
+        BOOST_CHECK(readUntilClosed(descriptor).empty());
+        close(descriptor);
+    }
+}
+
+static Task<std::string> pingOverSocket(IOContext &context, int port)
+{
+    TCPAsyncSocket socket(context);
+    EndpointIPv4 endpoint("127.0.0.1", port);
+
+    const auto connectError = co_await async_connect(socket, endpoint);
+    if (connectError)
+        throw std::system_error(connectError);
+
+    std::vector<char> request{'p', 'i', 'n', 'g'};
+    const auto [writeError, written] = co_await async_write(socket, request);
+    if (writeError || written != request.size())
+        throw std::runtime_error("write failed");
+
+    std::string received;
+    std::vector<char> buffer(16);
+    while (received.size() < 4)
+    {
+        const auto [readError, bytes] = co_await async_read(socket, buffer);
+        if (readError || bytes == 0)
+            break;
+        received.append(buffer.data(), bytes);
+    }
+    co_return received;
+}
+
+BOOST_AUTO_TEST_CASE(test_coroutine_connect_write_read)
+{
+    int port = 0;
+    const int listener = openLoopbackListener(port);
+    std::thread echo([listener]
+                     {
+        const int client = accept(listener, nullptr, nullptr);
+        std::array<char, 4> buffer;
+        std::size_t received = 0;
+        while (received < buffer.size())
+        {
+            const auto count = read(client, buffer.data() + received, buffer.size() - received);
+            if (count <= 0)
+                break;
+            received += count;
+        }
+        write(client, buffer.data(), received);
+        close(client); });
+
+    IOContext context;
+    std::string reply;
+    co_spawn(context, pingOverSocket(context, port), [&](std::exception_ptr exception, std::string value)
+             {
+        BOOST_CHECK(!exception);
+        reply = std::move(value); });
+    context.run();
+    echo.join();
+    close(listener);
+
+    BOOST_CHECK_EQUAL(reply, "ping");
+}
@@ -9,12 +9,30 @@
 #include <thread>
 #include <chrono>
 #include <numeric> 
+#include <sstream>
 #include <algorithm> 
+#include <random>
+#include <cmath>
 #include <sys/socket.h>
+#include <zlib.h>
 
 #include "connection_manager.hpp"
 #include "epoll.hpp"
 #include "async_operations.hpp"
+#include "cross_rates.hpp"
+#include "time_series.hpp"
+#include "http_message.hpp"
+#include "rates_parser.hpp"
+#include "content_decoder.hpp"
+#include "refresh_scheduler.hpp"
+#include "coroutine.hpp"
+#include "strand.hpp"
+#include "work_stealing_pool.hpp"
+#include "latency_histogram.hpp"
+#include "async_logger.hpp"
+#include "tracing.hpp"
+#include "thread_placement.hpp"
+#include "buffer_chain.hpp"
 
 BOOST_AUTO_TEST_SUITE(IOContextTests)
 
@@ -75,6 +93,314 @@ BOOST_AUTO_TEST_CASE(test_run_auto_shutdown_no_work)
     BOOST_CHECK_EQUAL(a, 10);       
 }
 
+static std::pair<int, int> nonBlockingSocketPair()
+{
+    int descriptors[2];
+    BOOST_REQUIRE_EQUAL(socketpair(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0, descriptors), 0);
+    return {descriptors[0], descriptors[1]};
+}
+
+BOOST_AUTO_TEST_CASE(test_destroying_socket_cancels_pending_read)
+{
+    IOContext context;
+    const auto [local, remote] = nonBlockingSocketPair();
+    auto socket = std::make_unique<TCPAsyncSocket>(context, local);
+
+    std::vector<char> buffer(16);
+    std::error_code result;
+    socket->async_read(buffer, [&](const std::error_code &error, size_t)
+                       { result = error; });
+    socket.reset();
+
+    // Used to hang: the pending entry kept the work count above zero forever.
+    context.run();
+    close(remote);
+
+    BOOST_CHECK(result == std::errc::operation_canceled);
+}
+
+BOOST_AUTO_TEST_CASE(test_cancellation_slot_cancels_only_its_operation)
+{
+    IOContext context;
+    const auto [local, remote] = nonBlockingSocketPair();
+    TCPAsyncSocket socket(context, local);
+
+    std::vector<char> buffer(16);
+    std::vector<std::error_code> results;
+    std::size_t received = 0;
+    CancellationSlot slot;
+
+    socket.async_read(buffer, [&](const std::error_code &error, size_t)
+                      {
+        results.push_back(error);
+        socket.async_read(buffer, [&](const std::error_code &error, size_t bytes)
+                          {
+            results.push_back(error);
+            received = bytes; });
+        BOOST_CHECK(!slot.cancel());
+        write(remote, "abc", 3); }, &slot);
+
+    BOOST_CHECK(slot.cancel());
+    context.run();
+    close(remote);
+
+    BOOST_REQUIRE_EQUAL(results.size(), 2u);
+    BOOST_CHECK(results[0] == std::errc::operation_canceled);
+    BOOST_CHECK(!results[1]);
+    BOOST_CHECK_EQUAL(received, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(test_second_operation_on_a_descriptor_is_refused)
+{
+    IOContext context;
+    const auto [local, remote] = nonBlockingSocketPair();
+    TCPAsyncSocket socket(context, local);
+
+    std::vector<char> buffer(16);
+    std::vector<char> otherBuffer(16);
+    std::error_code firstResult;
+    std::error_code secondResult;
+    std::size_t received = 0;
+
+    socket.async_read(buffer, [&](const std::error_code &error, size_t bytes)
+                      {
+        firstResult = error;
+        received = bytes; });
+    // Used to replace the pending read, whose handler never ran and whose work kept run() going.
+    socket.async_read(otherBuffer, [&](const std::error_code &error, size_t)
+                      {
+        secondResult = error;
+        write(remote, "abc", 3); });
+
+    context.run();
+    close(remote);
+
+    BOOST_CHECK(secondResult == std::errc::device_or_resource_busy);
+    BOOST_CHECK(!firstResult);
+    BOOST_CHECK_EQUAL(received, 3u);
+}
+
+BOOST_AUTO_TEST_CASE(test_stale_event_does_not_reach_recycled_descriptor)
+{
+    IOContext context;
+    const auto [firstLocal, firstRemote] = nonBlockingSocketPair();
+    const auto [secondLocal, secondRemote] = nonBlockingSocketPair();
+    TCPAsyncSocket first(context, firstLocal);
+    auto second = std::make_unique<TCPAsyncSocket>(context, secondLocal);
+
+    std::vector<char> buffer(16);
+    std::vector<char> recycledBuffer(16);
+    std::error_code secondResult;
+    std::error_code recycledResult;
+    std::unique_ptr<TCPAsyncSocket> recycled;
+    int recycledRemote = -1;
+
+    first.async_read(buffer, [&](const std::error_code &, size_t)
+                     {
+        // Both descriptors are ready in the same epoll batch; replace the second one while its event is still queued.
+        second.reset();
+        const auto [local, remote] = nonBlockingSocketPair();
+        recycledRemote = remote;
+        BOOST_CHECK_EQUAL(local, secondLocal);
+        recycled = std::make_unique<TCPAsyncSocket>(context, local);
+        recycled->async_read(recycledBuffer, [&](const std::error_code &error, size_t)
+                             { recycledResult = error; });
+        context.post([&]
+                     { recycled->cancel(); }); });
+    second->async_read(buffer, [&](const std::error_code &error, size_t)
+                       { secondResult = error; });
+
+    write(firstRemote, "a", 1);
+    write(secondRemote, "b", 1);
+    context.run();
+
+    BOOST_CHECK(secondResult == std::errc::operation_canceled);
+    BOOST_CHECK(recycledResult == std::errc::operation_canceled);
+
+    close(firstRemote);
+    close(secondRemote);
+    close(recycledRemote);
+}
+
+BOOST_AUTO_TEST_CASE(test_bursts_larger_than_event_batch_complete_on_all_threads)
+{
+    constexpr int SOCKETS = 8 * IOContext::MIN_EVENT_BATCH;
+    IOContext context;
+    std::vector<std::unique_ptr<TCPAsyncSocket>> sockets;
+    std::vector<int> remotes;
+    std::vector<std::vector<char>> buffers(SOCKETS, std::vector<char>(4));
+    std::atomic<int> completed{0};
+    std::atomic<std::size_t> received{0};
+    std::atomic<int> failed{0};
+
+    for (int index = 0; index < SOCKETS; ++index)
+    {
+        const auto [local, remote] = nonBlockingSocketPair();
+        sockets.push_back(std::make_unique<TCPAsyncSocket>(context, local));
+        remotes.push_back(remote);
+        sockets.back()->async_read(buffers[index], [&](const std::error_code &error, size_t bytes)
+                                   {
+            if (error)
+                ++failed;
+            received += bytes;
+            ++completed; });
+        write(remote, "ping", 4);
+    }
+
+    // Several threads wait on one epoll set, each into its own buffer.
+    std::vector<std::thread> threads;
+    for (int index = 0; index < 4; ++index)
+        threads.emplace_back([&]
+                             { context.run(); });
+    for (auto &thread : threads)
+        thread.join();
+
+    BOOST_CHECK_EQUAL(completed.load(), SOCKETS);
+    BOOST_CHECK_EQUAL(failed.load(), 0);
+    BOOST_CHECK_EQUAL(received.load(), static_cast<std::size_t>(4 * SOCKETS));
+    for (const auto remote : remotes)
+        close(remote);
+}
+
+BOOST_AUTO_TEST_CASE(test_metrics_are_collected_while_running_and_nothing_is_printed)
+{
+    IOContext context;
+    const auto [local, remote] = nonBlockingSocketPair();
+    TCPAsyncSocket socket(context, local);
+    std::vector<char> buffer(16);
+    std::vector<char> reply = {'o', 'k'};
+    IOMetricsSnapshot during;
+
+    socket.async_read(buffer, [&](const std::error_code &error, size_t bytes)
+                      {
+        BOOST_CHECK(!error);
+        BOOST_CHECK_EQUAL(bytes, 5u);
+        socket.async_write(reply, [&](const std::error_code &, size_t) {});
+        // Taken from inside a handler: the loop is running and the operation counts as completed.
+        during = context.metrics(); });
+    for (int idx = 0; idx < 10; ++idx)
+        context.post([] {});
+    context.post_after(std::chrono::milliseconds(1), [] {});
+    write(remote, "hello", 5);
+
+    std::stringstream captured;
+    auto *previous = std::cout.rdbuf(captured.rdbuf());
+    context.run();
+    std::cout.rdbuf(previous);
+    close(remote);
+
+    BOOST_CHECK(captured.str().empty());
+    BOOST_CHECK_EQUAL(during.runningThreads, 1u);
+    BOOST_CHECK_EQUAL(during.operationsCompleted, 1u);
+
+    const auto after = context.metrics();
+    BOOST_CHECK_EQUAL(after.tasksExecuted, 10u);
+    BOOST_CHECK_EQUAL(after.timersFired, 1u);
+    BOOST_CHECK_EQUAL(after.operationsCompleted, 1u);
+    BOOST_CHECK_EQUAL(after.bytesRead, 5u);
+    BOOST_CHECK_EQUAL(after.bytesWritten, 2u);
+    BOOST_CHECK_EQUAL(socket.bytes_read(), 5u);
+    BOOST_CHECK_EQUAL(socket.bytes_written(), 2u);
+    BOOST_CHECK_EQUAL(after.handlerTime.count(), 1u);
+    BOOST_CHECK_EQUAL(after.taskTime.count(), 11u);
+    BOOST_CHECK_EQUAL(after.eventsPerWait.count(), after.waits);
+    BOOST_CHECK_GE(after.events, 2u);
+    BOOST_CHECK_EQUAL(after.pendingOperations, 0u);
+    BOOST_CHECK_EQUAL(after.queuedTasks, 0u);
+    BOOST_CHECK_EQUAL(after.runningThreads, 0u);
+}
+
+BOOST_AUTO_TEST_CASE(test_busy_poll_spins_for_the_budget_then_blocks)
+{
+    IOContext context;
+    context.set_busy_poll(std::chrono::milliseconds(1));
+    BOOST_CHECK(context.busy_poll() == std::chrono::milliseconds(1));
+
+    bool fired = false;
+    context.post_after(std::chrono::milliseconds(30), [&fired]
+                       { fired = true; });
+    context.run();
+    BOOST_CHECK(fired);
+
+    const auto metrics = context.metrics();
+    BOOST_CHECK_EQUAL(metrics.busyPollMicroseconds, 1000u);
+    // The thread spun after its last activity and then blocked until the timer; no wall-clock thresholds, so a loaded
+    // machine cannot fail it.
+    BOOST_CHECK_GT(metrics.busyPolls, 0u);
+    BOOST_CHECK_GT(metrics.sleepNanoseconds, 0u);
+    BOOST_CHECK_LT(metrics.spin_ratio(), 1.0);
+
+    context.set_busy_poll(std::chrono::microseconds(0));
+    BOOST_CHECK(context.busy_poll() == std::chrono::microseconds(0));
+}
+
+BOOST_AUTO_TEST_CASE(test_timers_fire_in_deadline_order)
+{
+    IOContext context;
+    std::vector<int> order;
+
+    context.post_after(std::chrono::milliseconds(30), [&]
+                       { order.push_back(3); });
+    context.post_after(std::chrono::milliseconds(10), [&]
+                       { order.push_back(1); });
+    const auto cancelled = context.post_after(std::chrono::milliseconds(20), [&]
+                                              { order.push_back(2); });
+    BOOST_CHECK(context.cancel_timer(cancelled));
+    BOOST_CHECK(!context.cancel_timer(cancelled));
+
+    const auto start = IOContext::clock_type::now();
+    context.run();
+
+    BOOST_CHECK(order == std::vector<int>({1, 3}));
+    BOOST_CHECK(IOContext::clock_type::now() - start >= std::chrono::milliseconds(30));
+}
+
+BOOST_AUTO_TEST_CASE(test_single_threaded_context_runs_tasks_timers_and_sockets)
+{
+    using SingleThreadedContext = BasicIOContext<SingleThreaded>;
+    SingleThreadedContext context;
+    const auto [local, remote] = nonBlockingSocketPair();
+    BasicTCPAsyncSocket<SingleThreaded> socket(context, local);
+
+    std::vector<std::string> order;
+    std::vector<char> buffer(16);
+    std::vector<std::error_code> results;
+    std::size_t received = 0;
+    BasicCancellationSlot<SingleThreaded> slot;
+
+    // Without a wakeup pipe, tasks posted by tasks and handlers must still run before the loop blocks again.
+    context.post([&]
+                 {
+        order.push_back("task");
+        context.post([&]
+                     { order.push_back("nested task"); }); });
+    context.post_after(std::chrono::milliseconds(10), [&]
+                       {
+        order.push_back("timer");
+        write(remote, "abc", 3); });
+
+    socket.async_read(buffer, [&](const std::error_code &error, size_t)
+                      { results.push_back(error); }, &slot);
+    BOOST_CHECK(slot.cancel());
+    socket.async_read(buffer, [&](const std::error_code &error, size_t bytes)
+                      {
+        results.push_back(error);
+        received = bytes;
+        context.post([&]
+                     { order.push_back("after read"); }); });
+
+    context.run();
+    close(remote);
+
+    BOOST_CHECK(order == std::vector<std::string>({"task", "nested task", "timer", "after read"}));
+    BOOST_REQUIRE_EQUAL(results.size(), 2u);
+    BOOST_CHECK(results[0] == std::errc::operation_canceled);
+    BOOST_CHECK(!results[1]);
+    BOOST_CHECK_EQUAL(received, 3u);
+    BOOST_CHECK_EQUAL(socket.bytes_read(), 3u);
+    BOOST_CHECK_EQUAL(context.metrics().outstandingWork, 0u);
+}
+
 BOOST_AUTO_TEST_SUITE_END()
 
 BOOST_AUTO_TEST_CASE(endpoint_test)
@@ -160,3 +486,1307 @@ BOOST_AUTO_TEST_CASE(Epoll_test)
     }
 }
 
+BOOST_AUTO_TEST_SUITE(CrossRateMatrixTests)
+
+static Valute makeValute(const std::string &code, int nominal, float value)
+{
+    Valute valute;
+    valute.ID = "R" + code;
+    valute.NumCode = 0;
+    valute.CharCode = code;
+    valute.Nominal = nominal;
+    valute.Name = code;
+    valute.Value = value;
+    valute.VunitRate = value / nominal;
+    return valute;
+}
+
+static rates_table_type makeTable()
+{
+    rates_table_type table;
+    table.emplace("USD", makeValute("USD", 1, 80.0f));
+    table.emplace("EUR", makeValute("EUR", 1, 92.0f));
+    table.emplace("CNY", makeValute("CNY", 10, 110.0f));
+    table.emplace("KZT", makeValute("KZT", 100, 16.0f));
+    table.emplace("JPY", makeValute("JPY", 100, 52.0f));
+    return table;
+}
+
+BOOST_AUTO_TEST_CASE(test_matrix_matches_direct_division)
+{
+    const auto table = makeTable();
+    CrossRateMatrix matrix(table);
+
+    BOOST_CHECK_EQUAL(matrix.size(), table.size() + 1);
+
+    for (const auto &from : matrix.codes())
+    {
+        for (const auto &to : matrix.codes())
+        {
+            const double fromUnit = from == "RUB" ? 1.0 : unitRate(table.at(from));
+            const double toUnit = to == "RUB" ? 1.0 : unitRate(table.at(to));
+            BOOST_CHECK_CLOSE(matrix.rate(from, to), fromUnit / toUnit, 1e-9);
+        }
+    }
+
+    BOOST_CHECK_CLOSE(matrix.rate("USD", "RUB"), 80.0, 1e-9);
+    BOOST_CHECK_CLOSE(matrix.rate("CNY", "KZT"), 11.0 / 0.16, 1e-9);
+    BOOST_CHECK_THROW(static_cast<void>(matrix.rate("USD", "XXX")), std::invalid_argument);
+}
+
+BOOST_AUTO_TEST_CASE(test_incremental_update_equals_rebuild)
+{
+    auto table = makeTable();
+    CrossRateMatrix matrix(table);
+
+    table.at("EUR").Value = 95.5f;
+    BOOST_CHECK_EQUAL(matrix.update(table), 1u);
+    BOOST_CHECK_EQUAL(matrix.update(table), 0u);
+
+    CrossRateMatrix expected(table);
+    for (CrossRateMatrix::index_type from = 0; from < matrix.size(); ++from)
+    {
+        for (CrossRateMatrix::index_type to = 0; to < matrix.size(); ++to)
+        {
+            BOOST_CHECK_EQUAL(matrix.rate(from, to), expected.rate(from, to));
+        }
+    }
+
+    table.emplace("GBP", makeValute("GBP", 1, 105.0f));
+    BOOST_CHECK_EQUAL(matrix.update(table), table.size() + 1);
+    BOOST_CHECK_CLOSE(matrix.rate("GBP", "USD"), 105.0 / 80.0, 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_failed_rebuild_keeps_the_previous_matrix)
+{
+    auto table = makeTable();
+    CrossRateMatrix matrix(table);
+
+    // A new currency forces a rebuild; its zero Value makes it throw halfway.
+    table.emplace("AAA", makeValute("AAA", 1, 0.0f));
+    BOOST_CHECK_THROW(matrix.update(table), std::invalid_argument);
+
+    BOOST_CHECK_EQUAL(matrix.size(), 6u);
+    BOOST_CHECK_CLOSE(matrix.rate("USD", "RUB"), 80.0, 1e-9);
+    BOOST_CHECK_CLOSE(matrix.rate("EUR", "USD"), 92.0 / 80.0, 1e-9);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(RateTimeSeriesTests)
+
+BOOST_AUTO_TEST_CASE(test_cbr_date_round_trip)
+{
+    BOOST_CHECK_EQUAL(dayFromCivil(1970, 1, 1), 0);
+    BOOST_CHECK_EQUAL(parseCbrDate("06/11/2025").value(), dayFromCivil(2025, 11, 6));
+    BOOST_CHECK_EQUAL(parseCbrDate("29.02.2024").value(), dayFromCivil(2024, 2, 29));
+    BOOST_CHECK_EQUAL(formatCbrDate(dayFromCivil(2000, 2, 29)), "29/02/2000");
+    BOOST_CHECK(!parseCbrDate("2025-11-06").has_value());
+    BOOST_CHECK(!parseCbrDate("31/02/2025").has_value());
+    BOOST_CHECK(!parseCbrDate("29.02.2023").has_value());
+    BOOST_CHECK(!parseCbrDate("31/04/2025").has_value());
+    BOOST_CHECK(parseCbrDate("29/02/2000").has_value());
+    BOOST_CHECK(!parseCbrDate("29/02/1900").has_value());
+}
+
+BOOST_AUTO_TEST_CASE(test_range_aggregates_match_naive_scan)
+{
+    const std::size_t daysCount = RateTimeSeries::BLOCK_SIZE * 4 + 37;
+    RateTimeSeries history;
+    std::vector<double> usd;
+    std::vector<double> cny;
+    const auto start = dayFromCivil(2015, 1, 1);
+
+    for (std::size_t idx = 0; idx < daysCount; ++idx)
+    {
+        rates_table_type table;
+        Valute valute;
+        valute.CharCode = "USD";
+        valute.Nominal = 1;
+        valute.Value = 60.0f + static_cast<float>((idx * 37) % 101) / 7.0f;
+        table.emplace("USD", valute);
+        usd.push_back(valute.Value);
+
+        if (idx >= 301 && idx % 5 != 0)
+        {
+            valute.CharCode = "CNY";
+            valute.Nominal = 10;
+            valute.Value = 100.0f + static_cast<float>(idx % 13);
+            table.emplace("CNY", valute);
+        }
+        if (idx >= 301)
+            cny.push_back(table.count("CNY") ? table.at("CNY").Value / 10.0 : cny.back());
+
+        history.append(start + static_cast<day_type>(idx * 2), table);
+    }
+
+    auto check = [&](const std::string &code, const std::vector<double> &column, std::size_t offset, std::size_t begin, std::size_t end)
+    {
+        const auto aggregate = history.aggregate(code, start + static_cast<day_type>(begin * 2), start + static_cast<day_type>(end * 2 - 1));
+        BOOST_REQUIRE(aggregate.has_value());
+
+        const auto first = std::max(begin, offset) - offset;
+        const auto last = end - offset;
+        double sum = 0.0;
+        for (auto idx = first; idx < last; ++idx)
+            sum += column[idx];
+
+        BOOST_CHECK_EQUAL(aggregate->count, last - first);
+        BOOST_CHECK_EQUAL(aggregate->min, *std::min_element(column.begin() + first, column.begin() + last));
+        BOOST_CHECK_EQUAL(aggregate->max, *std::max_element(column.begin() + first, column.begin() + last));
+        BOOST_CHECK_CLOSE(aggregate->mean, sum / (last - first), 1e-9);
+        BOOST_CHECK_EQUAL(aggregate->first, column[first]);
+        BOOST_CHECK_EQUAL(aggregate->last, column[last - 1]);
+    };
+
+    check("USD", usd, 0, 0, daysCount);
+    check("USD", usd, 0, 3, 4);
+    check("USD", usd, 0, 100, 900);
+    check("USD", usd, 0, 256, 768);
+    check("CNY", cny, 301, 0, daysCount);
+    check("CNY", cny, 301, 511, 1000);
+
+    BOOST_CHECK(!history.aggregate("CNY", start, start + 100).has_value());
+    BOOST_CHECK(!history.aggregate("EUR", start, start + 100).has_value());
+    BOOST_CHECK_CLOSE(history.last("USD").value(), usd.back(), 1e-9);
+}
+
+BOOST_AUTO_TEST_CASE(test_append_order_and_replacement)
+{
+    RateTimeSeries history;
+    rates_table_type table;
+    Valute valute;
+    valute.CharCode = "EUR";
+    valute.Nominal = 1;
+    valute.Value = 90.0f;
+    table.emplace("EUR", valute);
+
+    history.append(dayFromCivil(2025, 1, 10), table);
+    table.at("EUR").Value = 99.0f;
+    history.append(dayFromCivil(2025, 1, 10), table);
+
+    BOOST_CHECK_EQUAL(history.days().size(), 1u);
+    BOOST_CHECK_EQUAL(history.last("EUR").value(), 99.0);
+    BOOST_CHECK_CLOSE(history.aggregate("EUR", dayFromCivil(2025, 1, 1), dayFromCivil(2025, 2, 1))->change_percent(), 0.0, 1e-9);
+    BOOST_CHECK_THROW(history.append(dayFromCivil(2025, 1, 9), table), std::invalid_argument);
+
+    // A currency without a valid rate fails the whole day, which used to stay on the axis without its values.
+    Valute broken;
+    broken.CharCode = "XXX";
+    broken.Nominal = 0;
+    table.emplace("XXX", broken);
+    BOOST_CHECK_THROW(history.append(dayFromCivil(2025, 1, 11), table), std::invalid_argument);
+    BOOST_CHECK_EQUAL(history.days().size(), 1u);
+    BOOST_CHECK_EQUAL(history.currencies_count(), 1u);
+    BOOST_CHECK_EQUAL(history.last("EUR").value(), 99.0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(RefreshSchedulerTests)
+
+BOOST_AUTO_TEST_CASE(test_refresh_delay_tightens_around_publication)
+{
+    using namespace std::chrono;
+    RefreshPolicy policy;
+    policy.interval = minutes(30);
+    policy.publicationTime = hours(15) + minutes(30);
+    policy.publicationWindow = minutes(45);
+    policy.publicationInterval = minutes(2);
+
+    BOOST_CHECK(refreshDelay(policy, hours(9)) == minutes(30));
+    BOOST_CHECK(refreshDelay(policy, hours(14) + minutes(30)) == minutes(15));
+    BOOST_CHECK(refreshDelay(policy, hours(15)) == minutes(2));
+    BOOST_CHECK(refreshDelay(policy, hours(16) + minutes(14)) == minutes(2));
+    BOOST_CHECK(refreshDelay(policy, hours(16) + minutes(15)) == minutes(30));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(CoroutineTests)
+
+static Task<int> delayedValue(IOContext &context, int value)
+{
+    co_await async_wait(context, std::chrono::milliseconds(1));
+    co_return value;
+}
+
+static Task<int> sumOfDelayed(IOContext &context, int count)
+{
+    int sum = 0;
+    for (int idx = 1; idx <= count; ++idx)
+    {
+        sum += co_await delayedValue(context, idx);
+    }
+    co_return sum;
+}
+
+static Task<void> failing()
+{
+    throw std::runtime_error("failed");
+    co_return;
+}
+
+BOOST_AUTO_TEST_CASE(test_spawned_tasks_complete_with_values_and_exceptions)
+{
+    IOContext context;
+    int sum = 0;
+    std::exception_ptr failure;
+
+    co_spawn(context, sumOfDelayed(context, 10), [&](std::exception_ptr exception, int value)
+             {
+        BOOST_CHECK(!exception);
+        sum = value; });
+    co_spawn(context, failing(), [&](std::exception_ptr exception)
+             { failure = exception; });
+    context.run();
+
+    BOOST_CHECK_EQUAL(sum, 55);
+    BOOST_CHECK_THROW(std::rethrow_exception(failure), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_frames_are_recycled)
+{
+    IOContext context;
+    co_spawn(context, sumOfDelayed(context, 2), [](std::exception_ptr, int) {});
+    context.run();
+
+    const auto heapAllocations = FrameAllocator::heap_allocations();
+    for (int round = 0; round < 3; ++round)
+    {
+        co_spawn(context, sumOfDelayed(context, 5), [](std::exception_ptr, int) {});
+        context.run();
+    }
+    BOOST_CHECK_EQUAL(FrameAllocator::heap_allocations(), heapAllocations);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(StrandTests)
+
+BOOST_AUTO_TEST_CASE(test_strand_serializes_handlers_across_threads)
+{
+    IOContext context;
+    Strand first(context);
+    Strand second(context);
+
+    constexpr int TASKS = 2000;
+    int firstCounter = 0;
+    int secondCounter = 0;
+    std::atomic<int> insideFirst{0};
+    std::atomic<bool> overlapped{false};
+    std::vector<int> order;
+
+    std::vector<std::thread> producers;
+    for (int producer = 0; producer < 4; ++producer)
+    {
+        producers.emplace_back([&]
+                               {
+            for (int idx = 0; idx < TASKS / 4; ++idx)
+            {
+                first.post([&]
+                           {
+                    if (insideFirst.fetch_add(1) != 0)
+                        overlapped = true;
+                    ++firstCounter;
+                    insideFirst.fetch_sub(1); });
+            }
+        });
+    }
+    for (auto &producer : producers)
+    {
+        producer.join();
+    }
+
+    for (int idx = 0; idx < TASKS; ++idx)
+    {
+        second.post([&, idx]
+                    {
+            BOOST_CHECK(second.running_in_this_thread());
+            BOOST_CHECK(!first.running_in_this_thread());
+            ++secondCounter;
+            order.push_back(idx); });
+    }
+
+    std::vector<std::thread> threads;
+    for (int idx = 0; idx < 4; ++idx)
+    {
+        threads.emplace_back([&]
+                             { context.run(); });
+    }
+    for (auto &thread : threads)
+    {
+        thread.join();
+    }
+
+    BOOST_CHECK(!overlapped.load());
+    BOOST_CHECK_EQUAL(firstCounter, TASKS);
+    BOOST_CHECK_EQUAL(secondCounter, TASKS);
+    BOOST_CHECK(std::is_sorted(order.begin(), order.end()));
+    BOOST_CHECK(!second.running_in_this_thread());
+}
+
+BOOST_AUTO_TEST_CASE(test_strand_dispatch_and_wrap)
+{
+    IOContext context;
+    Strand strand(context);
+    std::vector<int> order;
+
+    strand.post([&]
+                {
+        order.push_back(1);
+        strand.dispatch([&]
+                        { order.push_back(2); });
+        order.push_back(3); });
+
+    auto wrapped = strand.wrap([&](const std::error_code &error, size_t bytes)
+                               {
+        BOOST_CHECK(!error);
+        order.push_back(static_cast<int>(bytes)); });
+    wrapped(std::error_code(), 4);
+    context.run();
+
+    BOOST_CHECK(order == std::vector<int>({1, 2, 3, 4}));
+}
+
+BOOST_AUTO_TEST_CASE(test_strand_survives_a_throwing_task)
+{
+    IOContext context;
+    Strand strand(context);
+    std::vector<int> order;
+
+    strand.post([]
+                { throw std::runtime_error("task failed"); });
+    strand.post([&]
+                { order.push_back(1); });
+    BOOST_CHECK_THROW(context.run(), std::runtime_error);
+    BOOST_CHECK(!strand.running_in_this_thread());
+
+    // Used to deadlock: the pending counter kept the throwing task and no post scheduled a drain again.
+    context.run();
+    strand.post([&]
+                { order.push_back(2); });
+    context.run();
+
+    BOOST_CHECK(order == std::vector<int>({1, 2}));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(WorkStealingPoolTests)
+
+BOOST_AUTO_TEST_CASE(test_chase_lev_deque_hands_out_every_item_once)
+{
+    constexpr int ITEMS = 20000;
+    ChaseLevDeque<int *> deque(4);
+    std::vector<int> items(ITEMS);
+    std::vector<std::atomic<int>> seen(ITEMS);
+    std::atomic<bool> producing{true};
+
+    std::vector<std::thread> thieves;
+    for (int idx = 0; idx < 3; ++idx)
+    {
+        thieves.emplace_back([&]
+                             {
+            while (producing.load() || deque.size_approx() > 0)
+            {
+                if (auto item = deque.steal())
+                    seen[item - items.data()].fetch_add(1);
+            } });
+    }
+
+    for (int idx = 0; idx < ITEMS; ++idx)
+    {
+        deque.push(&items[idx]);
+        if (idx % 3 == 0)
+        {
+            if (auto item = deque.take())
+                seen[item - items.data()].fetch_add(1);
+        }
+    }
+    while (auto item = deque.take())
+    {
+        seen[item - items.data()].fetch_add(1);
+    }
+    producing = false;
+    for (auto &thief : thieves)
+    {
+        thief.join();
+    }
+
+    BOOST_CHECK(std::all_of(seen.begin(), seen.end(), [](const std::atomic<int> &count)
+                            { return count.load() == 1; }));
+}
+
+BOOST_AUTO_TEST_CASE(test_dispatch_cpu_runs_off_reactor_and_continues_on_it)
+{
+    WorkStealingPool pool(2);
+    IOContext context;
+    context.set_cpu_pool(pool);
+
+    constexpr int TASKS = 50;
+    std::atomic<int> offReactor{0};
+    int continued = 0;
+    std::thread::id reactorThread;
+
+    context.post([&]
+                 {
+        reactorThread = std::this_thread::get_id();
+        for (int idx = 0; idx < TASKS; ++idx)
+        {
+            context.dispatch_cpu([&]
+                                 {
+                if (std::this_thread::get_id() != reactorThread)
+                    ++offReactor; },
+                                 [&]
+                                 {
+                BOOST_CHECK(std::this_thread::get_id() == reactorThread);
+                ++continued; });
+        } });
+    context.run();
+
+    BOOST_CHECK_EQUAL(offReactor.load(), TASKS);
+    BOOST_CHECK_EQUAL(continued, TASKS);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(LatencyHistogramTests)
+
+BOOST_AUTO_TEST_CASE(test_percentiles_stay_within_bucket_precision)
+{
+    LatencyHistogram histogram;
+    std::vector<uint64_t> values;
+    std::mt19937_64 generator(7);
+    std::lognormal_distribution<double> latency(11.0, 1.5);
+
+    for (int idx = 0; idx < 100'000; ++idx)
+    {
+        values.push_back(static_cast<uint64_t>(latency(generator)));
+        histogram.record(values.back());
+    }
+    std::sort(values.begin(), values.end());
+
+    BOOST_CHECK_EQUAL(histogram.count(), values.size());
+    BOOST_CHECK_EQUAL(histogram.min(), values.front());
+    BOOST_CHECK_EQUAL(histogram.max(), values.back());
+    for (const double percentile : {50.0, 90.0, 99.0, 99.9, 100.0})
+    {
+        const auto exact = values[static_cast<std::size_t>(std::ceil(percentile / 100.0 * values.size())) - 1];
+        const auto reported = histogram.value_at_percentile(percentile);
+        BOOST_CHECK_GE(reported, exact);
+        BOOST_CHECK_LE(reported, exact + exact / 128);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_small_values_are_exact_and_merge_adds_up)
+{
+    LatencyHistogram first;
+    LatencyHistogram second;
+    for (uint64_t value = 0; value < 100; ++value)
+    {
+        (value % 2 == 0 ? first : second).record(value);
+    }
+    second.record(uint64_t(1) << 40);
+
+    first.merge(second);
+    BOOST_CHECK_EQUAL(first.count(), 101u);
+    BOOST_CHECK_EQUAL(first.value_at_percentile(50.0), 50u);
+    BOOST_CHECK_EQUAL(first.max(), first.max_value());
+    BOOST_CHECK_EQUAL(first.value_at_percentile(100.0), first.max_value());
+
+    first.reset();
+    BOOST_CHECK_EQUAL(first.count(), 0u);
+    BOOST_CHECK_EQUAL(first.value_at_percentile(99.0), 0u);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(AsyncLoggerTests)
+
+static std::vector<std::string> readLines(FILE *file)
+{
+    fflush(file);
+    rewind(file);
+    std::vector<std::string> lines;
+    std::array<char, 1024> buffer;
+    while (fgets(buffer.data(), buffer.size(), file) != nullptr)
+    {
+        lines.emplace_back(buffer.data());
+    }
+    return lines;
+}
+
+BOOST_AUTO_TEST_CASE(test_messages_are_formatted_by_the_writer_thread)
+{
+    FILE *file = tmpfile();
+    BOOST_REQUIRE(file != nullptr);
+    {
+        AsyncLogger logger(fileno(file));
+        logger.log<LogLevel::INFO>("fetched ", 43, " rates in ", 1.5, " ms, cached ", true, ' ', std::string("USD"));
+        logger.log<LogLevel::DEBUG>("compiled out");
+        logger.log<LogLevel::ERROR>("read failed: ", std::make_error_code(std::errc::connection_reset));
+        logger.loggingMessage(LogLevel::WARNING, "runtime level");
+        logger.flush();
+
+        const auto lines = readLines(file);
+        BOOST_REQUIRE_EQUAL(lines.size(), 3u);
+        BOOST_CHECK(lines[0].find(" INFO MESSAGE: fetched 43 rates in 1.5 ms, cached true USD\n") != std::string::npos);
+        BOOST_CHECK(lines[0].find(" UTC ") != std::string::npos);
+        BOOST_CHECK(lines[1].find(" ERROR MESSAGE: read failed: " + std::make_error_code(std::errc::connection_reset).message()) != std::string::npos);
+        BOOST_CHECK(lines[2].find(" WARNING MESSAGE: runtime level") != std::string::npos);
+        BOOST_CHECK_EQUAL(logger.dropped(), 0u);
+    }
+    fclose(file);
+}
+
+BOOST_AUTO_TEST_CASE(test_overload_drops_are_counted_and_reported)
+{
+    constexpr int THREADS = 4;
+    constexpr int MESSAGES = 5000;
+    FILE *file = tmpfile();
+    BOOST_REQUIRE(file != nullptr);
+    uint64_t dropped = 0;
+    {
+        AsyncLogger logger(fileno(file), 8);
+        std::vector<std::thread> threads;
+        for (int thread = 0; thread < THREADS; ++thread)
+            threads.emplace_back([&logger, thread]
+                                 {
+                for (int idx = 0; idx < MESSAGES; ++idx)
+                    logger.log<LogLevel::INFO>("thread ", thread, " message ", idx); });
+        for (auto &thread : threads)
+            thread.join();
+        logger.flush();
+        dropped = logger.dropped();
+    }
+
+    uint64_t messages = 0;
+    uint64_t reported = 0;
+    for (const auto &line : readLines(file))
+    {
+        if (line.find(" INFO MESSAGE: thread ") != std::string::npos)
+            ++messages;
+        else if (line.find(" log messages dropped") != std::string::npos)
+            reported += std::strtoull(line.c_str() + line.find("MESSAGE: ") + 9, nullptr, 10);
+    }
+    fclose(file);
+
+    BOOST_CHECK_EQUAL(messages + dropped, static_cast<uint64_t>(THREADS * MESSAGES));
+    BOOST_CHECK_EQUAL(reported, dropped);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(TracingTests)
+
+static std::size_t countOccurrences(const std::string &text, const std::string &pattern)
+{
+    std::size_t count = 0;
+    for (auto position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1))
+        ++count;
+    return count;
+}
+
+BOOST_AUTO_TEST_CASE(test_spans_of_several_threads_are_written_as_chrome_trace_json)
+{
+    constexpr int THREADS = 4;
+    // More than one chunk per thread.
+    constexpr int SPANS = 1500;
+    Tracer tracer;
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < THREADS; ++thread)
+        threads.emplace_back([&tracer, thread]
+                             {
+            for (int idx = 0; idx < SPANS; ++idx)
+            {
+                const TraceSpan span(tracer, "test", "span", idx + 1);
+            }
+            tracer.async_begin("test", "operation", thread + 1);
+            tracer.async_instant("test", "ready", thread + 1);
+            tracer.async_end("test", "operation", thread + 1); });
+    for (auto &thread : threads)
+        thread.join();
+
+    tracer.set_enabled(false);
+    tracer.complete("test", "ignored", Tracer::now());
+
+    std::ostringstream stream;
+    tracer.write_json(stream);
+    const auto json = stream.str();
+
+    BOOST_CHECK_EQUAL(json.rfind("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", 0), 0u);
+    BOOST_CHECK_EQUAL(countOccurrences(json, "\"ph\":\"X\""), static_cast<std::size_t>(THREADS * SPANS));
+    BOOST_CHECK_EQUAL(countOccurrences(json, "\"ph\":\"b\""), static_cast<std::size_t>(THREADS));
+    BOOST_CHECK_EQUAL(countOccurrences(json, "\"ph\":\"n\""), static_cast<std::size_t>(THREADS));
+    BOOST_CHECK_EQUAL(countOccurrences(json, "\"ph\":\"e\""), static_cast<std::size_t>(THREADS));
+    BOOST_CHECK_EQUAL(countOccurrences(json, "ignored"), 0u);
+    BOOST_CHECK(json.find("\"otherData\":{\"dropped\":0}") != std::string::npos);
+    BOOST_CHECK_EQUAL(tracer.dropped(), 0u);
+
+    tracer.clear();
+    std::ostringstream empty;
+    tracer.write_json(empty);
+    BOOST_CHECK_EQUAL(countOccurrences(empty.str(), "\"ph\""), 0u);
+}
+
+#if ASYNC_CONNECT_TRACING
+BOOST_AUTO_TEST_CASE(test_io_context_traces_the_operation_lifecycle)
+{
+    Tracer::global().clear();
+
+    IOContext context;
+    const auto [local, remote] = IOContextTests::nonBlockingSocketPair();
+    TCPAsyncSocket socket(context, local);
+
+    std::vector<char> buffer(16);
+    socket.async_read(buffer, [](const std::error_code &, size_t) {});
+    BOOST_REQUIRE_EQUAL(write(remote, "x", 1), 1);
+    context.run();
+    close(remote);
+
+    std::ostringstream stream;
+    Tracer::global().write_json(stream);
+    const auto json = stream.str();
+
+    BOOST_CHECK_EQUAL(countOccurrences(json, "{\"name\":\"read\",\"cat\":\"io\",\"ph\":\"b\""), 1u);
+    BOOST_CHECK_EQUAL(countOccurrences(json, "{\"name\":\"ready\",\"cat\":\"io\",\"ph\":\"n\""), 1u);
+    BOOST_CHECK_EQUAL(countOccurrences(json, "{\"name\":\"handler\",\"cat\":\"io\",\"ph\":\"X\""), 1u);
+    BOOST_CHECK_EQUAL(countOccurrences(json, "{\"name\":\"read\",\"cat\":\"io\",\"ph\":\"e\""), 1u);
+}
+#endif
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ThreadPlacementTests)
+
+BOOST_AUTO_TEST_CASE(test_cpu_lists_and_policies)
+{
+    BOOST_CHECK(parseCpuList("0-3,8,10-11\n") == std::vector<int>({0, 1, 2, 3, 8, 10, 11}));
+    BOOST_CHECK(parseCpuList("5,x,3-1,4") == std::vector<int>({4, 5}));
+    BOOST_CHECK(parseCpuList("").empty());
+
+    const CpuTopology topology({NumaNode{0, {0, 1}}, NumaNode{1, {2, 3}}});
+    BOOST_CHECK_EQUAL(topology.node_of(3), 1);
+    BOOST_CHECK_EQUAL(topology.node_of(7), -1);
+
+    const auto compact = ThreadPlacement::compact();
+    const auto spread = ThreadPlacement::spread();
+    std::vector<int> compactCpus;
+    std::vector<int> spreadCpus;
+    for (std::size_t idx = 0; idx < 5; ++idx)
+    {
+        compactCpus.push_back(compact.cpus_for(idx, topology).at(0));
+        spreadCpus.push_back(spread.cpus_for(idx, topology).at(0));
+    }
+    BOOST_CHECK(compactCpus == std::vector<int>({0, 1, 2, 3, 0}));
+    BOOST_CHECK(spreadCpus == std::vector<int>({0, 2, 1, 3, 0}));
+    BOOST_CHECK(ThreadPlacement().cpus_for(0, topology).empty());
+    BOOST_CHECK(ThreadPlacement::cpus({{3}, {1, 2}}).cpus_for(3, topology) == std::vector<int>({1, 2}));
+}
+
+BOOST_AUTO_TEST_CASE(test_run_threads_pins_every_reactor_thread)
+{
+    const auto &nodes = CpuTopology::system().nodes();
+    BOOST_REQUIRE(!nodes.empty());
+    const auto cpu = nodes.front().cpus.front();
+
+    IOContext context;
+    // Keeps the threads inside run() while their affinity is checked.
+    context.inc_work();
+
+    std::error_code error;
+    auto threads = context.run_threads(3, ThreadPlacement::cpus({{cpu}}), &error);
+    BOOST_CHECK(!error);
+    BOOST_CHECK_EQUAL(context.pinned_cpu(), cpu);
+
+    for (auto &thread : threads)
+    {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        BOOST_REQUIRE_EQUAL(pthread_getaffinity_np(thread.native_handle(), sizeof(set), &set), 0);
+        BOOST_CHECK_EQUAL(CPU_COUNT(&set), 1);
+        BOOST_CHECK(CPU_ISSET(cpu, &set));
+    }
+
+    context.dec_work();
+    for (auto &thread : threads)
+        thread.join();
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(BufferChainTests)
+
+BOOST_AUTO_TEST_CASE(test_pool_recycles_blocks_and_sizer_adapts)
+{
+    BufferPool pool;
+    BOOST_CHECK_EQUAL(BufferPool::block_size(1), BufferPool::MIN_BLOCK_SIZE);
+    BOOST_CHECK_EQUAL(BufferPool::block_size(5000), 8192u);
+    BOOST_CHECK_EQUAL(BufferPool::block_size(1 << 20), BufferPool::MAX_BLOCK_SIZE);
+    {
+        BufferChain chain(pool);
+        auto &block = chain.add_block(3000);
+        BOOST_CHECK_EQUAL(block.capacity, 4096u);
+        std::memcpy(block.data, "abc", 3);
+        chain.commit(3);
+        chain.add_block(100);
+        chain.pop_block();
+        BOOST_CHECK_EQUAL(chain.to_string(), "abc");
+        BOOST_CHECK_EQUAL(pool.cached(), 1u);
+    }
+    BOOST_CHECK_EQUAL(pool.cached(), 2u);
+
+    ReadSizer sizer;
+    BOOST_CHECK_EQUAL(sizer.first_block(), BufferPool::MIN_BLOCK_SIZE);
+    sizer.record(20'000);
+    BOOST_CHECK_EQUAL(sizer.first_block(), 32768u);
+    for (int idx = 0; idx < ReadSizer::SHRINK_AFTER_READS - 1; ++idx)
+        sizer.record(100);
+    BOOST_CHECK_EQUAL(sizer.first_block(), 32768u);
+    sizer.record(100);
+    BOOST_CHECK_EQUAL(sizer.first_block(), 16384u);
+    BOOST_CHECK_EQUAL(ReadSizer::next_block(BufferPool::MAX_BLOCK_SIZE), BufferPool::MAX_BLOCK_SIZE);
+}
+
+BOOST_AUTO_TEST_CASE(test_read_chain_drains_the_socket_in_one_callback)
+{
+    IOContext context;
+    const auto [local, remote] = IOContextTests::nonBlockingSocketPair();
+    TCPAsyncSocket socket(context, local);
+
+    std::string sent(100'000, '\0');
+    for (std::size_t idx = 0; idx < sent.size(); ++idx)
+        sent[idx] = static_cast<char>('a' + idx % 26);
+    BOOST_REQUIRE_EQUAL(write(remote, sent.data(), sent.size()), static_cast<ssize_t>(sent.size()));
+
+    std::vector<std::pair<std::error_code, std::string>> results;
+    std::size_t largestChain = 0;
+    const auto record = [&](const std::error_code &error, BufferChain chain)
+    {
+        largestChain = std::max(largestChain, chain.blocks().size());
+        results.emplace_back(error, chain.to_string());
+    };
+
+    // Already there: drained inline, growing blocks.
+    socket.async_read_chain(record);
+    BOOST_REQUIRE_EQUAL(results.size(), 1u);
+    BOOST_CHECK(!results[0].first);
+    BOOST_CHECK(results[0].second == sent);
+    BOOST_CHECK_GT(largestChain, 1u);
+
+    // Nothing there: waits for readiness, then the data and the end of the stream arrive in separate callbacks.
+    socket.async_read_chain([&](const std::error_code &error, BufferChain chain)
+                            {
+        record(error, std::move(chain));
+        socket.async_read_chain(record); });
+    context.post([remote = remote]
+                 {
+        write(remote, "tail", 4);
+        shutdown(remote, SHUT_WR); });
+    context.run();
+    close(remote);
+
+    BOOST_REQUIRE_EQUAL(results.size(), 3u);
+    BOOST_CHECK(!results[1].first);
+    BOOST_CHECK_EQUAL(results[1].second, "tail");
+    BOOST_CHECK(results[2].first == std::errc::connection_reset);
+    BOOST_CHECK(results[2].second.empty());
+    BOOST_CHECK_EQUAL(socket.bytes_read(), sent.size() + 4);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(WriteQueueTests)
+
+BOOST_AUTO_TEST_CASE(test_send_queue_is_bounded_and_applies_backpressure)
+{
+    IOContext context;
+    const auto [local, remote] = IOContextTests::nonBlockingSocketPair();
+    const int sendBuffer = 4096;
+    BOOST_REQUIRE_EQUAL(setsockopt(local, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer)), 0);
+    TCPAsyncSocket sender(context, local);
+    TCPAsyncSocket receiver(context, remote);
+
+    BOOST_CHECK(sender.set_write_limits(32 * 1024, 16 * 1024, 64 * 1024) == std::errc::invalid_argument);
+    BOOST_REQUIRE(!sender.set_write_limits(4 * 1024, 16 * 1024, 64 * 1024));
+    std::vector<bool> pressure;
+    sender.set_write_pressure_handler([&](bool paused)
+                                      { pressure.push_back(paused); });
+
+    // Nobody reads yet: the socket takes a few KiB, the queue holds the rest up to its capacity.
+    std::string expected;
+    std::vector<std::size_t> completed;
+    std::error_code refused;
+    for (std::size_t idx = 0; idx < 32 && !refused; ++idx)
+    {
+        std::vector<char> data(4 * 1024, static_cast<char>('a' + idx));
+        refused = sender.async_send(data, [&completed, idx](const std::error_code &error, size_t bytes)
+                                    {
+            BOOST_CHECK(!error);
+            BOOST_CHECK_EQUAL(bytes, 4 * 1024u);
+            completed.push_back(idx); });
+        if (!refused)
+            expected.append(data.begin(), data.end());
+    }
+    BOOST_CHECK(refused == std::errc::no_buffer_space);
+    BOOST_CHECK_LE(sender.queued_bytes(), 64 * 1024u);
+    BOOST_CHECK(pressure == std::vector<bool>({true}));
+
+    std::string received;
+    std::function<void()> read = [&]
+    {
+        receiver.async_read_chain([&](const std::error_code &error, BufferChain chain)
+                                  {
+            BOOST_REQUIRE(!error);
+            received += chain.to_string();
+            if (received.size() < expected.size())
+                read(); });
+    };
+    read();
+    context.run();
+
+    BOOST_CHECK(received == expected);
+    BOOST_CHECK(pressure == std::vector<bool>({true, false}));
+    BOOST_CHECK_EQUAL(sender.queued_bytes(), 0u);
+    BOOST_CHECK_EQUAL(sender.bytes_written(), expected.size());
+    std::vector<std::size_t> order(completed.size());
+    std::iota(order.begin(), order.end(), 0);
+    BOOST_CHECK(completed == order);
+    BOOST_CHECK_EQUAL(completed.size() * 4 * 1024, expected.size());
+
+    // Whatever is still queued fails on cancellation.
+    std::error_code canceled;
+    BOOST_REQUIRE(!sender.async_send(std::vector<char>(64 * 1024, 'z'), [&](const std::error_code &error, size_t)
+                                     { canceled = error; }));
+    sender.cancel();
+    context.run();
+    BOOST_CHECK(canceled == std::errc::operation_canceled);
+}
+
+BOOST_AUTO_TEST_CASE(test_queue_flush_waits_beside_a_pending_read)
+{
+    IOContext context;
+    const auto [local, remote] = IOContextTests::nonBlockingSocketPair();
+    const int sendBuffer = 4096;
+    BOOST_REQUIRE_EQUAL(setsockopt(local, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer)), 0);
+    TCPAsyncSocket peer(context, local);
+    TCPAsyncSocket receiver(context, remote);
+
+    // The flush waits for writability while the read waits for the reply; it used to replace the read.
+    std::string reply;
+    peer.async_read_chain([&](const std::error_code &error, BufferChain chain)
+                          {
+        BOOST_CHECK(!error);
+        reply = chain.to_string(); });
+
+    const std::size_t total = 64 * 1024;
+    std::error_code sent = std::make_error_code(std::errc::operation_in_progress);
+    BOOST_REQUIRE(!peer.async_send(std::vector<char>(total, 'q'), [&](const std::error_code &error, size_t)
+                                   { sent = error; }));
+    BOOST_CHECK_GT(peer.queued_bytes(), 0u);
+
+    std::size_t received = 0;
+    std::vector<char> answer{'o', 'k'};
+    std::function<void()> read = [&]
+    {
+        receiver.async_read_chain([&](const std::error_code &error, BufferChain chain)
+                                  {
+            BOOST_REQUIRE(!error);
+            received += chain.size();
+            if (received < total)
+                read();
+            else
+                receiver.async_write(answer, [](const std::error_code &, size_t) {}); });
+    };
+    read();
+    context.run();
+
+    BOOST_CHECK(!sent);
+    BOOST_CHECK_EQUAL(received, total);
+    BOOST_CHECK_EQUAL(reply, "ok");
+}
+
+// Used to leave the queue armed forever when the reactor refused its wait because async_write() held the output slot.
+BOOST_AUTO_TEST_CASE(test_queue_fails_when_async_write_holds_the_output)
+{
+    IOContext context;
+    const auto [local, remote] = IOContextTests::nonBlockingSocketPair();
+    const int sendBuffer = 4096;
+    BOOST_REQUIRE_EQUAL(setsockopt(local, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer)), 0);
+
+    std::size_t filled = 0;
+    std::vector<char> chunk(1024, 'f');
+    for (ssize_t written = 0; written >= 0; )
+    {
+        written = ::write(local, chunk.data(), chunk.size());
+        if (written > 0)
+            filled += static_cast<std::size_t>(written);
+    }
+    BOOST_REQUIRE(errno == EAGAIN || errno == EWOULDBLOCK);
+
+    TCPAsyncSocket sender(context, local);
+    TCPAsyncSocket receiver(context, remote);
+
+    bool writeDone = false;
+    std::size_t writeBytes = 0;
+    std::vector<char> pending(1024, 'w');
+    sender.async_write(pending, [&](const std::error_code &error, size_t bytes)
+                       {
+        BOOST_CHECK(!error);
+        writeDone = true;
+        writeBytes = bytes; });
+
+    std::error_code sent;
+    BOOST_REQUIRE(!sender.async_send(std::vector<char>(1024, 's'), [&](const std::error_code &error, size_t)
+                                     { sent = error; }));
+
+    std::size_t received = 0;
+    std::function<void()> read = [&]
+    {
+        receiver.async_read_chain([&](const std::error_code &error, BufferChain chain)
+                                  {
+            BOOST_REQUIRE(!error);
+            received += chain.size();
+            if (!writeDone || received < filled + writeBytes)
+                read(); });
+    };
+    read();
+    context.run();
+
+    BOOST_CHECK(sent == std::errc::device_or_resource_busy);
+    BOOST_CHECK_EQUAL(sender.queued_bytes(), 0u);
+    BOOST_CHECK(writeDone);
+    BOOST_CHECK_EQUAL(received, filled + writeBytes);
+
+    // The queue is usable again once the output slot is free.
+    std::error_code resent = std::make_error_code(std::errc::operation_in_progress);
+    BOOST_REQUIRE(!sender.async_send(std::vector<char>(16, 'r'), [&](const std::error_code &error, size_t)
+                                     { resent = error; }));
+    context.run();
+    BOOST_CHECK(!resent);
+}
+
+// Used to flush the queue of a socket that the read handler of the same event had just destroyed.
+BOOST_AUTO_TEST_CASE(test_socket_destroyed_by_a_completion_of_the_same_event)
+{
+    IOContext context;
+    const auto [local, remote] = IOContextTests::nonBlockingSocketPair();
+    const int sendBuffer = 4096;
+    BOOST_REQUIRE_EQUAL(setsockopt(local, SOL_SOCKET, SO_SNDBUF, &sendBuffer, sizeof(sendBuffer)), 0);
+    auto socket = std::make_unique<TCPAsyncSocket>(context, local);
+
+    std::error_code read = std::make_error_code(std::errc::operation_in_progress);
+    socket->async_read_chain([&](const std::error_code &error, BufferChain)
+                             {
+        read = error;
+        socket.reset(); });
+
+    std::error_code sent;
+    BOOST_REQUIRE(!socket->async_send(std::vector<char>(64 * 1024, 'q'), [&](const std::error_code &error, size_t)
+                                      { sent = error; }));
+    BOOST_REQUIRE_GT(socket->queued_bytes(), 0u);
+
+    // Readable and writable at once: both operations complete from one event, the read first.
+    BOOST_REQUIRE_EQUAL(::write(remote, "x", 1), 1);
+    std::vector<char> sink(64 * 1024);
+    while (::read(remote, sink.data(), sink.size()) > 0)
+    {
+    }
+    context.run();
+
+    BOOST_CHECK(!read);
+    BOOST_CHECK(!socket);
+    BOOST_CHECK(sent == std::errc::operation_canceled);
+    ::close(remote);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(HttpResponseParserTests)
+
+BOOST_AUTO_TEST_CASE(test_content_length_body_split_across_reads)
+{
+    const std::string wire = "HTTP/1.1 200 OK\r\nContent-Length: 11\r\nETag: \"abc\"\r\n\r\nhello world";
+    HttpResponseParser parser;
+
+    for (std::size_t idx = 0; idx + 1 < wire.size(); ++idx)
+    {
+        BOOST_REQUIRE(parser.feed(&wire[idx], 1) == HttpParseStatus::HP_NEED_MORE);
+    }
+    BOOST_REQUIRE(parser.feed(&wire.back(), 1) == HttpParseStatus::HP_COMPLETE);
+
+    BOOST_CHECK_EQUAL(parser.response().statusCode, 200);
+    BOOST_CHECK_EQUAL(parser.response().body, "hello world");
+    BOOST_CHECK_EQUAL(parser.response().header("ETag").value(), "\"abc\"");
+    BOOST_CHECK_EQUAL(parser.body_bytes(), 11u);
+}
+
+BOOST_AUTO_TEST_CASE(test_huge_content_length_reserves_a_bounded_body)
+{
+    // Used to reserve the whole announced length before a single body byte arrived.
+    const std::string head = "HTTP/1.1 200 OK\r\nContent-Length: 1099511627776\r\n\r\n";
+    HttpResponseParser parser;
+
+    BOOST_REQUIRE(parser.feed(head.data(), head.size()) == HttpParseStatus::HP_NEED_MORE);
+    BOOST_CHECK_LE(parser.response().body.capacity(), HttpResponseParser::MAX_BODY_RESERVE);
+    BOOST_REQUIRE(parser.feed("abc", 3) == HttpParseStatus::HP_NEED_MORE);
+    BOOST_CHECK_EQUAL(parser.response().body, "abc");
+}
+
+BOOST_AUTO_TEST_CASE(test_chunked_and_close_delimited_bodies)
+{
+    const std::string chunked = "HTTP/1.1 200 OK\r\nTransfer-Encoding: chunked\r\n\r\n5\r\nhello\r\n6;ext=1\r\n world\r\n0\r\n\r\n";
+    HttpResponseParser chunkedParser;
+    BOOST_REQUIRE(chunkedParser.feed(chunked.data(), chunked.size()) == HttpParseStatus::HP_COMPLETE);
+    BOOST_CHECK_EQUAL(chunkedParser.response().body, "hello world");
+
+    const std::string untilClose = "HTTP/1.0 200 OK\r\nServer: stub\r\n\r\npartial";
+    HttpResponseParser closeParser;
+    BOOST_REQUIRE(closeParser.feed(untilClose.data(), untilClose.size()) == HttpParseStatus::HP_NEED_MORE);
+    BOOST_REQUIRE(closeParser.finish() == HttpParseStatus::HP_COMPLETE);
+    BOOST_CHECK_EQUAL(closeParser.response().body, "partial");
+
+    const std::string notModified = "HTTP/1.1 304 Not Modified\r\nETag: \"abc\"\r\n\r\n";
+    HttpResponseParser notModifiedParser;
+    BOOST_CHECK(notModifiedParser.feed(notModified.data(), notModified.size()) == HttpParseStatus::HP_COMPLETE);
+
+    HttpResponseParser brokenParser;
+    BOOST_CHECK(brokenParser.feed("garbage\r\n", 9) == HttpParseStatus::HP_FAILED);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_daily_rates_with_comma_decimals)
+{
+    const auto table = parseDailyRates("<?xml version=\"1.0\" encoding=\"windows-1251\"?><ValCurs Date=\"06.11.2025\" name=\"Foreign Currency Market\">"
+                                       "<Valute ID=\"R01235\"><NumCode>840</NumCode><CharCode>USD</CharCode><Nominal>1</Nominal><Name>USD</Name><Value>81,1885</Value><VunitRate>81,1885</VunitRate></Valute>"
+                                       "<Valute ID=\"R01335\"><NumCode>398</NumCode><CharCode>KZT</CharCode><Nominal>100</Nominal><Name>KZT</Name><Value>15,4763</Value><VunitRate>0,154763</VunitRate></Valute>"
+                                       "</ValCurs>");
+
+    BOOST_REQUIRE_EQUAL(table.size(), 2u);
+    BOOST_CHECK_CLOSE(table.at("USD").Value, 81.1885f, 1e-4);
+    BOOST_CHECK_EQUAL(table.at("KZT").Nominal, 100);
+    BOOST_CHECK_CLOSE(table.at("KZT").VunitRate, 0.154763f, 1e-4);
+    BOOST_CHECK_THROW(static_cast<void>(parseDailyRates("<ValCurs><Valute>")), std::runtime_error);
+}
+
+BOOST_AUTO_TEST_CASE(test_parse_http_request_head)
+{
+    const std::string head = "GET /cross/USD/EUR HTTP/1.1\r\nHost: localhost\r\nConnection: Close";
+    HttpRequest request;
+    BOOST_REQUIRE(parseHttpRequestHead(head.data(), head.data() + head.size(), request));
+    BOOST_CHECK_EQUAL(request.method, "GET");
+    BOOST_CHECK_EQUAL(request.target, "/cross/USD/EUR");
+    BOOST_CHECK_EQUAL(request.header("host").value(), "localhost");
+    BOOST_CHECK(!request.keep_alive());
+
+    const std::string legacy = "GET /rates HTTP/1.0\r\nConnection: keep-alive";
+    BOOST_REQUIRE(parseHttpRequestHead(legacy.data(), legacy.data() + legacy.size(), request));
+    BOOST_CHECK_EQUAL(request.versionMinor, 0);
+    BOOST_CHECK(request.keep_alive());
+
+    const std::string broken = "GET /rates\r\nHost: localhost";
+    BOOST_CHECK(!parseHttpRequestHead(broken.data(), broken.data() + broken.size(), request));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(ContentDecoderTests)
+
+static std::string compressText(const std::string &text, int windowBits)
+{
+    z_stream stream{};
+    deflateInit2(&stream, Z_BEST_COMPRESSION, Z_DEFLATED, windowBits, 8, Z_DEFAULT_STRATEGY);
+    std::string output(deflateBound(&stream, text.size()), '\0');
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(text.data()));
+    stream.avail_in = static_cast<uInt>(text.size());
+    stream.next_out = reinterpret_cast<Bytef *>(&output[0]);
+    stream.avail_out = static_cast<uInt>(output.size());
+    deflate(&stream, Z_FINISH);
+    output.resize(stream.total_out);
+    deflateEnd(&stream);
+    return output;
+}
+
+static std::string repeatedDocument()
+{
+    std::string document;
+    for (int idx = 0; idx < 5'000; ++idx)
+    {
+        document += "<Record Date=\"" + std::to_string(idx) + "\"><Nominal>1</Nominal><Value>80,1234</Value></Record>";
+    }
+    return document;
+}
+
+BOOST_AUTO_TEST_CASE(test_gzip_and_deflate_streams_decode_in_pieces)
+{
+    const auto document = repeatedDocument();
+
+    for (const int windowBits : {15 + 16, 15, -15})
+    {
+        const auto compressed = compressText(document, windowBits);
+        BOOST_REQUIRE_LT(compressed.size(), document.size() / 10);
+
+        std::string decoded;
+        std::size_t largestPiece = 0;
+        ContentDecoder decoder(windowBits > 15 ? ContentEncoding::GZIP : ContentEncoding::DEFLATE, [&](const char *data, std::size_t size)
+                               {
+            largestPiece = std::max(largestPiece, size);
+            decoded.append(data, size); });
+
+        for (std::size_t offset = 0; offset < compressed.size(); offset += 7)
+        {
+            BOOST_REQUIRE(decoder.write(compressed.data() + offset, std::min<std::size_t>(7, compressed.size() - offset)));
+        }
+
+        BOOST_CHECK(decoder.finish());
+        BOOST_CHECK(decoded == document);
+        BOOST_CHECK_LE(largestPiece, ContentDecoder::OUTPUT_CHUNK_SIZE);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_truncated_and_corrupt_streams_are_rejected)
+{
+    const auto compressed = compressText(repeatedDocument(), 15 + 16);
+
+    ContentDecoder truncated(ContentEncoding::GZIP, [](const char *, std::size_t) {});
+    BOOST_REQUIRE(truncated.write(compressed.data(), compressed.size() / 2));
+    BOOST_CHECK(!truncated.finish());
+
+    ContentDecoder corrupt(ContentEncoding::GZIP, [](const char *, std::size_t) {});
+    BOOST_CHECK(!corrupt.write("definitely not gzip", 19));
+
+    BOOST_CHECK(parseContentEncoding("GZIP").value() == ContentEncoding::GZIP);
+    BOOST_CHECK(!parseContentEncoding("br").has_value());
+}
+
+// Used to check that a raw deflate stream whose first byte happens to look like a zlib compression method is not
+// mistaken for a zlib header, even when that byte arrives on its own.
+BOOST_AUTO_TEST_CASE(test_raw_deflate_with_a_zlib_like_first_byte)
+{
+    // A non-final stored block whose padding bits make the first byte 0x08, then an empty final stored block.
+    const std::string stream("\x08\x05\x00\xFA\xFF" "hello" "\x01\x00\x00\xFF\xFF", 15);
+
+    for (const std::size_t firstWrite : {stream.size(), std::size_t{1}})
+    {
+        std::string decoded;
+        ContentDecoder decoder(ContentEncoding::DEFLATE, [&decoded](const char *data, std::size_t size)
+                               { decoded.append(data, size); });
+
+        BOOST_REQUIRE(decoder.write(stream.data(), firstWrite));
+        if (firstWrite == 1)
+            BOOST_CHECK(!decoder.finish());
+        BOOST_REQUIRE(decoder.write(stream.data() + firstWrite, stream.size() - firstWrite));
+        BOOST_CHECK(decoder.finish());
+        BOOST_CHECK_EQUAL(decoded, "hello");
+    }
+}
+
+// Used to check that a buffered body which inflates past the cap fails the response.
+BOOST_AUTO_TEST_CASE(test_parser_caps_the_buffered_decoded_body)
+{
+    const auto compressed = compressText(std::string(1024 * 1024, '\0'), 15 + 16);
+    BOOST_REQUIRE_LT(compressed.size(), 4096u);
+    const auto wire = "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nContent-Length: " + std::to_string(compressed.size()) + "\r\n\r\n" + compressed;
+
+    HttpResponseParser capped;
+    capped.set_max_decoded_body_size(64 * 1024);
+    BOOST_CHECK(capped.feed(wire.data(), wire.size()) == HttpParseStatus::HP_FAILED);
+    BOOST_CHECK_LE(capped.response().body.size(), 64u * 1024);
+
+    HttpResponseParser uncapped;
+    BOOST_REQUIRE(uncapped.feed(wire.data(), wire.size()) == HttpParseStatus::HP_COMPLETE);
+    BOOST_CHECK_EQUAL(uncapped.response().body.size(), 1024u * 1024);
+
+    ContentDecoder decoder(ContentEncoding::GZIP, [](const char *, std::size_t) {}, 1000);
+    BOOST_CHECK(!decoder.write(compressed.data(), compressed.size()));
+    BOOST_CHECK_LE(decoder.decoded_bytes(), 1000u);
+}
+
+BOOST_AUTO_TEST_CASE(test_parser_inflates_chunked_gzip_body)
+{
+    const auto document = repeatedDocument();
+    const auto compressed = compressText(document, 15 + 16);
+
+    std::string wire = "HTTP/1.1 200 OK\r\nContent-Encoding: gzip\r\nTransfer-Encoding: chunked\r\n\r\n";
+    for (std::size_t offset = 0; offset < compressed.size(); offset += 1000)
+    {
+        const auto size = std::min<std::size_t>(1000, compressed.size() - offset);
+        std::stringstream chunkSize;
+        chunkSize << std::hex << size;
+        wire += chunkSize.str() + "\r\n" + compressed.substr(offset, size) + "\r\n";
+    }
+    wire += "0\r\n\r\n";
+
+    HttpResponseParser parser;
+    std::string streamed;
+    parser.set_body_handler([&streamed](const char *data, std::size_t size)
+                            { streamed.append(data, size); });
+
+    HttpParseStatus status = HttpParseStatus::HP_NEED_MORE;
+    for (std::size_t offset = 0; offset < wire.size(); offset += 512)
+    {
+        status = parser.feed(wire.data() + offset, std::min<std::size_t>(512, wire.size() - offset));
+    }
+
+    BOOST_REQUIRE(status == HttpParseStatus::HP_COMPLETE);
+    BOOST_CHECK(parser.content_encoding() == ContentEncoding::GZIP);
+    BOOST_CHECK(parser.response().body.empty());
+    BOOST_CHECK(streamed == document);
+    BOOST_CHECK_EQUAL(parser.body_bytes(), compressed.size());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+
+BOOST_AUTO_TEST_SUITE(DynamicRatesParserTests)
+
+static const std::string DYNAMIC_DOCUMENT =
+    "<?xml version=\"1.0\" encoding=\"windows-1251\"?>\r\n"
+    "<ValCurs ID=\"R01235\" DateRange1=\"02.03.2001\" DateRange2=\"06.03.2001\" name=\"Foreign Currency Market Dynamic\">"
+    "<Record Date=\"02.03.2001\" Id=\"R01235\"><Nominal>1</Nominal><Value>28,6200</Value><VunitRate>28,62</VunitRate></Record>"
+    "<Record Date=\"03.03.2001\" Id=\"R01235\"><Nominal>1</Nominal><Value> 28,6600 </Value></Record>"
+    "<Record Date=\"06.03.2001\" Id=\"R01235\">\r\n  <Nominal>1</Nominal>\r\n  <Value>28,7100</Value>\r\n</Record>"
+    "</ValCurs>";
+
+BOOST_AUTO_TEST_CASE(test_records_stream_out_for_any_chunking)
+{
+    for (const std::size_t chunk : {std::size_t(1), std::size_t(3), std::size_t(17), DYNAMIC_DOCUMENT.size()})
+    {
+        rates_history_type history;
+        DynamicRatesParser parser([&history](DatedValute &&record)
+                                  { history.push_back(std::move(record)); });
+
+        for (std::size_t offset = 0; offset < DYNAMIC_DOCUMENT.size(); offset += chunk)
+        {
+            BOOST_REQUIRE(parser.feed(DYNAMIC_DOCUMENT.data() + offset, std::min(chunk, DYNAMIC_DOCUMENT.size() - offset)));
+        }
+
+        BOOST_CHECK(parser.finish());
+        BOOST_REQUIRE_EQUAL(history.size(), 3u);
+        BOOST_CHECK_EQUAL(history[0].day, dayFromCivil(2001, 3, 2));
+        BOOST_CHECK_EQUAL(history[0].valute.ID, "R01235");
+        BOOST_CHECK_CLOSE(history[0].valute.Value, 28.62f, 1e-4);
+        BOOST_CHECK_CLOSE(history[1].valute.VunitRate, 28.66f, 1e-4);
+        BOOST_CHECK_EQUAL(history[2].day, dayFromCivil(2001, 3, 6));
+        BOOST_CHECK_CLOSE(history[2].valute.Value, 28.71f, 1e-4);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(test_malformed_and_truncated_documents)
+{
+    std::size_t records = 0;
+    DynamicRatesParser truncated([&records](DatedValute &&)
+                                 { ++records; });
+    BOOST_REQUIRE(truncated.feed(DYNAMIC_DOCUMENT.data(), DYNAMIC_DOCUMENT.size() / 2));
+    BOOST_CHECK(!truncated.finish());
+
+    const std::string missingDate = "<ValCurs><Record Id=\"R01235\"><Nominal>1</Nominal><Value>1,0</Value></Record></ValCurs>";
+    DynamicRatesParser malformed([](DatedValute &&) {});
+    BOOST_CHECK(!malformed.feed(missingDate.data(), missingDate.size()));
+    BOOST_CHECK(!malformed.finish());
+
+    DynamicRatesParser wrongRoot([](DatedValute &&) {});
+    BOOST_CHECK(!wrongRoot.feed("<html><body/></html>", 20));
+}
+
+BOOST_AUTO_TEST_SUITE_END()